@@ -0,0 +1,61 @@
+#include "bench_data.hpp"
+
+#include "../sim/parser.hpp"
+#include "../sim/simulation.hpp"
+
+#include <array>
+#include <cstdint>
+#include <filesystem>
+
+namespace {
+  std::array<std::string, 2> const inputFiles = {"small.fld", "large.fld"};
+}  // namespace
+
+void sampleArguments(benchmark::internal::Benchmark *bench) {
+  bench->ArgNames({"file", "particles"});
+  // small.fld has 4800 particles and large.fld 15138
+  for (int const count : {1000, 2400, 4800}) { bench->Args({0, count}); }
+  for (int const count : {1000, 4800, 15138}) { bench->Args({1, count}); }
+}
+
+std::string sampleInput(benchmark::State const &state) {
+  return inputFiles.at(static_cast<std::size_t>(state.range(0)));
+}
+
+Grid sampleGrid(std::string const &inputfile, int count) {
+  Grid const input = readInput(inputfile);
+  ParticleStore const &particles = input.get_particles();
+  Grid grid(input.get_ppm(), count);
+  for (int i = 0; i < count; i++) {
+    auto const part = static_cast<std::int64_t>(i) * particles.size() / count;
+    Particle const particle = particles.getParticle(static_cast<int>(part));
+    // The output is laid out by id, so the ids of the subset are 0..count-1
+    grid.add_particle_to_block(Particle(i, particle.get_position(), particle.get_hv(),
+                                        particle.get_velocity()));
+  }
+  grid.set_count(count);
+  grid.repositionParticles();
+  return grid;
+}
+
+Grid sampleGrid(benchmark::State &state) {
+  Grid grid = sampleGrid(sampleInput(state), static_cast<int>(state.range(1)));
+  initAccelerations(grid);
+  incrementDensities(grid, PairMode::symmetric);
+  transformDensities(grid);
+  transferAccelerations(grid, PairMode::symmetric);
+  return grid;
+}
+
+std::string sampleFile(benchmark::State &state) {
+  std::filesystem::path const input(sampleInput(state));
+  std::string const name = (std::filesystem::temp_directory_path() /
+                            (input.stem().string() + "-" + std::to_string(state.range(1)) +
+                             ".fld")).string();
+  writeOutput(name, sampleGrid(sampleInput(state), static_cast<int>(state.range(1))));
+  return name;
+}
+
+void setParticlesProcessed(benchmark::State &state, int count) {
+  state.SetItemsProcessed(state.iterations() * count);
+}
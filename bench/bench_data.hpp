@@ -0,0 +1,36 @@
+#ifndef FLUID_BENCH_DATA_HPP
+#define FLUID_BENCH_DATA_HPP
+
+#include "../sim/grid.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+// Inputs of the benchmarks: an evenly spread subset of the particles of
+// small.fld (range(0) == 0) or large.fld (range(0) == 1), which have
+// different particles per metre and so different smoothing lengths and
+// grids, with range(1) particles
+
+// Register the (file, particles) pairs every benchmark runs over
+void sampleArguments(benchmark::internal::Benchmark *bench);
+
+// Input file selected by range(0)
+[[nodiscard]] std::string sampleInput(benchmark::State const &state);
+
+// Grid with count particles of inputfile, taken at even strides of the
+// repositioned particles so the subset covers the whole box
+[[nodiscard]] Grid sampleGrid(std::string const &inputfile, int count);
+
+// Grid of the pair selected by state, with an initial step run up to the
+// acceleration transfer so every stage sees valid densities
+[[nodiscard]] Grid sampleGrid(benchmark::State &state);
+
+// Write the grid of the pair selected by state to a temporary .fld file
+// and return its name
+[[nodiscard]] std::string sampleFile(benchmark::State &state);
+
+// Report the particles processed per second, count per iteration
+void setParticlesProcessed(benchmark::State &state, int count);
+
+#endif  // FLUID_BENCH_DATA_HPP
@@ -0,0 +1,106 @@
+#include "bench_data.hpp"
+
+#include "../sim/block.hpp"
+
+namespace {
+  // Run function on every particle of every block, as the gather stages do
+  template <typename Function>
+  void forEachBlockParticle(Grid &grid, Function function) {
+    for (Block const &block : grid.get_blocks()) {
+      for (int part = block.get_begin(); part < block.get_end(); part++) {
+        function(block, part);
+      }
+    }
+  }
+
+  // Run function on every particle of the store
+  template <typename Function>
+  void benchmarkParticles(benchmark::State &state, Function function) {
+    Grid grid = sampleGrid(state);
+    ParticleStore &store = grid.get_particles();
+    for (auto _ : state) {
+      for (int part = 0; part < store.size(); part++) { function(store, part); }
+      benchmark::ClobberMemory();
+    }
+    setParticlesProcessed(state, store.size());
+  }
+}  // namespace
+
+static void BM_BlockIncDensity(benchmark::State &state) {
+  Grid grid = sampleGrid(state);
+  ParticleStore &store = grid.get_particles();
+  double const slSq = grid.get_slSq();
+
+  for (auto _ : state) {
+    forEachBlockParticle(grid, [&store, slSq](Block const &block, int part) {
+      block.incDensity(store, part, slSq);
+    });
+    benchmark::ClobberMemory();
+  }
+  setParticlesProcessed(state, store.size());
+}
+BENCHMARK(BM_BlockIncDensity)->Apply(sampleArguments);
+
+static void BM_BlockIncDensityPairs(benchmark::State &state) {
+  Grid grid = sampleGrid(state);
+  ParticleStore &store = grid.get_particles();
+  double const slSq = grid.get_slSq();
+
+  for (auto _ : state) {
+    for (Block const &block : grid.get_blocks()) { block.incDensityPairs(store, slSq); }
+    benchmark::ClobberMemory();
+  }
+  setParticlesProcessed(state, store.size());
+}
+BENCHMARK(BM_BlockIncDensityPairs)->Apply(sampleArguments);
+
+static void BM_BlockAccelerationTransfer(benchmark::State &state) {
+  Grid grid = sampleGrid(state);
+  ParticleStore &store = grid.get_particles();
+  KernelConstants const constants = grid.get_kernelConstants();
+
+  for (auto _ : state) {
+    forEachBlockParticle(grid, [&store, &constants](Block const &block, int part) {
+      block.accelerationTransfer(store, part, constants);
+    });
+    benchmark::ClobberMemory();
+  }
+  setParticlesProcessed(state, store.size());
+}
+BENCHMARK(BM_BlockAccelerationTransfer)->Apply(sampleArguments);
+
+static void BM_BlockAccelerationTransferPairs(benchmark::State &state) {
+  Grid grid = sampleGrid(state);
+  ParticleStore &store = grid.get_particles();
+  KernelConstants const constants = grid.get_kernelConstants();
+
+  for (auto _ : state) {
+    for (Block const &block : grid.get_blocks()) {
+      block.accelerationTransferPairs(store, constants);
+    }
+    benchmark::ClobberMemory();
+  }
+  setParticlesProcessed(state, store.size());
+}
+BENCHMARK(BM_BlockAccelerationTransferPairs)->Apply(sampleArguments);
+
+static void BM_BlockBoxCollisions(benchmark::State &state) {
+  benchmarkParticles(state, [](ParticleStore &store, int part) {
+    Block::boxCollisions(store, part);
+  });
+}
+BENCHMARK(BM_BlockBoxCollisions)->Apply(sampleArguments);
+
+static void BM_BlockParticleMotion(benchmark::State &state) {
+  benchmarkParticles(state, [](ParticleStore &store, int part) {
+    Block::particleMotion(store, part);
+  });
+}
+BENCHMARK(BM_BlockParticleMotion)->Apply(sampleArguments);
+
+static void BM_BlockBoundaryCollisions(benchmark::State &state) {
+  benchmarkParticles(state, [](ParticleStore &store, int part) {
+    Block::boundaryCollisions(store, part);
+  });
+}
+BENCHMARK(BM_BlockBoundaryCollisions)->Apply(sampleArguments);
@@ -0,0 +1,63 @@
+#include "bench_data.hpp"
+
+#include <vector>
+
+// Block of every particle, from a Particle as the reader used to place them
+static void BM_GridFindBlock(benchmark::State &state) {
+  Grid const grid = sampleGrid(state);
+  ParticleStore const &store = grid.get_particles();
+  std::vector<Particle> particles;
+  particles.reserve(static_cast<std::size_t>(store.size()));
+  for (int part = 0; part < store.size(); part++) { particles.push_back(store.getParticle(part)); }
+
+  for (auto _ : state) {
+    for (Particle const &particle : particles) {
+      benchmark::DoNotOptimize(grid.findBlock(particle));
+    }
+  }
+  setParticlesProcessed(state, store.size());
+}
+BENCHMARK(BM_GridFindBlock)->Apply(sampleArguments);
+
+// Block of every particle of the store, as repositioning finds them
+static void BM_GridFindBlockIndex(benchmark::State &state) {
+  Grid const grid = sampleGrid(state);
+  int const count = grid.get_particles().size();
+
+  for (auto _ : state) {
+    for (int part = 0; part < count; part++) {
+      benchmark::DoNotOptimize(grid.findBlockIndex(part));
+    }
+  }
+  setParticlesProcessed(state, count);
+}
+BENCHMARK(BM_GridFindBlockIndex)->Apply(sampleArguments);
+
+// Adding every particle to an emptied grid
+static void BM_GridAddParticleToBlock(benchmark::State &state) {
+  Grid grid = sampleGrid(state);
+  ParticleStore &store = grid.get_particles();
+  std::vector<Particle> particles;
+  particles.reserve(static_cast<std::size_t>(store.size()));
+  for (int part = 0; part < store.size(); part++) { particles.push_back(store.getParticle(part)); }
+
+  for (auto _ : state) {
+    store.clear();
+    for (Particle const &particle : particles) { grid.add_particle_to_block(particle); }
+    benchmark::ClobberMemory();
+  }
+  setParticlesProcessed(state, static_cast<int>(particles.size()));
+}
+BENCHMARK(BM_GridAddParticleToBlock)->Apply(sampleArguments);
+
+// Sorting the particles into their blocks
+static void BM_GridRepositionParticles(benchmark::State &state) {
+  Grid grid = sampleGrid(state);
+
+  for (auto _ : state) {
+    grid.repositionParticles();
+    benchmark::ClobberMemory();
+  }
+  setParticlesProcessed(state, grid.get_particles().size());
+}
+BENCHMARK(BM_GridRepositionParticles)->Apply(sampleArguments);
@@ -0,0 +1,44 @@
+#include "bench_data.hpp"
+
+#include "../sim/parser.hpp"
+
+#include <filesystem>
+
+static void BM_ReadInput(benchmark::State &state) {
+  std::string const inputfile = sampleFile(state);
+
+  for (auto _ : state) {
+    Grid grid = readInput(inputfile);
+    benchmark::DoNotOptimize(grid);
+  }
+  setParticlesProcessed(state, static_cast<int>(state.range(1)));
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(std::filesystem::file_size(inputfile)));
+  std::filesystem::remove(inputfile);
+}
+BENCHMARK(BM_ReadInput)->Apply(sampleArguments);
+
+static void BM_WriteOutput(benchmark::State &state) {
+  Grid const grid = sampleGrid(state);
+  std::string const outputfile = sampleFile(state);
+
+  for (auto _ : state) { writeOutput(outputfile, grid); }
+  setParticlesProcessed(state, grid.get_particles().size());
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(std::filesystem::file_size(outputfile)));
+  std::filesystem::remove(outputfile);
+}
+BENCHMARK(BM_WriteOutput)->Apply(sampleArguments);
+
+// Encoding alone, without the file system
+static void BM_EncodeOutput(benchmark::State &state) {
+  Grid const grid = sampleGrid(state);
+  std::vector<std::byte> buffer;
+
+  for (auto _ : state) {
+    encodeOutput(grid, buffer);
+    benchmark::DoNotOptimize(buffer.data());
+  }
+  setParticlesProcessed(state, grid.get_particles().size());
+}
+BENCHMARK(BM_EncodeOutput)->Apply(sampleArguments);
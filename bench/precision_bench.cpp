@@ -0,0 +1,58 @@
+#include "bench_data.hpp"
+
+#include "../sim/block.hpp"
+#include "../sim/simd_kernels.hpp"
+
+namespace {
+  // Copy of the particles of the grid in the arrays of another policy, in
+  // the same order so the ranges of the blocks still apply
+  template <typename Policy>
+  BasicParticleStore<Policy> convertStore(Grid const &grid) {
+    ParticleStore const &store = grid.get_particles();
+    BasicParticleStore<Policy> converted;
+    converted.reserve(store.size());
+    for (int part = 0; part < store.size(); part++) {
+      converted.addParticle(store.getParticle(part));
+    }
+    return converted;
+  }
+}  // namespace
+
+// Scalar density rows of every particle against its adjacent blocks, with
+// the arrays and sums of each precision policy
+template <typename Policy>
+static void BM_PrecisionDensityRows(benchmark::State &state) {
+  Grid const grid = sampleGrid(state);
+  BasicParticleStore<Policy> store = convertStore<Policy>(grid);
+  double const slSq = grid.get_slSq();
+  std::vector<Block> const &blocks = grid.get_blocks();
+
+  for (auto _ : state) {
+    for (Block const &block : blocks) {
+      for (int part = block.get_begin(); part < block.get_end(); part++) {
+        simd::incDensityRowScalar(store, {part, part + 1, block.get_end()}, slSq, true);
+      }
+    }
+    benchmark::ClobberMemory();
+  }
+  setParticlesProcessed(state, store.size());
+}
+BENCHMARK_TEMPLATE(BM_PrecisionDensityRows, MixedPrecision)->Apply(sampleArguments);
+BENCHMARK_TEMPLATE(BM_PrecisionDensityRows, DoublePrecision)->Apply(sampleArguments);
+BENCHMARK_TEMPLATE(BM_PrecisionDensityRows, FloatPrecision)->Apply(sampleArguments);
+
+// Motion of every particle with the arrays of each precision policy
+template <typename Policy>
+static void BM_PrecisionParticleMotion(benchmark::State &state) {
+  Grid const grid = sampleGrid(state);
+  BasicParticleStore<Policy> store = convertStore<Policy>(grid);
+
+  for (auto _ : state) {
+    for (int part = 0; part < store.size(); part++) { Block::particleMotion(store, part); }
+    benchmark::ClobberMemory();
+  }
+  setParticlesProcessed(state, store.size());
+}
+BENCHMARK_TEMPLATE(BM_PrecisionParticleMotion, MixedPrecision)->Apply(sampleArguments);
+BENCHMARK_TEMPLATE(BM_PrecisionParticleMotion, DoublePrecision)->Apply(sampleArguments);
+BENCHMARK_TEMPLATE(BM_PrecisionParticleMotion, FloatPrecision)->Apply(sampleArguments);
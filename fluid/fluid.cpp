@@ -6,9 +6,10 @@
 
 int main(int argc, char **argv) {
   // arguments
-  std::array<char *, 4> args = {argv[0], argv[1], argv[2], argv[3]};
-  if (progargs(argc, args) == 0) {
-    parser(args);
+  std::span const args(argv, static_cast<std::size_t>(argc));
+  ProgramOptions options;
+  if (parseOptions(args, options) == 0) {
+    parser(options);
   }
 
   return 0;
@@ -0,0 +1,81 @@
+#include "async_writer.hpp"
+
+#include <utility>
+
+AsyncWriter::AsyncWriter() : writer([this] { writerLoop(); }) { }
+
+AsyncWriter::~AsyncWriter() {
+  {
+    std::lock_guard const lock(mutex);
+    stopping = true;
+  }
+  entryQueued.notify_all();
+  writer.join();
+}
+
+std::vector<std::byte> &AsyncWriter::acquire() {
+  // Back-pressure: a buffer is reused only once its sink has run
+  std::unique_lock lock(mutex);
+  if (queued[next]) {
+    waits++;
+    bufferFreed.wait(lock, [this] { return not queued[next]; });
+  }
+  // The writer only touches queued buffers, so this one is the caller's
+  return buffers[next];
+}
+
+void AsyncWriter::queue(Sink sink) {
+  {
+    std::lock_guard const lock(mutex);
+    queued[next] = true;
+    entries.push_back({next, std::move(sink)});
+    next = 1 - next;
+  }
+  entryQueued.notify_one();
+}
+
+void AsyncWriter::finish() {
+  std::unique_lock lock(mutex);
+  bufferFreed.wait(lock, [this] { return entries.empty() and not queued[0] and not queued[1]; });
+  if (error) { std::rethrow_exception(std::exchange(error, nullptr)); }
+}
+
+std::int64_t AsyncWriter::get_written() const {
+  std::lock_guard const lock(mutex);
+  return written;
+}
+
+std::int64_t AsyncWriter::get_waits() const {
+  std::lock_guard const lock(mutex);
+  return waits;
+}
+
+// Run queued sinks in order; after an error the remaining buffers are
+// dropped and the error is kept for finish
+void AsyncWriter::writerLoop() {
+  std::unique_lock lock(mutex);
+  while (true) {
+    entryQueued.wait(lock, [this] { return stopping or not entries.empty(); });
+    if (entries.empty()) { return; }
+    Entry const entry = std::move(entries.front());
+    entries.pop_front();
+    bool const failed = static_cast<bool>(error);
+    lock.unlock();
+    std::exception_ptr failure;
+    if (not failed) {
+      try {
+        entry.sink(buffers[entry.buffer]);
+      } catch (...) {
+        failure = std::current_exception();
+      }
+    }
+    lock.lock();
+    if (failure) {
+      error = failure;
+    } else if (not error) {
+      written++;
+    }
+    queued[entry.buffer] = false;
+    bufferFreed.notify_all();
+  }
+}
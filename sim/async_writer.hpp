@@ -0,0 +1,70 @@
+#ifndef FLUID_ASYNC_WRITER_HPP
+#define FLUID_ASYNC_WRITER_HPP
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+// Double-buffered background writer. The caller fills the buffer returned
+// by acquire and queues it with the sink that consumes it (writes it to a
+// file, compresses it, ...); the writer thread runs the sinks in order
+// while the caller goes on. When both buffers are still queued, acquire
+// waits for the writer to free one, so a slow sink slows the caller down
+// instead of piling up buffers in memory
+class AsyncWriter {
+public:
+  using Sink = std::function<void(std::span<std::byte const> bytes)>;
+
+  AsyncWriter();
+  ~AsyncWriter();
+
+  AsyncWriter(const AsyncWriter &) = delete;
+  AsyncWriter &operator=(const AsyncWriter &) = delete;
+  AsyncWriter(AsyncWriter &&) = delete;
+  AsyncWriter &operator=(AsyncWriter &&) = delete;
+
+  // Wait for a free buffer and return it to be filled
+  [[nodiscard]] std::vector<std::byte> &acquire();
+
+  // Queue the buffer of the last acquire to be passed to sink
+  void queue(Sink sink);
+
+  // Wait until every queued buffer went through its sink. Throws the first
+  // exception of a sink; the buffers queued after it are dropped
+  void finish();
+
+  // Buffers consumed without error, and acquires that had to wait
+  [[nodiscard]] std::int64_t get_written() const;
+  [[nodiscard]] std::int64_t get_waits() const;
+
+private:
+  struct Entry {
+    std::size_t buffer;
+    Sink sink;
+  };
+
+  void writerLoop();
+
+  std::array<std::vector<std::byte>, 2> buffers;
+  std::array<bool, 2> queued{};
+  std::size_t next{};
+  std::deque<Entry> entries;
+  std::int64_t written{};
+  std::int64_t waits{};
+  std::exception_ptr error;
+  bool stopping{};
+  mutable std::mutex mutex;
+  std::condition_variable entryQueued;
+  std::condition_variable bufferFreed;
+  std::thread writer;
+};
+
+#endif  // FLUID_ASYNC_WRITER_HPP
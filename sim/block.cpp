@@ -1,192 +1,308 @@
 #include "block.hpp"
+#include "neighbour_stencil.hpp"
+#include "profiler.hpp"
+#include "simd_kernels.hpp"
+#include <array>
 #include <cmath>
+#include <utility>
 
 // Constructor for the Block class
 Block::Block(std::vector<int> blockIndex)
-    : particles({}), adjBlocks({}), index(std::move(blockIndex)) {}
+    : index{blockIndex.at(0), blockIndex.at(1), blockIndex.at(2)} {}
 
-// Return a vector of all particles that belong to a specific block
-std::vector<Particle> Block::getParticles() { return particles; }
+// Range of the block's particles in the particle store
+int Block::get_begin() const { return begin; }
+int Block::get_end() const { return end; }
+int Block::size() const { return end - begin; }
+void Block::setRange(int newBegin, int newEnd) {
+  begin = newBegin;
+  end = newEnd;
+}
 
 // Return the block's index
-std::vector<int> Block::get_index() const { return index; }
+std::array<int, 3> Block::get_index() const { return index; }
 
-// Add a particle to the vector of all particles belonging to a specific block
-void Block::addParticle(const Particle &part) { particles.emplace_back(part); }
+void Block::setNeighbours(std::span<int const> offsets, std::uint32_t slots) {
+  neighbourOffsets = offsets;
+  neighbourSlots = slots;
+}
 
-// Add an adjacent block to the block's adjacent block vector
-void Block::addAdjacentBlock(const Block &adjBlock) {
-  adjBlocks.emplace_back(adjBlock);
+namespace {
+  // Squared distance between two particles
+  double squaredDistance(ParticleStore const &store, std::size_t iIdx, std::size_t jIdx) {
+    double const xDiff = static_cast<double>(store.px[iIdx]) - store.px[jIdx];
+    double const yDiff = static_cast<double>(store.py[iIdx]) - store.py[jIdx];
+    double const zDiff = static_cast<double>(store.pz[iIdx]) - store.pz[jIdx];
+    return xDiff * xDiff + yDiff * yDiff + zDiff * zDiff;
+  }
+}  // namespace
+
+// Density starts at zero and acceleration at the external acceleration
+template <typename Policy, typename Config>
+void Block::initAcceleration(BasicParticleStore<Policy> &store, int part,
+                             Config const &config) {
+  using Accumulator = typename Policy::Accumulator;
+  auto const &external = config.get().externalAcceleration;
+  auto const idx = static_cast<std::size_t>(part);
+  store.density[idx] = 0.0;
+  store.ax[idx] = static_cast<Accumulator>(external[0]);
+  store.ay[idx] = static_cast<Accumulator>(external[1]);
+  store.az[idx] = static_cast<Accumulator>(external[2]);
 }
 
-// Increasing density between a given particle and every particle in the
-// adjacent blocks
-void Block::incDensity(Particle &part, double slSq, double slSixth,
-                       double densTransConstant) {
-  auto px1 = part.get_px();
-  auto py1 = part.get_py();
-  auto pz1 = part.get_pz();
-
-  for (auto &blk : adjBlocks) {
-    auto adjParts = blk.getParticles();
-    for (const auto &adjPart : adjParts) {
-      auto px2 = adjPart.get_px();
-      auto py2 = adjPart.get_py();
-      auto pz2 = adjPart.get_pz();
-      auto xDiffSq = pow((px1 - px2), 2);
-      auto yDiffSq = pow((py1 - py2), 2);
-      auto zDiffSq = pow((pz1 - pz2), 2);
-      auto diffSum = xDiffSq + yDiffSq + zDiffSq;
-
-      if (diffSum < slSq) {
-        double const densityChange = pow((slSq - diffSum), 3);
-        double const newDensity = part.get_density() + densityChange;
-        double const densTransformation =
-            (newDensity + slSixth) * densTransConstant;
-        part.set_density(densTransformation);
-      }
+// Increasing density between a given particle and every other particle in
+// the adjacent blocks
+void Block::incDensity(ParticleStore &store, int part, double slSq) const {
+  forEachNeighbour(neighbourSlots, [&store, part, slSq](Block const &blk) {
+    if (part >= blk.get_begin() && part < blk.get_end()) {
+      simd::incDensityRow(store, {part, blk.get_begin(), part}, slSq, false);
+      simd::incDensityRow(store, {part, part + 1, blk.get_end()}, slSq, false);
+    } else {
+      simd::incDensityRow(store, {part, blk.get_begin(), blk.get_end()}, slSq, false);
     }
+  });
+}
+
+// Increasing density of every pair once: pairs inside the block, then pairs
+// with each forward block
+void Block::incDensityPairs(ParticleStore &store, double slSq) const {
+  for (int part = begin; part < end; part++) {
+    simd::incDensityRow(store, {part, part + 1, end}, slSq, true);
+    forEachNeighbour(neighbourSlots & NeighbourStencil::forwardSlots,
+                     [&store, part, slSq](Block const &blk) {
+      simd::incDensityRow(store, {part, blk.get_begin(), blk.get_end()}, slSq, true);
+    });
   }
 }
 
-// Formula to calculate the distance between two given particles
-double Block::findDistance(const Particle &iPart, const Particle &jPart) {
-  float const ipx = iPart.get_px();
-  float const ipy = iPart.get_py();
-  float const ipz = iPart.get_pz();
-  float const jpx = jPart.get_px();
-  float const jpy = jPart.get_py();
-  float const jpz = jPart.get_pz();
-
-  auto xDiffSq = pow((ipx - jpx), 2);
-  auto yDiffSq = pow((ipy - jpy), 2);
-  auto zDiffSq = pow((ipz - jpz), 2);
-  auto diffSum = xDiffSq + yDiffSq + zDiffSq;
+// Transform the summed density increases into the particle's density
+template <typename Policy>
+void Block::transformDensity(BasicParticleStore<Policy> &store, int part,
+                             KernelConstants const &constants) {
+  using Accumulator = typename Policy::Accumulator;
+  auto const idx = static_cast<std::size_t>(part);
+  store.density[idx] = (store.density[idx] + static_cast<Accumulator>(constants.slSixth)) *
+                       static_cast<Accumulator>(constants.densTransConstant);
+}
 
+// Formula to calculate the distance between two given particles
+double Block::findDistance(ParticleStore const &store, int iPart, int jPart) {
+  double const diffSum = squaredDistance(store, static_cast<std::size_t>(iPart),
+                                         static_cast<std::size_t>(jPart));
   double const distance = sqrt(fmax(diffSum, pow(10, -12)));
   return distance;
 }
 
-// Transfer accelerations between a given particle and every particle in the
-// adjacent blocks NEED TO MAKE SHORTER
-void Block::accelerationTransfer(Particle part, double slSq, double accTransConstant1, double accTransConstant2) {
-  auto pos = part.get_position();
-  for (auto &block : adjBlocks) {
-    auto adjParts = block.getParticles();
-    for (auto &adjPart : adjParts) {
-      auto pos2 = adjPart.get_position(); // check if dist is short enough first
-      auto diffSum = pow(pos[0] - pos2[0], 2) + pow(pos[1] - pos2[1], 2) +
-                     pow(pos[2] - pos2[2], 2);
-      if (diffSum < slSq) {
-        double const distance = findDistance(part, adjPart);
-        double const commonMult = accTransConstant1 * ((pow((slSq - distance), 2)) / distance) * (part.get_density() + adjPart.get_density() - 
-          (2 * Constants::fluidDensity)) * accTransConstant2 / (part.get_density() * adjPart.get_density());
-        std::vector<double> const accChanges = {(pos[0] - pos2[0]) * commonMult, (pos[1] - pos2[1]) * commonMult, (pos[2] - pos2[2]) * commonMult};
-        if (!part.hasAccelerated()) {
-          part.set_acceleration(
-              addVectors(part.get_acceleration(), accChanges));
-          adjPart.set_acceleration(
-              subtractVectors(part.get_acceleration(), accChanges));
-          part.updateAccBool();
-          adjPart.updateAccBool();
-        }
-      }
+// Acceleration change of particle iPart caused by particle jPart
+std::array<ParticleStore::Accumulator, 3>
+    Block::pairAcceleration(ParticleStore const &store, int iPart, int jPart,
+                            KernelConstants const &constants) {
+  return simd::pairAcceleration(store, iPart, jPart, constants);
+}
+
+// Transfer accelerations between a given particle and every other particle
+// in the adjacent blocks
+void Block::accelerationTransfer(ParticleStore &store, int part,
+                                 KernelConstants const &constants) const {
+  forEachNeighbour(neighbourSlots, [&store, part, &constants](Block const &blk) {
+    if (part >= blk.get_begin() && part < blk.get_end()) {
+      simd::transferAccelerationRow(store, {part, blk.get_begin(), part}, constants, false);
+      simd::transferAccelerationRow(store, {part, part + 1, blk.get_end()}, constants, false);
+    } else {
+      simd::transferAccelerationRow(store, {part, blk.get_begin(), blk.get_end()}, constants,
+                                    false);
     }
-  }
+  });
 }
 
-std::vector<double> Block::addVectors(std::vector<double> vec1,
-                               std::vector<double> vec2) {
-  std::vector<double> newVec = {vec1[0] + vec2[0], vec1[1] + vec2[1],
-                                vec1[2] + vec2[2]};
-  return newVec;
+// Transfer accelerations of every pair once: pairs inside the block, then
+// pairs with each forward block
+void Block::accelerationTransferPairs(ParticleStore &store,
+                                      KernelConstants const &constants) const {
+  for (int part = begin; part < end; part++) {
+    simd::transferAccelerationRow(store, {part, part + 1, end}, constants, true);
+    forEachNeighbour(neighbourSlots & NeighbourStencil::forwardSlots,
+                     [&store, part, &constants](Block const &blk) {
+      simd::transferAccelerationRow(store, {part, blk.get_begin(), blk.get_end()}, constants,
+                                    true);
+    });
+  }
 }
 
-std::vector<double> Block::subtractVectors(std::vector<double> vec1,
-                                    std::vector<double> vec2) {
-  std::vector<double> newVec = {vec1[0] - vec2[0], vec1[1] - vec2[1],
-                                vec1[2] - vec2[2]};
-  return newVec;
+// Update a particle (i.e., its position, hv, and velocity), computing in the
+// accumulator type and rounding the results to the stored type
+template <typename Policy, typename Config>
+void Block::particleMotion(BasicParticleStore<Policy> &store, int part, Config const &config) {
+  using Real = typename Policy::Real;
+  using Accumulator = typename Policy::Accumulator;
+  auto const idx = static_cast<std::size_t>(part);
+  std::array<Real *, 3> const position = {&store.px[idx], &store.py[idx], &store.pz[idx]};
+  std::array<Real *, 3> const vectorhv = {&store.hvx[idx], &store.hvy[idx], &store.hvz[idx]};
+  std::array<Real *, 3> const velocity = {&store.vx[idx], &store.vy[idx], &store.vz[idx]};
+  std::array<Accumulator, 3> const acceleration = {store.ax[idx], store.ay[idx], store.az[idx]};
+  auto const timeStep = static_cast<Accumulator>(config.get().timeStep);
+  Accumulator const timeStepSq = timeStep * timeStep;
+
+  for (std::size_t i = 0; i < 3; i++) {
+    auto const hv = static_cast<Accumulator>(*vectorhv[i]);
+    *position[i] = static_cast<Real>(static_cast<Accumulator>(*position[i]) + hv * timeStep +
+                                     acceleration[i] * timeStepSq);
+    *velocity[i] = static_cast<Real>(hv + ((acceleration[i] * timeStep) / 2));
+    *vectorhv[i] = static_cast<Real>(hv + acceleration[i] * timeStep);
+  }
 }
 
-// Update a particle (i.e., its position, hv, and velocity
-void Block::particleMotion(Particle part) {
-  std::vector<float> position = part.get_position();
-  std::vector<float> vectorhv = part.get_hv();
-  std::vector<float> velocity = part.get_velocity();
-  std::vector<double> acceleration = part.get_acceleration();
-
-  for (int i = 0; i < 3; i++) {
-    position[i] =
-        static_cast<float>(position[i] + vectorhv[i] * Constants::timeStep +
-                           acceleration[i] * pow(Constants::timeStep, 2));
-    velocity[i] = static_cast<float>(
-        vectorhv[i] + ((acceleration[i] * Constants::timeStep) / 2));
-    vectorhv[i] =
-        static_cast<float>(vectorhv[i] + acceleration[i] * Constants::timeStep);
+namespace {
+  // Smallest penetration of a wall that counts as a collision
+  constexpr double collisionThreshold = 1e-10;
+
+  // Whether a mask of faces has the lower and the upper face of an axis
+  constexpr bool hasLower(std::uint8_t faces, std::size_t axis) {
+    return (faces & NeighbourStencil::lowerFace(axis)) != 0;
+  }
+  constexpr bool hasUpper(std::uint8_t faces, std::size_t axis) {
+    return (faces & NeighbourStencil::upperFace(axis)) != 0;
   }
 
-  part.set_position(position);
-  part.set_velocity(velocity);
-  part.set_hv(vectorhv);
-}
+  // Kernel over a range of particles, and the instance of it for every mask
+  // of faces
+  template <typename Policy, typename Config>
+  using RangeKernel = void (*)(BasicParticleStore<Policy> &, int, int, Config const &);
 
-const int ten = 10;
-const int minus_ten = -10;
-// Process the box collisions of one particle
-void Block::boxCollisions(Particle part) {
-  std::vector<float> position = part.get_position();
-  std::vector<float> vectorhv = part.get_hv();
-  std::vector<float> velocity = part.get_velocity();
-  std::vector<double> currentAcc = part.get_acceleration();
-  std::vector<double> newAcc = part.get_acceleration();
-  for (int i = 0; i < 3; i++) {
-    auto newCoord =
-        static_cast<float>(position[i] + vectorhv[i] * Constants::timeStep);
-    double const changeLower =
-        Constants::particleSize - (newCoord - Constants::getBoxLowerBound()[i]);
-    double const changeUpper =
-        Constants::particleSize - (Constants::getBoxUpperBound()[i] - newCoord);
-    auto check = pow(ten, minus_ten);
-
-    if (changeLower > check) {
-      newAcc[i] = currentAcc[i] + Constants::stiffnessCollisions * changeLower -
-                  Constants::damping * velocity[i];
-
-    } else if (changeUpper > check) {
-      newAcc[i] = currentAcc[i] - Constants::stiffnessCollisions * changeLower -
-                  Constants::damping * velocity[i];
+  template <typename Policy, typename Config, std::uint8_t Faces>
+  void boxCollisionRange(BasicParticleStore<Policy> &store, int begin, int end,
+                         Config const &config) {
+    for (int part = begin; part < end; part++) {
+      Block::boxCollisions<Policy, Config, Faces>(store, part, config);
     }
   }
-  part.set_acceleration(newAcc);
+
+  template <typename Policy, typename Config, std::uint8_t Faces>
+  void boundaryCollisionRange(BasicParticleStore<Policy> &store, int begin, int end,
+                              Config const &config) {
+    for (int part = begin; part < end; part++) {
+      Block::boundaryCollisions<Policy, Config, Faces>(store, part, config);
+    }
+  }
+
+  template <typename Policy, typename Config, std::size_t... Faces>
+  constexpr std::array<RangeKernel<Policy, Config>, sizeof...(Faces)>
+      boxCollisionKernels(std::index_sequence<Faces...> /*faces*/) {
+    return {&boxCollisionRange<Policy, Config, static_cast<std::uint8_t>(Faces)>...};
+  }
+
+  template <typename Policy, typename Config, std::size_t... Faces>
+  constexpr std::array<RangeKernel<Policy, Config>, sizeof...(Faces)>
+      boundaryCollisionKernels(std::index_sequence<Faces...> /*faces*/) {
+    return {&boundaryCollisionRange<Policy, Config, static_cast<std::uint8_t>(Faces)>...};
+  }
+
+  using FaceMasks = std::make_index_sequence<NeighbourStencil::numFaceMasks>;
+}  // namespace
+
+// Process the box collisions of one particle with the walls of Faces
+template <typename Policy, typename Config, std::uint8_t Faces>
+void Block::boxCollisions(BasicParticleStore<Policy> &store, int part, Config const &config) {
+  using Real = typename Policy::Real;
+  using Accumulator = typename Policy::Accumulator;
+  auto const idx = static_cast<std::size_t>(part);
+  std::array<Real, 3> const position = {store.px[idx], store.py[idx], store.pz[idx]};
+  std::array<Real, 3> const vectorhv = {store.hvx[idx], store.hvy[idx], store.hvz[idx]};
+  std::array<Real, 3> const velocity = {store.vx[idx], store.vy[idx], store.vz[idx]};
+  std::array<Accumulator *, 3> const newAcc = {&store.ax[idx], &store.ay[idx], &store.az[idx]};
+  SimulationConfig const &settings = config.get();
+  auto const check = static_cast<Accumulator>(collisionThreshold);
+  auto const particleSize = static_cast<Accumulator>(settings.particleSize);
+  auto const stiffness = static_cast<Accumulator>(settings.stiffnessCollisions);
+  auto const damping = static_cast<Accumulator>(settings.damping);
+  auto const timeStep = static_cast<Accumulator>(settings.timeStep);
+  int collisions = 0;
+  for (std::size_t i = 0; i < 3; i++) {
+    bool const lower = hasLower(Faces, i);
+    bool const upper = hasUpper(Faces, i);
+    if (not lower and not upper) { continue; }
+    Accumulator const newCoord = position[i] + vectorhv[i] * timeStep;
+    Accumulator const changeLower =
+        particleSize - (newCoord - static_cast<Accumulator>(settings.boxLowerBound[i]));
+    Accumulator const changeUpper =
+        particleSize - (static_cast<Accumulator>(settings.boxUpperBound[i]) - newCoord);
+
+    if (lower and changeLower > check) {
+      *newAcc[i] += stiffness * changeLower - damping * velocity[i];
+      collisions++;
+    } else if (upper and changeUpper > check) {
+      *newAcc[i] -= stiffness * changeUpper + damping * velocity[i];
+      collisions++;
+    }
+  }
+  if (collisions > 0) { profile::count(Counter::wallCollisions, collisions); }
 }
 
-// Process the boundary collisions of one particle
-void Block::boundaryCollisions(Particle part) {
-  std::vector<float> position = part.get_position();
-  std::vector<float> velocity = part.get_velocity();
-  std::vector<float> vectorhv = part.get_hv();
-
-  for (int i = 0; i < 3; i++) {
-    auto dLower = position[i] - Constants::getBoxLowerBound()[i];
-    auto dUpper = Constants::getBoxUpperBound()[i] - position[i];
-
-    if (dLower < 0) {
-      position[i] =
-          static_cast<float>(Constants::getBoxLowerBound()[i] - dLower);
-      velocity[i] = -1 * velocity[i];
-      vectorhv[i] = -1 * vectorhv[i];
-    } else if (dUpper < 0) {
-      position[i] =
-          static_cast<float>(Constants::getBoxUpperBound()[i] + dUpper);
-      velocity[i] = -1 * velocity[i];
-      vectorhv[i] = -1 * vectorhv[i];
+// Process the boundary collisions of one particle with the walls of Faces
+template <typename Policy, typename Config, std::uint8_t Faces>
+void Block::boundaryCollisions(BasicParticleStore<Policy> &store, int part,
+                               Config const &config) {
+  using Real = typename Policy::Real;
+  auto const &lowerBound = config.get().boxLowerBound;
+  auto const &upperBound = config.get().boxUpperBound;
+  auto const idx = static_cast<std::size_t>(part);
+  std::array<Real *, 3> const position = {&store.px[idx], &store.py[idx], &store.pz[idx]};
+  std::array<Real *, 3> const velocity = {&store.vx[idx], &store.vy[idx], &store.vz[idx]};
+  std::array<Real *, 3> const vectorhv = {&store.hvx[idx], &store.hvy[idx], &store.hvz[idx]};
+
+  for (std::size_t i = 0; i < 3; i++) {
+    bool const lower = hasLower(Faces, i);
+    bool const upper = hasUpper(Faces, i);
+    if (not lower and not upper) { continue; }
+    auto dLower = *position[i] - lowerBound[i];
+    auto dUpper = upperBound[i] - *position[i];
+
+    if (lower and dLower < 0) {
+      *position[i] = static_cast<Real>(lowerBound[i] - dLower);
+      *velocity[i] = -1 * *velocity[i];
+      *vectorhv[i] = -1 * *vectorhv[i];
+    } else if (upper and dUpper < 0) {
+      *position[i] = static_cast<Real>(upperBound[i] + dUpper);
+      *velocity[i] = -1 * *velocity[i];
+      *vectorhv[i] = -1 * *vectorhv[i];
     }
   }
-  part.set_position(position);
-  part.set_velocity(velocity);
-  part.set_hv(vectorhv);
+}
+
+template <typename Policy, typename Config>
+void Block::processBoxCollisions(BasicParticleStore<Policy> &store, std::uint8_t faces,
+                                 Config const &config) const {
+  static constexpr auto kernels = boxCollisionKernels<Policy, Config>(FaceMasks{});
+  if (faces != 0) { kernels[faces](store, begin, end, config); }
+}
+
+template <typename Policy, typename Config>
+void Block::processBoundaryCollisions(BasicParticleStore<Policy> &store, std::uint8_t faces,
+                                      Config const &config) const {
+  static constexpr auto kernels = boundaryCollisionKernels<Policy, Config>(FaceMasks{});
+  if (faces != 0) { kernels[faces](store, begin, end, config); }
 }
 
 // Block destructor implementation
 Block::~Block() = default;
+
+// The per-particle kernels for every precision policy and configuration source
+#define FLUID_BLOCK_KERNELS(Policy, Config)                                                 \
+  template void Block::initAcceleration(BasicParticleStore<Policy> &, int, Config const &);   \
+  template void Block::particleMotion(BasicParticleStore<Policy> &, int, Config const &);     \
+  template void Block::boxCollisions(BasicParticleStore<Policy> &, int, Config const &);      \
+  template void Block::boundaryCollisions(BasicParticleStore<Policy> &, int, Config const &); \
+  template void Block::processBoxCollisions(BasicParticleStore<Policy> &, std::uint8_t,       \
+                                            Config const &) const;                            \
+  template void Block::processBoundaryCollisions(BasicParticleStore<Policy> &, std::uint8_t,  \
+                                                 Config const &) const;
+#define FLUID_BLOCK_POLICY_KERNELS(Policy)                                                  \
+  template void Block::transformDensity(BasicParticleStore<Policy> &, int,                    \
+                                        KernelConstants const &);                             \
+  FLUID_BLOCK_KERNELS(Policy, DefaultConfigSource)                                            \
+  FLUID_BLOCK_KERNELS(Policy, RuntimeConfigSource)
+FLUID_BLOCK_POLICY_KERNELS(MixedPrecision)
+FLUID_BLOCK_POLICY_KERNELS(DoublePrecision)
+FLUID_BLOCK_POLICY_KERNELS(FloatPrecision)
+#undef FLUID_BLOCK_POLICY_KERNELS
+#undef FLUID_BLOCK_KERNELS
@@ -2,8 +2,14 @@
 #define BLOCK_CPP
 
 #include "constants.hpp"
-#include "particle.hpp"
+#include "neighbour_stencil.hpp"
+#include "particle_store.hpp"
+#include "simulation_config.hpp"
+#include <array>
+#include <bit>
 #include <cmath>
+#include <cstdint>
+#include <span>
 #include <utility>
 #include <vector>
 
@@ -31,48 +37,105 @@ public:
 
   Block& operator=(Block&& other) = default;
 
-  // Member particle getter
-  std::vector<Particle> getParticles();
+  // The block's particles are the range [begin, end) of the particle store
+  [[nodiscard]] int get_begin() const;
+  [[nodiscard]] int get_end() const;
+  [[nodiscard]] int size() const;
+  void setRange(int begin, int end);
 
   // Get the block's index
-  [[nodiscard]] std::vector<int> get_index() const;
-
-  // Add particle to block
-  void addParticle(const Particle &part);
-
-  // Add an adjacent block to the block's adjacent block vector
-  void addAdjacentBlock(const Block &adjBlock);
-
-  // Increasing density...
-  void incDensity(Particle &part, double slSq, double slSixth,
-                  double densTransConstant);
+  [[nodiscard]] std::array<int, 3> get_index() const;
+
+  // Link the block to its neighbours in the grid's array of blocks: the
+  // block at offsets[s] from this one for every slot s of slots (a mask of
+  // the slots of a NeighbourStencil, whose offsets the span refers to)
+  void setNeighbours(std::span<int const> offsets, std::uint32_t slots);
+
+  // Reset density and acceleration of a particle before the interactions.
+  // The per-particle kernels are instantiated for every precision policy,
+  // and those that use the configuration for both of its sources
+  // (DefaultConfigSource folds the default one into the code)
+  template <typename Policy, typename Config = DefaultConfigSource>
+  static void initAcceleration(BasicParticleStore<Policy> &store, int part,
+                               Config const &config = {});
+
+  // Increasing density of one particle from every other particle in the
+  // adjacent blocks
+  void incDensity(ParticleStore &store, int part, double slSq) const;
+
+  // Increasing density of both particles of every pair within this block
+  // and between this block and its forward blocks
+  void incDensityPairs(ParticleStore &store, double slSq) const;
+
+  // Density transformation once all the increases are added
+  template <typename Policy>
+  static void transformDensity(BasicParticleStore<Policy> &store, int part,
+                               KernelConstants const &constants);
 
   // Distance formula ..
-  static double findDistance(const Particle &iPart, const Particle &jPart);
+  static double findDistance(ParticleStore const &store, int iPart, int jPart);
 
-  // Transferring accelerations
-  void accelerationTransfer(Particle part, double slSq,
-                            double accTransConstant1, double accTransConstant2);
+  // Transferring accelerations to one particle from every other particle in
+  // the adjacent blocks
+  void accelerationTransfer(ParticleStore &store, int part,
+                            KernelConstants const &constants) const;
 
-  // helper function for accelerationTransfer
-  static std::vector<double> addVectors(std::vector<double> vec1,
-                                 std::vector<double> vec2);
-  static std::vector<double> subtractVectors(std::vector<double> vec1,
-                                      std::vector<double> vec2);
+  // Transferring accelerations to both particles of every pair within this
+  // block and between this block and its forward blocks
+  void accelerationTransferPairs(ParticleStore &store, KernelConstants const &constants) const;
 
-  // Particle motion
-  static void particleMotion(Particle part);
-
-  // Process box collisions
-  static void boxCollisions(Particle part);
+  // Acceleration change of particle iPart caused by particle jPart
+  static std::array<ParticleStore::Accumulator, 3>
+      pairAcceleration(ParticleStore const &store, int iPart, int jPart,
+                       KernelConstants const &constants);
 
-  // Process boundary collisions
-  static void boundaryCollisions(Particle part);
+  // Particle motion
+  template <typename Policy, typename Config = DefaultConfigSource>
+  static void particleMotion(BasicParticleStore<Policy> &store, int part,
+                             Config const &config = {});
+
+  // Process box collisions. Only the walls of Faces (a mask of
+  // NeighbourStencil faces) are tested, all of them by default
+  template <typename Policy, typename Config = DefaultConfigSource,
+            std::uint8_t Faces = NeighbourStencil::allFaces>
+  static void boxCollisions(BasicParticleStore<Policy> &store, int part,
+                            Config const &config = {});
+
+  // Process boundary collisions, with the walls of Faces
+  template <typename Policy, typename Config = DefaultConfigSource,
+            std::uint8_t Faces = NeighbourStencil::allFaces>
+  static void boundaryCollisions(BasicParticleStore<Policy> &store, int part,
+                                 Config const &config = {});
+
+  // Box and boundary collisions of the block's particles, for a block that
+  // touches faces of the grid. Particles of a block can only reach the walls
+  // of its faces, so each mask runs its own instance of the kernel and a
+  // block inside the grid does nothing
+  template <typename Policy, typename Config = DefaultConfigSource>
+  void processBoxCollisions(BasicParticleStore<Policy> &store, std::uint8_t faces,
+                            Config const &config = {}) const;
+  template <typename Policy, typename Config = DefaultConfigSource>
+  void processBoundaryCollisions(BasicParticleStore<Policy> &store, std::uint8_t faces,
+                                 Config const &config = {}) const;
 
 private:
-  std::vector<Particle> particles;
-  std::vector<Block> adjBlocks;
-  std::vector<int> index;
+  // Calls function(block) for the neighbour in every slot of mask, in
+  // increasing linear index
+  template <typename Function>
+  void forEachNeighbour(std::uint32_t mask, Function function) const {
+    for (; mask != 0; mask &= mask - 1) {
+      function(*(this + neighbourOffsets[static_cast<std::size_t>(std::countr_zero(mask))]));
+    }
+  }
+
+  // Range of the block's particles, set by the grid on repositioning
+  int begin{};
+  int end{};
+  // Slots of the adjacent blocks (including this one); none until the grid
+  // links the block
+  std::uint32_t neighbourSlots{};
+  std::span<int const> neighbourOffsets;
+  std::array<int, 3> index;
 };
 
 #endif
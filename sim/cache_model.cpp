@@ -0,0 +1,64 @@
+#include "cache_model.hpp"
+
+#include <algorithm>
+
+CacheModel::CacheModel(std::size_t bytes, int ways)
+    : ways(static_cast<std::size_t>(ways)),
+      numSets(std::max<std::size_t>(bytes / lineBytes / static_cast<std::size_t>(ways), 1)),
+      tags(numSets * static_cast<std::size_t>(ways), 0) {}
+
+std::int64_t CacheModel::get_accesses() const { return accesses; }
+std::int64_t CacheModel::get_misses() const { return misses; }
+
+// Move the line to the front of its set, dropping the least recently used
+// line on a miss. Tags are stored plus one so that zero marks an empty way
+bool CacheModel::accessLine(std::uint64_t line) {
+  accesses++;
+  auto const set = tags.begin() + static_cast<std::ptrdiff_t>((line % numSets) * ways);
+  auto const setEnd = set + static_cast<std::ptrdiff_t>(ways);
+  auto found = std::find(set, setEnd, line + 1);
+  bool const hit = found != setEnd;
+  if (not hit) {
+    misses++;
+    found = setEnd - 1;
+  }
+  std::rotate(set, found, found + 1);
+  *set = line + 1;
+  return hit;
+}
+
+StencilTraffic stencilTraffic(Grid const &grid, CacheSizes const &sizes) {
+  CacheModel level1(sizes.l1Bytes, sizes.l1Ways);
+  CacheModel level2(sizes.l2Bytes, sizes.l2Ways);
+  ParticleStore const &store = grid.get_particles();
+  std::vector<Block> const &blocks = grid.get_blocks();
+
+  // Every line of the three position arrays covering [begin, end). The
+  // arrays are modelled back to back from line 0, so the result does not
+  // depend on where the allocator happened to place them
+  constexpr auto floatsPerLine = CacheModel::lineBytes / sizeof(ParticleStore::Real);
+  auto const arrayLines = (static_cast<std::uintptr_t>(store.size()) + floatsPerLine - 1) /
+                          floatsPerLine;
+  auto const readRange = [&level1, &level2, arrayLines](int begin, int end) {
+    if (begin >= end) { return; }
+    for (std::uintptr_t array = 0; array < 3; array++) {
+      auto const first = array * arrayLines + static_cast<std::uintptr_t>(begin) / floatsPerLine;
+      auto const last = array * arrayLines + static_cast<std::uintptr_t>(end - 1) / floatsPerLine;
+      for (auto line = first; line <= last; line++) {
+        if (not level1.accessLine(line)) { level2.accessLine(line); }
+      }
+    }
+  };
+
+  for (auto const block : grid.get_blockOrder()) {
+    Block const &blockObj = blocks[static_cast<std::size_t>(block)];
+    for (int part = blockObj.get_begin(); part < blockObj.get_end(); part++) {
+      readRange(part, part + 1);
+      grid.get_stencil().forEachNeighbour(block, [&blocks, &readRange](int adjBlock) {
+        Block const &adjObj = blocks[static_cast<std::size_t>(adjBlock)];
+        readRange(adjObj.get_begin(), adjObj.get_end());
+      });
+    }
+  }
+  return {level1.get_accesses(), level1.get_misses(), level2.get_misses()};
+}
@@ -0,0 +1,54 @@
+#ifndef FLUID_CACHE_MODEL_HPP
+#define FLUID_CACHE_MODEL_HPP
+
+#include "grid.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Set-associative cache of 64-byte lines with least recently used
+// replacement. It counts the misses of an access pattern the same way on
+// every machine, which hardware counters cannot do
+class CacheModel {
+public:
+  static constexpr std::size_t lineBytes = 64;
+
+  CacheModel(std::size_t bytes, int ways);
+
+  // Access one line; returns whether it was in the cache
+  bool accessLine(std::uint64_t line);
+
+  [[nodiscard]] std::int64_t get_accesses() const;
+  [[nodiscard]] std::int64_t get_misses() const;
+
+private:
+  std::size_t ways;
+  std::size_t numSets;
+  // Lines of every set, most recently used first; zero is an empty way
+  std::vector<std::uint64_t> tags;
+  std::int64_t accesses{};
+  std::int64_t misses{};
+};
+
+// Two levels of cache, by default the size of a common L1 and L2
+struct CacheSizes {
+  std::size_t l1Bytes = 32 * 1024;
+  int l1Ways = 8;
+  std::size_t l2Bytes = 1024 * 1024;
+  int l2Ways = 16;
+};
+
+// Lines read by the density stage and the misses of each cache level
+struct StencilTraffic {
+  std::int64_t lines{};
+  std::int64_t l1Misses{};
+  std::int64_t l2Misses{};
+};
+
+// Replay the position reads of the density stage over the current layout
+// of the grid: the blocks in the order of their particles and, for every
+// particle, the positions of the particles of the adjacent blocks
+[[nodiscard]] StencilTraffic stencilTraffic(Grid const &grid, CacheSizes const &sizes = {});
+
+#endif  // FLUID_CACHE_MODEL_HPP
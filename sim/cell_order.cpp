@@ -0,0 +1,108 @@
+#include "cell_order.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+bool parseCellOrder(std::string const &name, CellOrder &order) {
+  if (name == "linear") {
+    order = CellOrder::linear;
+  } else if (name == "morton") {
+    order = CellOrder::morton;
+  } else if (name == "hilbert") {
+    order = CellOrder::hilbert;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+namespace {
+  constexpr int maxBits = 21;
+
+  // Spread the low 21 bits of value two bits apart
+  std::uint64_t spreadBits(std::uint64_t value) {
+    std::uint64_t spread = 0;
+    for (int bit = 0; bit < maxBits; bit++) { spread |= ((value >> bit) & 1U) << (3 * bit); }
+    return spread;
+  }
+
+  // Bits needed for the largest coordinate
+  int bitsFor(std::array<int, 3> const &numbers) {
+    int const largest = std::max({numbers[0], numbers[1], numbers[2]});
+    int bits = 1;
+    while ((1 << bits) < largest) { bits++; }
+    return bits;
+  }
+}  // namespace
+
+std::uint64_t mortonKey(std::array<int, 3> const &coords) {
+  return spreadBits(static_cast<std::uint64_t>(coords[0])) |
+         (spreadBits(static_cast<std::uint64_t>(coords[1])) << 1U) |
+         (spreadBits(static_cast<std::uint64_t>(coords[2])) << 2U);
+}
+
+// Skilling's transform ("Programming the Hilbert curve", 2004): turn the
+// coordinates into the transposed Hilbert index, then interleave its bits
+std::uint64_t hilbertKey(std::array<int, 3> const &coords, int bits) {
+  std::array<std::uint32_t, 3> axes = {static_cast<std::uint32_t>(coords[0]),
+                                       static_cast<std::uint32_t>(coords[1]),
+                                       static_cast<std::uint32_t>(coords[2])};
+  std::uint32_t const top = 1U << static_cast<std::uint32_t>(bits - 1);
+
+  // Inverse undo
+  for (std::uint32_t bit = top; bit > 1; bit >>= 1U) {
+    std::uint32_t const lower = bit - 1;
+    for (auto & axis : axes) {
+      if ((axis & bit) != 0) {
+        axes[0] ^= lower;
+      } else {
+        std::uint32_t const swap = (axes[0] ^ axis) & lower;
+        axes[0] ^= swap;
+        axis ^= swap;
+      }
+    }
+  }
+
+  // Gray encode
+  axes[1] ^= axes[0];
+  axes[2] ^= axes[1];
+  std::uint32_t flip = 0;
+  for (std::uint32_t bit = top; bit > 1; bit >>= 1U) {
+    if ((axes[2] & bit) != 0) { flip ^= bit - 1; }
+  }
+  for (auto & axis : axes) { axis ^= flip; }
+
+  std::uint64_t key = 0;
+  for (int bit = bits - 1; bit >= 0; bit--) {
+    for (auto const axis : axes) {
+      key = (key << 1U) | ((axis >> static_cast<std::uint32_t>(bit)) & 1U);
+    }
+  }
+  return key;
+}
+
+std::vector<int> curveRanks(std::array<int, 3> const &numbers, CellOrder order) {
+  int const numBlocks = numbers[0] * numbers[1] * numbers[2];
+  std::vector<int> ranks(static_cast<std::size_t>(numBlocks));
+  std::iota(ranks.begin(), ranks.end(), 0);
+  if (order == CellOrder::linear) { return ranks; }
+
+  int const bits = bitsFor(numbers);
+  std::vector<std::uint64_t> keys(static_cast<std::size_t>(numBlocks));
+  for (int block = 0; block < numBlocks; block++) {
+    std::array<int, 3> const coords = {block % numbers[0], (block / numbers[0]) % numbers[1],
+                                       block / (numbers[0] * numbers[1])};
+    keys[static_cast<std::size_t>(block)] =
+        order == CellOrder::morton ? mortonKey(coords) : hilbertKey(coords, bits);
+  }
+
+  // Blocks sorted by key, then each block's position in that order
+  std::vector<int> sorted(ranks);
+  std::sort(sorted.begin(), sorted.end(), [&keys](int left, int right) {
+    return keys[static_cast<std::size_t>(left)] < keys[static_cast<std::size_t>(right)];
+  });
+  for (int rank = 0; rank < numBlocks; rank++) {
+    ranks[static_cast<std::size_t>(sorted[static_cast<std::size_t>(rank)])] = rank;
+  }
+  return ranks;
+}
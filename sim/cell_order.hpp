@@ -0,0 +1,25 @@
+#ifndef FLUID_CELL_ORDER_HPP
+#define FLUID_CELL_ORDER_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Order in which the blocks (and so their particles) are laid out in memory
+enum class CellOrder { linear, morton, hilbert };
+
+// Parse "linear", "morton" or "hilbert"; returns false for anything else
+bool parseCellOrder(std::string const &name, CellOrder &order);
+
+// Morton (Z-order) key: the bits of the three coordinates interleaved
+[[nodiscard]] std::uint64_t mortonKey(std::array<int, 3> const &coords);
+
+// Position along the Hilbert curve that fills a cube of side 2^bits
+[[nodiscard]] std::uint64_t hilbertKey(std::array<int, 3> const &coords, int bits);
+
+// Rank of every block of a grid with numbers blocks per axis along the
+// curve, by linear block index ix + nx * (iy + ny * iz)
+[[nodiscard]] std::vector<int> curveRanks(std::array<int, 3> const &numbers, CellOrder order);
+
+#endif  // FLUID_CELL_ORDER_HPP
@@ -0,0 +1,99 @@
+#include "checkpoint.hpp"
+
+#include "mapped_file.hpp"
+#include "parser.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+namespace {
+  constexpr std::array<char, 4> magic = {'F', 'L', 'D', 'C'};
+  constexpr std::int32_t version = 3;
+
+  // Header fields, padded so the particle arrays start aligned
+  struct Header {
+    std::array<char, 4> magic;
+    std::int32_t version;
+    float ppm;
+    std::int32_t np;
+    std::int32_t count;
+    std::int32_t step;
+    std::int32_t cellOrder;
+    std::int32_t numParticles;
+    // Element sizes of the arrays, which depend on the precision policy
+    std::int32_t realBytes;
+    std::int32_t accumulatorBytes;
+    // Constants and tank the run continues with
+    SimulationConfig config;
+  };
+
+  constexpr auto realBytes = static_cast<std::int32_t>(sizeof(ParticleStore::Real));
+  constexpr auto accumulatorBytes = static_cast<std::int32_t>(sizeof(ParticleStore::Accumulator));
+
+  constexpr std::size_t headerBytes =
+      (sizeof(Header) + particleAlignment - 1) / particleAlignment * particleAlignment;
+}  // namespace
+
+void writeCheckpoint(std::string const &filename, Grid const &grid, int step,
+                     std::vector<std::byte> &buffer) {
+  ParticleStore const &store = grid.get_particles();
+  buffer.assign(headerBytes + ParticleStore::packedBytes(store.size()), std::byte{0});
+  Header const header{magic,
+                      version,
+                      grid.get_ppm(),
+                      grid.get_np(),
+                      grid.get_count(),
+                      step,
+                      static_cast<std::int32_t>(grid.get_cellOrder()),
+                      store.size(),
+                      realBytes,
+                      accumulatorBytes,
+                      grid.get_config()};
+  std::memcpy(buffer.data(), &header, sizeof(header));
+  store.pack(std::span(buffer).subspan(headerBytes));
+
+  std::string const temporary = filename + ".tmp";
+  writeBuffer(temporary, buffer);
+  std::error_code error;
+  std::filesystem::rename(temporary, filename, error);
+  if (error) { throw std::system_error(error, filename); }
+}
+
+Grid readCheckpoint(std::string const &filename, int &step) {
+  MappedFile const file(filename);
+  std::span<std::byte const> const bytes = file.bytes();
+  Header header{};
+  if (bytes.size() >= headerBytes) { std::memcpy(&header, bytes.data(), sizeof(header)); }
+  if (bytes.size() < headerBytes or header.magic != magic) {
+    throw std::runtime_error(filename + ": not a checkpoint");
+  }
+  if (header.version != version) {
+    throw std::runtime_error(filename + ": unsupported checkpoint version");
+  }
+  if (header.realBytes != realBytes or header.accumulatorBytes != accumulatorBytes) {
+    throw std::runtime_error(filename + ": checkpoint of a build with another precision");
+  }
+  if (header.numParticles < 0 or header.cellOrder < 0 or
+      header.cellOrder > static_cast<std::int32_t>(CellOrder::hilbert) or
+      bytes.size() != headerBytes + ParticleStore::packedBytes(header.numParticles)) {
+    throw std::runtime_error(filename + ": corrupt checkpoint");
+  }
+
+  // The particles go back in the order they were saved, which the next
+  // repositioning keeps, so the run continues exactly
+  Grid grid(header.ppm, header.np, header.config);
+  grid.set_cellOrder(static_cast<CellOrder>(header.cellOrder));
+  grid.get_particles().unpack(bytes.subspan(headerBytes), header.numParticles);
+  grid.set_count(header.count);
+  grid.repositionParticles();
+  step = header.step;
+  return grid;
+}
+
+std::string checkpointName(std::string const &outputfile) {
+  std::filesystem::path const path(outputfile);
+  return (path.parent_path() / (path.stem().string() + ".chk")).string();
+}
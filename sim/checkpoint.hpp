@@ -0,0 +1,29 @@
+#ifndef FLUID_CHECKPOINT_HPP
+#define FLUID_CHECKPOINT_HPP
+
+#include "grid.hpp"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Checkpoints hold the complete solver state after a step: the grid
+// parameters and configuration, the step counter and every particle array
+// in its current order, so a restarted run continues bit for bit as if it
+// had never stopped. The arrays are stored as ParticleStore::pack lays them out
+
+// Write the state of grid after step to filename, encoding into buffer to
+// reuse its capacity. The file is written under a temporary name and
+// renamed over filename, so an interrupted write keeps the previous
+// checkpoint. Throws std::system_error on failure
+void writeCheckpoint(std::string const &filename, Grid const &grid, int step,
+                     std::vector<std::byte> &buffer);
+
+// Map a checkpoint and restore its grid; step is set to the step it was
+// written after. Throws std::runtime_error if the file is not a checkpoint
+Grid readCheckpoint(std::string const &filename, int &step);
+
+// Name of the checkpoint of a run: "<stem>.chk" next to outputfile
+[[nodiscard]] std::string checkpointName(std::string const &outputfile);
+
+#endif  // FLUID_CHECKPOINT_HPP
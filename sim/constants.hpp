@@ -1,39 +1,38 @@
 #ifndef FLUID_CONSTANTS_HPP
 #define FLUID_CONSTANTS_HPP
 
+#include <array>
 #include <cmath>
-#include <vector>
 
+// Default simulation constants. A configuration file can override them at
+// run time (simulation_config.hpp)
 namespace Constants {
 // Simulation scalar constants
-const double radiusMultiplier = 1.695;
-const double fluidDensity = pow(10, 3);
-const double stiffnessPressure = 3.0;
-const double stiffnessCollisions = 3 * pow(10, 4);
-const double damping = 128.0;
-const double viscosity = 0.4;
-const double particleSize = 2 * pow(10, -4);
-const double timeStep = pow(10, -3);
-
-// const std::vector<double> externalAcceleration = {0.0, -9.8, 0.0};
-// const std::vector<double> boxUpperBound = {0.065, 0.1, 0.065};
-// const std::vector<double> boxLowerBound = {-0.065, -0.08, -0.065};
-
-inline const std::vector<double> &getExternalAcceleration() noexcept {
-  static const std::vector<double> externalAcceleration = {0.0, -9.8, 0.0};
-  return externalAcceleration;
-}
-
-inline const std::vector<double> &getBoxUpperBound() noexcept {
-  static const std::vector<double> boxUpperBound = {0.065, 0.1, 0.065};
-  return boxUpperBound;
-}
-
-inline const std::vector<double> &getBoxLowerBound() noexcept {
-  static const std::vector<double> boxLowerBound = {-0.065, -0.08, -0.065};
-  return boxLowerBound;
-}
+inline constexpr double radiusMultiplier = 1.695;
+inline constexpr double fluidDensity = 1e3;
+inline constexpr double stiffnessPressure = 3.0;
+inline constexpr double stiffnessCollisions = 3e4;
+inline constexpr double damping = 128.0;
+inline constexpr double viscosity = 0.4;
+inline constexpr double particleSize = 2e-4;
+inline constexpr double timeStep = 1e-3;
+
+// External acceleration and the tank
+inline constexpr std::array<double, 3> externalAcceleration = {0.0, -9.8, 0.0};
+inline constexpr std::array<double, 3> boxUpperBound = {0.065, 0.1, 0.065};
+inline constexpr std::array<double, 3> boxLowerBound = {-0.065, -0.08, -0.065};
 
 } // namespace Constants
 
+// Smoothing length dependent constants used by the interaction kernels
+struct KernelConstants {
+  double smoothingLength;
+  double slSq;
+  double slSixth;
+  double densTransConstant;
+  double accTransConstant1;
+  double accTransConstant2;
+  double fluidDensity{Constants::fluidDensity};
+};
+
 #endif // FLUID_CONSTANTS_HPP
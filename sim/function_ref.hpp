@@ -0,0 +1,41 @@
+#ifndef FLUID_FUNCTION_REF_HPP
+#define FLUID_FUNCTION_REF_HPP
+
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+template <typename Signature>
+class FunctionRef;
+
+// Non-owning reference to a callable: a pointer to the object and one to a
+// function that calls it. Unlike std::function it never copies the callable,
+// so passing a lambda with any captures does not allocate. The callable must
+// outlive the reference, as a lambda passed straight to a call does
+template <typename Result, typename... Args>
+class FunctionRef<Result(Args...)> {
+public:
+  // Empty reference, false when tested
+  FunctionRef() noexcept = default;
+
+  template <typename Callable>
+    requires(not std::is_same_v<std::remove_cvref_t<Callable>, FunctionRef> and
+             std::is_invocable_r_v<Result, Callable &, Args...>)
+  // NOLINTNEXTLINE(google-explicit-constructor,hicpp-explicit-conversions)
+  FunctionRef(Callable &&callable) noexcept
+      : object(const_cast<void *>(static_cast<void const *>(std::addressof(callable)))),
+        call([](void *target, Args... args) -> Result {
+          return (*static_cast<std::remove_reference_t<Callable> *>(target))(
+              std::forward<Args>(args)...);
+        }) { }
+
+  Result operator()(Args... args) const { return call(object, std::forward<Args>(args)...); }
+
+  explicit operator bool() const noexcept { return call != nullptr; }
+
+private:
+  void *object{};
+  Result (*call)(void *, Args...){};
+};
+
+#endif  // FLUID_FUNCTION_REF_HPP
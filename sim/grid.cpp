@@ -1,25 +1,36 @@
 #include "grid.hpp"
 
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <numeric>
+
 const float threeonefive = 315.0;
 const int sixtyfour = 64;
 const int nine = 9;
 const int fifteen = 15;
 const int fourtyfive = 45;
+const int six = 6;
 
 // Constructor and Destructor
-Grid::Grid(float ppm, int np)
-    : ppm(ppm), np(np), particleMass(Constants::fluidDensity / pow(ppm, 3)),
-      smoothingLength(Constants::radiusMultiplier / ppm) {
+Grid::Grid(float ppm, int np, SimulationConfig const &config)
+    : config(config), ppm(ppm), np(np), particleMass(config.fluidDensity / pow(ppm, 3)),
+      smoothingLength(config.radiusMultiplier / ppm) {
+  particles.reserve(np);
   update_grid();
 }
 
 Grid::~Grid() = default;
 
 // Getters and setters for each variable
-std::unordered_map<std::vector<int>, Block, hashing::vHash>
-Grid::get_blocks() const {
-  return blocks;
-}
+std::vector<Block> const & Grid::get_blocks() const { return blocks; }
+std::vector<Block> & Grid::get_blocks() { return blocks; }
+NeighbourStencil const & Grid::get_stencil() const { return stencil; }
+
+ParticleStore const & Grid::get_particles() const { return particles; }
+ParticleStore & Grid::get_particles() { return particles; }
+
+SimulationConfig const & Grid::get_config() const { return config; }
 
 float Grid::get_ppm() const { return ppm; }
 int Grid::get_np() const { return np; }
@@ -28,9 +39,10 @@ void Grid::set_count(int newCount) { Grid::count = newCount; }
 
 double Grid::get_particleMass() const { return particleMass; }
 double Grid::get_smoothingLength() const { return smoothingLength; }
-double Grid::get_numberX() const { return numberX; }
-double Grid::get_numberY() const { return numberY; }
-double Grid::get_numberZ() const { return numberZ; }
+int Grid::get_numberX() const { return numberX; }
+int Grid::get_numberY() const { return numberY; }
+int Grid::get_numberZ() const { return numberZ; }
+int Grid::get_numBlocks() const { return static_cast<int>(blocks.size()); }
 double Grid::get_sizeX() const { return sizeX; }
 double Grid::get_sizeY() const { return sizeY; }
 double Grid::get_sizeZ() const { return sizeZ; }
@@ -41,30 +53,72 @@ double Grid::get_slNinth() const { return slNinth; }
 double Grid::get_densTransConstant() const { return densTransConstant; }
 double Grid::get_accTransConstant1() const { return accTransConstant1; }
 double Grid::get_accTransConstant2() const { return accTransConstant2; }
+CellOrder Grid::get_cellOrder() const { return cellOrder; }
+void Grid::set_cellOrder(CellOrder order) {
+  cellOrder = order;
+  blockRank = curveRanks(numberVector, cellOrder);
+  blockOrder.resize(blockRank.size());
+  for (std::size_t block = 0; block < blockRank.size(); block++) {
+    blockOrder[static_cast<std::size_t>(blockRank[block])] = static_cast<int>(block);
+  }
+  boundaryBlocks.clear();
+  for (auto const block : blockOrder) {
+    if (stencil.faces(block) != 0) { boundaryBlocks.push_back(block); }
+  }
+}
+std::span<int const> Grid::get_blockOrder() const { return blockOrder; }
+std::span<int const> Grid::get_boundaryBlocks() const { return boundaryBlocks; }
+
+std::span<int const> Grid::get_colourRows(int colour) const {
+  auto const first = static_cast<std::size_t>(colourStart[static_cast<std::size_t>(colour)]);
+  auto const last = static_cast<std::size_t>(colourStart[static_cast<std::size_t>(colour) + 1]);
+  return std::span<int const>(colourRows).subspan(first, last - first);
+}
+KernelConstants Grid::get_kernelConstants() const {
+  return {smoothingLength,   slSq,          slSixth, densTransConstant,
+          accTransConstant1, accTransConstant2, config.fluidDensity};
+}
 
 // block functions
+// The particle joins its block on the next repositioning
 void Grid::add_particle_to_block(const Particle &particle) {
-  std::vector<int> const key = findBlock(particle);
+  particles.addParticle(particle);
+}
 
-  auto itr = blocks.find(key);
+// Counting sort of the particles by block rank: count the particles of each
+// block, turn the counts into block start positions with a prefix sum and
+// scatter every particle to the next free position of its block
+void Grid::repositionParticles() {
+  auto const numParts = static_cast<std::size_t>(particles.size());
+  // A particle changed block unless it is still in the range its block got
+  // last time; the first sort only places the particles
+  bool const placed = not rankStart.empty();
+  std::int64_t blockChanges = 0;
+  particleRank.resize(numParts);
+  destination.resize(numParts);
+  rankStart.assign(blocks.size() + 1, 0);
+
+  for (std::size_t part = 0; part < numParts; part++) {
+    auto const block = static_cast<std::size_t>(findBlockIndex(static_cast<int>(part)));
+    int const rank = blockRank[block];
+    particleRank[part] = rank;
+    rankStart[static_cast<std::size_t>(rank) + 1]++;
+    auto const index = static_cast<int>(part);
+    blockChanges += index < blocks[block].get_begin() or index >= blocks[block].get_end() ? 1 : 0;
+  }
+  if (placed) { profile::count(Counter::blockChanges, blockChanges); }
+  std::partial_sum(rankStart.begin(), rankStart.end(), rankStart.begin());
 
-  if (itr != blocks.end()) {
-    // Already exists
-    auto targetBlock = itr->second;
-    targetBlock.addParticle(particle);
-  } else {
-    Block const newBlock(key);
-    blocks.insert({key, newBlock});
+  for (std::size_t rank = 0; rank < blocks.size(); rank++) {
+    blocks[static_cast<std::size_t>(blockOrder[rank])].setRange(rankStart[rank],
+                                                               rankStart[rank + 1]);
+  }
+  for (std::size_t part = 0; part < numParts; part++) {
+    destination[part] = rankStart[static_cast<std::size_t>(particleRank[part])]++;
   }
-  //  if (get_blocks().count(key) > 0) {
-  //    // Key is present
-  //    blocks[key].addParticle(particle);
-  //
-  //  } else {
-  //    // Key is not present
-  //    Block b(key);
-  //    blocks.insert(std::make_pair(key, b));
-  //  }
+
+  particles.scatter(reordered, destination);
+  std::swap(particles, reordered);
 }
 
 // update simulation parameters
@@ -74,12 +128,14 @@ void Grid::update_grid() {
   slSixth = pow(smoothingLength, six);
   slNinth = pow(smoothingLength, nine);
 
-  const auto &upperBound = Constants::getBoxUpperBound();
-  const auto &lowerBound = Constants::getBoxLowerBound();
+  const auto &upperBound = config.boxUpperBound;
+  const auto &lowerBound = config.boxLowerBound;
 
-  numberX = (upperBound[0] - lowerBound[0]) / smoothingLength;
-  numberY = (upperBound[1] - lowerBound[1]) / smoothingLength;
-  numberZ = (upperBound[2] - lowerBound[2]) / smoothingLength;
+  // A block is never smaller than the smoothing length, and there is at
+  // least one block in each dimension
+  numberX = std::max(1, static_cast<int>((upperBound[0] - lowerBound[0]) / smoothingLength));
+  numberY = std::max(1, static_cast<int>((upperBound[1] - lowerBound[1]) / smoothingLength));
+  numberZ = std::max(1, static_cast<int>((upperBound[2] - lowerBound[2]) / smoothingLength));
   numberVector = {numberX, numberY, numberZ};
 
   sizeX = (upperBound[0] - lowerBound[0]) / numberX;
@@ -87,70 +143,69 @@ void Grid::update_grid() {
   sizeZ = (upperBound[2] - lowerBound[2]) / numberZ;
   sizesVector = {sizeX, sizeY, sizeZ};
   densTransConstant =
-      (threeonefive / sixtyfour * M_PI * slNinth) * particleMass;
-  accTransConstant1 = (fifteen / M_PI * slSixth) *
-                      ((3 * particleMass * Constants::stiffnessPressure) / 2);
+      (threeonefive / (sixtyfour * M_PI * slNinth)) * particleMass;
+  accTransConstant1 = (fifteen / (M_PI * slSixth)) *
+                      ((3 * particleMass * config.stiffnessPressure) / 2);
   accTransConstant2 =
-      (fourtyfive / M_PI * slSixth) * Constants::viscosity * particleMass;
-}
-
-// Find the block that a particle belongs in
-// ** NEED TO ACCOUNT FOR EDGE CASES OF SURPASSING BOUNDARIES
-std::vector<int> Grid::findBlock(Particle part) {
-  std::vector<float> position = part.get_position();
-  position = moveParticleInBounds(position);
-  // Now, need to find the specific block a particle occupies
-  // by finding which block index the particle has in all three dimensions
-  std::vector<int> blockIndices = {0, 0, 0};
-  for (int i = 0; i < 3; i++) {
-    blockIndices[i] = static_cast<int>(
-        (position[i] - Constants::getBoxLowerBound()[i]) / sizesVector[i]);
+      (fourtyfive / (M_PI * slSixth)) * config.viscosity * particleMass;
+
+  // Build the dense block array, link every block to its neighbours through
+  // the stencil and place any particles already loaded
+  int const numBlocks = numberX * numberY * numberZ;
+  stencil = NeighbourStencil(numberVector);
+  blocks.clear();
+  blocks.reserve(static_cast<std::size_t>(numBlocks));
+  for (int block = 0; block < numBlocks; block++) {
+    auto const coords = blockCoordinates(block);
+    blocks.emplace_back(std::vector<int>{coords[0], coords[1], coords[2]});
+    blocks.back().setNeighbours(stencil.get_offsets(), stencil.neighbourSlots(block));
   }
-  // We must now check that these block coordinates obey their appropriate
-  // boundaries
-  for (int i = 0; i < 3; i++) {
-    if (blockIndices[i] < 0) {
-      blockIndices[i] = 0;
-    } else if (blockIndices[i] > (numberVector[i] - 1)) {
-      blockIndices[i] = static_cast<int>(numberVector[i] - 1);
+
+  // Group the rows by colour
+  colourRows.clear();
+  colourStart[0] = 0;
+  for (int colour = 0; colour < numColours; colour++) {
+    for (int iz = colour / 3; iz < numberZ; iz += 2) {
+      for (int iy = colour % 3; iy < numberY; iy += 3) {
+        colourRows.push_back(blockIndex(0, iy, iz));
+      }
     }
+    colourStart[static_cast<std::size_t>(colour) + 1] = static_cast<int>(colourRows.size());
   }
-  return blockIndices;
+  set_cellOrder(cellOrder);
+  repositionParticles();
 }
 
-std::vector<float> Grid::moveParticleInBounds(std::vector<float> position) {
-  for (int i = 0; i < 3; i++) {
-    if (position[i] > Constants::getBoxUpperBound()[i]) {
-      position[i] = static_cast<float>(Constants::getBoxUpperBound()[i]);
-    } else if (position[i] < Constants::getBoxLowerBound()[i]) {
-      position[i] = static_cast<float>(Constants::getBoxLowerBound()[i]);
-    }
-  }
+// Find the block that a particle belongs in
+std::vector<int> Grid::findBlock(const Particle &part) const {
+  // Find which block index the particle has in all three dimensions
+  return {findAxisIndex(part.get_px(), 0), findAxisIndex(part.get_py(), 1),
+          findAxisIndex(part.get_pz(), 2)};
+}
 
-  return position;
+int Grid::findBlockIndex(int part) const {
+  auto const idx = static_cast<std::size_t>(part);
+  return blockIndex(findAxisIndex(particles.px[idx], 0), findAxisIndex(particles.py[idx], 1),
+                    findAxisIndex(particles.pz[idx], 2));
 }
 
-void Grid::findAdjBlocks(Block centerBlock) const {
-  std::vector<int> centerIndex = centerBlock.get_index();
-  // std::unordered_map<std::vector<int>, Block, hashing::vHash> blockDict;
-
-  for (int i = -1; i <= 1; i++) {
-    for (int j = -1; j <= 1; j++) {
-      for (int k = -1; k <= 1; k++) {
-        int const newX = centerIndex[0] + i;
-        int const newY = centerIndex[1] + j;
-        int const newZ = centerIndex[2] + k;
-
-        // Want to add a check here to see if the potential adjacent blocks
-        // actually exist within the grid If it does, we want to add it to the
-        // result
-        if (newX >= 0 && newX <= (numberX - 1) && newY >= 0 &&
-            newY <= (numberY - 1) && newZ >= 0 && newZ <= (numberZ - 1)) {
-          std::vector<int> const adjBlockIndex = {newX, newY, newZ};
-          Block const adjBlock(adjBlockIndex);
-          { centerBlock.addAdjacentBlock(adjBlock); }
-        }
-      }
-    }
+// Block index of a coordinate along one axis, clamped to the grid
+int Grid::findAxisIndex(ParticleStore::Real coord, int axis) const {
+  auto const dim = static_cast<std::size_t>(axis);
+  double const lower = config.boxLowerBound[dim];
+  double const upper = config.boxUpperBound[dim];
+  if (coord > upper) {
+    coord = static_cast<ParticleStore::Real>(upper);
+  } else if (coord < lower) {
+    coord = static_cast<ParticleStore::Real>(lower);
+  }
+  auto index = static_cast<int>((coord - lower) / sizesVector[dim]);
+  // We must now check that the block coordinate obeys its boundaries
+  if (index < 0) {
+    index = 0;
+  } else if (index > numberVector[dim] - 1) {
+    index = numberVector[dim] - 1;
   }
+  return index;
 }
+
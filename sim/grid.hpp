@@ -1,17 +1,50 @@
 #ifndef GRID_HPP
 #define GRID_HPP
 #include "block.hpp"
+#include "cell_order.hpp"
 #include "constants.hpp"
-#include "hash.cpp"
+#include "neighbour_stencil.hpp"
+#include "particle_store.hpp"
+#include "simulation_config.hpp"
+#include <array>
 #include <iostream>
 #include <ostream>
-#include <unordered_map>
+#include <span>
+#include <vector>
 
 // Grid class
 class Grid {
 private:
-  // All the blocks in the grid
-  std::unordered_map<std::vector<int>, Block, hashing::vHash> blocks;
+  // All the blocks in the grid, stored densely by linear block index
+  // ix + numberX * (iy + numberY * iz)
+  std::vector<Block> blocks;
+
+  // Neighbours of every block, as offsets of linear indices
+  NeighbourStencil stencil;
+
+  // Every particle of the simulation, sorted by block rank so that each block
+  // is a contiguous range
+  ParticleStore particles;
+
+  // Layout of the blocks in the particle store: the particles of the block
+  // with rank r come after those of ranks below r. blockOrder lists the
+  // blocks by rank
+  CellOrder cellOrder{CellOrder::linear};
+  std::vector<int> blockRank;
+  std::vector<int> blockOrder;
+
+  // Blocks that touch a face of the grid, in the order of their particles.
+  // Only their particles can collide with the walls
+  std::vector<int> boundaryBlocks;
+
+  // Scratch space for repositioning, kept between steps to reuse its memory
+  ParticleStore reordered;
+  std::vector<int> particleRank;
+  std::vector<int> rankStart;
+  std::vector<int> destination;
+
+  // Constants and tank of the simulation
+  SimulationConfig config;
 
   // Information from initial file and the simulation constants that depend on
   // them
@@ -20,16 +53,16 @@ private:
   int count{}; // number of particles counted
 
   // Number of blocks in each dimension
-  double numberX{};
-  double numberY{};
-  double numberZ{};
-  std::vector<double> numberVector;
+  int numberX{};
+  int numberY{};
+  int numberZ{};
+  std::array<int, 3> numberVector{};
 
   // The size of grid blocks in each dimension
   double sizeX{};
   double sizeY{};
   double sizeZ{};
-  std::vector<double> sizesVector;
+  std::array<double, 3> sizesVector{};
 
   // Simulation parameters
   double particleMass{};
@@ -48,7 +81,7 @@ private:
 
 public:
   // Constructor and Destructor
-  explicit Grid(float ppm, int np);
+  explicit Grid(float ppm, int np, SimulationConfig const &config = defaultConfig);
   ~Grid();
 
   // Delete the copy constructor and copy assignment operator
@@ -60,8 +93,13 @@ public:
   Grid &operator=(Grid &&) = delete;
 
   // Getters and setters for each variable
-  [[nodiscard]] std::unordered_map<std::vector<int>, Block, hashing::vHash>
-  get_blocks() const;
+  [[nodiscard]] std::vector<Block> const & get_blocks() const;
+  std::vector<Block> & get_blocks();
+
+  [[nodiscard]] ParticleStore const & get_particles() const;
+  ParticleStore & get_particles();
+
+  [[nodiscard]] SimulationConfig const & get_config() const;
 
   [[nodiscard]] float get_ppm() const;
   [[nodiscard]] int get_np() const;
@@ -72,9 +110,10 @@ public:
   [[nodiscard]] double get_particleMass() const;
   [[nodiscard]] double get_smoothingLength() const;
 
-  [[nodiscard]] double get_numberX() const;
-  [[nodiscard]] double get_numberY() const;
-  [[nodiscard]] double get_numberZ() const;
+  [[nodiscard]] int get_numberX() const;
+  [[nodiscard]] int get_numberY() const;
+  [[nodiscard]] int get_numberZ() const;
+  [[nodiscard]] int get_numBlocks() const;
 
   [[nodiscard]] double get_sizeX() const;
   [[nodiscard]] double get_sizeY() const;
@@ -88,21 +127,65 @@ public:
   [[nodiscard]] double get_densTransConstant() const;
   [[nodiscard]] double get_accTransConstant1() const;
   [[nodiscard]] double get_accTransConstant2() const;
+  [[nodiscard]] KernelConstants get_kernelConstants() const;
+
+  // Order of the blocks in the particle store; takes effect on the next
+  // repositioning
+  [[nodiscard]] CellOrder get_cellOrder() const;
+  void set_cellOrder(CellOrder order);
+
+  // Linear indices of the blocks in the order of their particles
+  [[nodiscard]] std::span<int const> get_blockOrder() const;
 
-  // Finds adjacent blocks
-  void findAdjBlocks(Block centerBlock) const;
+  // Linear indices of the blocks on the faces, edges and corners of the
+  // grid, in the order of their particles; the others are interior blocks
+  [[nodiscard]] std::span<int const> get_boundaryBlocks() const;
+
+  // Rows of blocks along x are coloured by (iy mod 3, iz mod 2). Visiting
+  // pairs symmetrically, a row updates the rows at most one away in y and
+  // one forward in z, so rows of the same colour never update the same block
+  static constexpr int numColours = 6;
+
+  // Rows of one colour, by the linear index of their first block
+  [[nodiscard]] std::span<int const> get_colourRows(int colour) const;
+
+  // Linear index of the block with coordinates (ix, iy, iz)
+  [[nodiscard]] int blockIndex(int ix, int iy, int iz) const {
+    return ix + numberX * (iy + numberY * iz);
+  }
+
+  // Coordinates of the block with linear index block
+  [[nodiscard]] std::array<int, 3> blockCoordinates(int block) const {
+    return {block % numberX, (block / numberX) % numberY, block / (numberX * numberY)};
+  }
+
+  // Adjacency of the blocks, built with them by update_grid
+  [[nodiscard]] NeighbourStencil const & get_stencil() const;
 
   // block functions
   void add_particle_to_block(const Particle &p);
 
+  // Sort the particles by block rank and update the range of every block
+  void repositionParticles();
+
   // Update variables
   void update_grid();
 
   // Find the block that a particle belongs in
-  std::vector<int> findBlock(Particle part);
+  [[nodiscard]] std::vector<int> findBlock(const Particle &part) const;
+
+  // Linear index of the block that the particle at index part belongs in
+  [[nodiscard]] int findBlockIndex(int part) const;
 
-  // Helper function for findBlock
-  static std::vector<float> moveParticleInBounds(std::vector<float> position);
+  // Helper function for findBlock: block index along one axis, with the
+  // coordinate moved in bounds first
+  [[nodiscard]] int findAxisIndex(ParticleStore::Real coord, int axis) const;
+
+private:
+  // Rows of blocks along x (by the linear index of their first block)
+  // grouped by colour
+  std::vector<int> colourRows;
+  std::array<int, numColours + 1> colourStart{};
 };
 
 #endif // GRID_HPP
@@ -0,0 +1,41 @@
+#include "mapped_file.hpp"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+
+MappedFile::MappedFile(std::string const &filename) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+  int const descriptor = ::open(filename.c_str(), O_RDONLY);
+  if (descriptor < 0) { throw std::system_error(errno, std::generic_category(), filename); }
+  struct stat status {};
+  if (::fstat(descriptor, &status) != 0) {
+    int const error = errno;
+    ::close(descriptor);
+    throw std::system_error(error, std::generic_category(), filename);
+  }
+  length = static_cast<std::size_t>(status.st_size);
+  // An empty file cannot be mapped, and has no bytes to read anyway
+  if (length > 0) {
+    address = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    if (address == MAP_FAILED) {
+      int const error = errno;
+      ::close(descriptor);
+      throw std::system_error(error, std::generic_category(), filename);
+    }
+    // The file is decoded front to back once
+    ::madvise(address, length, MADV_SEQUENTIAL);
+  }
+  ::close(descriptor);
+}
+
+MappedFile::~MappedFile() {
+  if (length > 0) { ::munmap(address, length); }
+}
+
+std::span<std::byte const> MappedFile::bytes() const {
+  return {static_cast<std::byte const *>(address), length};
+}
@@ -0,0 +1,27 @@
+#ifndef FLUID_MAPPED_FILE_HPP
+#define FLUID_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <span>
+#include <string>
+
+// Read-only memory mapping of a whole file, unmapped on destruction.
+// Throws std::system_error if the file cannot be opened or mapped
+class MappedFile {
+public:
+  explicit MappedFile(std::string const &filename);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile(MappedFile &&) = delete;
+  MappedFile &operator=(MappedFile &&) = delete;
+
+  [[nodiscard]] std::span<std::byte const> bytes() const;
+
+private:
+  void *address{};
+  std::size_t length{};
+};
+
+#endif  // FLUID_MAPPED_FILE_HPP
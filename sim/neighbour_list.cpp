@@ -0,0 +1,175 @@
+#include "neighbour_list.hpp"
+
+#include "profiler.hpp"
+#include "simd_kernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+NeighbourList::NeighbourList(double skin) : skin(skin) {}
+
+double NeighbourList::get_skin() const { return skin; }
+
+int NeighbourList::get_numCandidates() const { return static_cast<int>(listEntries.size()); }
+
+int NeighbourList::get_numRebuilds() const { return numRebuilds; }
+
+std::span<int const> NeighbourList::neighbours(int part) const {
+  auto const idx = static_cast<std::size_t>(part);
+  auto const first = static_cast<std::size_t>(listStart[idx]);
+  auto const last = static_cast<std::size_t>(listStart[idx + 1]);
+  return std::span<int const>(listEntries).subspan(first, last - first);
+}
+
+// Compare the squared displacements with the squared limit of the last build
+bool NeighbourList::needsRebuild(ParticleStore const &store) const {
+  auto const numParts = static_cast<std::size_t>(store.size());
+  if (builtX.size() != numParts) { return true; }
+  for (std::size_t part = 0; part < numParts; part++) {
+    double const xDiff = static_cast<double>(store.px[part]) - builtX[part];
+    double const yDiff = static_cast<double>(store.py[part]) - builtY[part];
+    double const zDiff = static_cast<double>(store.pz[part]) - builtZ[part];
+    if (xDiff * xDiff + yDiff * yDiff + zDiff * zDiff > limitSq) { return true; }
+  }
+  return false;
+}
+
+template <typename Function>
+void NeighbourList::forEachCandidate(Grid const &grid, int block, int part,
+                                     Function function) const {
+  ParticleStore const &store = grid.get_particles();
+  auto const idx = static_cast<std::size_t>(part);
+  double const radius = grid.get_smoothingLength() + skin;
+  double const radiusSq = radius * radius;
+  std::array<double, 3> const sizes = {grid.get_sizeX(), grid.get_sizeY(), grid.get_sizeZ()};
+  std::array<int, 3> const numbers = {grid.get_numberX(), grid.get_numberY(), grid.get_numberZ()};
+  auto const coords = grid.blockCoordinates(block);
+  std::array<int, 3> lower{};
+  std::array<int, 3> upper{};
+  for (std::size_t axis = 0; axis < 3; axis++) {
+    int const reach = static_cast<int>(std::ceil(radius / sizes[axis]));
+    lower[axis] = std::max(coords[axis] - reach, 0);
+    upper[axis] = std::min(coords[axis] + reach, numbers[axis] - 1);
+  }
+
+  for (int k = lower[2]; k <= upper[2]; k++) {
+    for (int j = lower[1]; j <= upper[1]; j++) {
+      for (int i = lower[0]; i <= upper[0]; i++) {
+        auto const adjBlock = static_cast<std::size_t>(grid.blockIndex(i, j, k));
+        Block const &adjObj = grid.get_blocks()[adjBlock];
+        for (int other = adjObj.get_begin(); other < adjObj.get_end(); other++) {
+          auto const otherIdx = static_cast<std::size_t>(other);
+          double const xDiff = static_cast<double>(store.px[idx]) - store.px[otherIdx];
+          double const yDiff = static_cast<double>(store.py[idx]) - store.py[otherIdx];
+          double const zDiff = static_cast<double>(store.pz[idx]) - store.pz[otherIdx];
+          if (other != part and xDiff * xDiff + yDiff * yDiff + zDiff * zDiff < radiusSq) {
+            function(other);
+          }
+        }
+      }
+    }
+  }
+}
+
+// Count the neighbours of every particle, turn the counts into list starts
+// with a prefix sum and fill the lists; both passes run over the blocks in
+// the order of their particles
+void NeighbourList::rebuild(Grid &grid, ThreadPool &pool) {
+  grid.repositionParticles();
+  ParticleStore const &store = grid.get_particles();
+  std::vector<Block> const &blocks = grid.get_blocks();
+  std::span<int const> const order = grid.get_blockOrder();
+  auto const numParts = static_cast<std::size_t>(store.size());
+  auto const blockWeight = [&blocks, order](int rank) {
+    return blocks[static_cast<std::size_t>(order[static_cast<std::size_t>(rank)])].size() + 1;
+  };
+
+  listStart.assign(numParts + 1, 0);
+  pool.parallelFor(
+      grid.get_numBlocks(),
+      [this, &grid, &blocks, order](int begin, int end) {
+        for (int rank = begin; rank < end; rank++) {
+          int const block = order[static_cast<std::size_t>(rank)];
+          Block const &blockObj = blocks[static_cast<std::size_t>(block)];
+          for (int part = blockObj.get_begin(); part < blockObj.get_end(); part++) {
+            int count = 0;
+            forEachCandidate(grid, block, part, [&count](int /*other*/) { count++; });
+            listStart[static_cast<std::size_t>(part) + 1] = count;
+          }
+        }
+      },
+      blockWeight);
+  std::partial_sum(listStart.begin(), listStart.end(), listStart.begin());
+
+  listEntries.resize(static_cast<std::size_t>(listStart.back()));
+  pool.parallelFor(
+      grid.get_numBlocks(),
+      [this, &grid, &blocks, order](int begin, int end) {
+        for (int rank = begin; rank < end; rank++) {
+          int const block = order[static_cast<std::size_t>(rank)];
+          Block const &blockObj = blocks[static_cast<std::size_t>(block)];
+          for (int part = blockObj.get_begin(); part < blockObj.get_end(); part++) {
+            auto next = static_cast<std::size_t>(listStart[static_cast<std::size_t>(part)]);
+            forEachCandidate(grid, block, part,
+                             [this, &next](int other) { listEntries[next++] = other; });
+          }
+        }
+      },
+      blockWeight);
+
+  builtX.assign(store.px.begin(), store.px.end());
+  builtY.assign(store.py.begin(), store.py.end());
+  builtZ.assign(store.pz.begin(), store.pz.end());
+  // Half the skin keeps every pair in the lists; a block less the particle
+  // size keeps the particles of interior blocks away from the walls
+  double const minBlock = std::min({grid.get_sizeX(), grid.get_sizeY(), grid.get_sizeZ()});
+  double const limit =
+      std::max(std::min(skin / 2, minBlock - grid.get_config().particleSize), 0.0);
+  limitSq = limit * limit;
+  numRebuilds++;
+  profile::count(Counter::verletRebuilds);
+  profile::count(Counter::verletEntries, std::ssize(listEntries));
+}
+
+void NeighbourList::incDensity(ParticleStore &store, int part, double slSq) const {
+  auto const idx = static_cast<std::size_t>(part);
+  double increase = 0.0;
+  std::int64_t inside = 0;
+  for (auto const other : neighbours(part)) {
+    auto const otherIdx = static_cast<std::size_t>(other);
+    double const xDiff = static_cast<double>(store.px[idx]) - store.px[otherIdx];
+    double const yDiff = static_cast<double>(store.py[idx]) - store.py[otherIdx];
+    double const zDiff = static_cast<double>(store.pz[idx]) - store.pz[otherIdx];
+    double const diffSum = xDiff * xDiff + yDiff * yDiff + zDiff * zDiff;
+    if (diffSum < slSq) {
+      double const diff = slSq - diffSum;
+      increase += diff * diff * diff;
+      inside++;
+    }
+  }
+  store.density[idx] += increase;
+  profile::count(Counter::candidatePairs, std::ssize(neighbours(part)));
+  profile::count(Counter::pairsInside, inside);
+}
+
+void NeighbourList::accelerationTransfer(ParticleStore &store, int part,
+                                         KernelConstants const &constants) const {
+  auto const idx = static_cast<std::size_t>(part);
+  std::array<double, 3> change = {0.0, 0.0, 0.0};
+  for (auto const other : neighbours(part)) {
+    auto const otherIdx = static_cast<std::size_t>(other);
+    double const xDiff = static_cast<double>(store.px[idx]) - store.px[otherIdx];
+    double const yDiff = static_cast<double>(store.py[idx]) - store.py[otherIdx];
+    double const zDiff = static_cast<double>(store.pz[idx]) - store.pz[otherIdx];
+    if (xDiff * xDiff + yDiff * yDiff + zDiff * zDiff < constants.slSq) {
+      auto const accChange = simd::pairAcceleration(store, part, other, constants);
+      change[0] += accChange[0];
+      change[1] += accChange[1];
+      change[2] += accChange[2];
+    }
+  }
+  store.ax[idx] += change[0];
+  store.ay[idx] += change[1];
+  store.az[idx] += change[2];
+}
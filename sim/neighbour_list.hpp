@@ -0,0 +1,71 @@
+#ifndef FLUID_NEIGHBOUR_LIST_HPP
+#define FLUID_NEIGHBOUR_LIST_HPP
+
+#include "constants.hpp"
+#include "grid.hpp"
+#include "particle_store.hpp"
+#include "thread_pool.hpp"
+
+#include <span>
+#include <vector>
+
+// Verlet lists: every particle keeps the particles within the smoothing
+// length plus a skin. While no particle has moved more than half the skin
+// since the lists were built, no pair closer than the smoothing length can
+// be missing from them, so the lists replace the scan of the adjacent blocks.
+// The lists hold particle indices, so the particles must not be repositioned
+// between rebuilds. The wall stages only visit the boundary blocks of the
+// last repositioning, so the lists are also rebuilt before a particle can
+// have moved from an interior block to within its size of a wall
+class NeighbourList {
+public:
+  // skin in the units of the positions
+  explicit NeighbourList(double skin);
+
+  [[nodiscard]] double get_skin() const;
+
+  // Whether some particle moved more than half the skin, or more than a
+  // block less the particle size, since the last build (or the lists were
+  // never built)
+  [[nodiscard]] bool needsRebuild(ParticleStore const &store) const;
+
+  // Reposition the particles and build the list of every particle from the
+  // blocks within the smoothing length plus the skin
+  void rebuild(Grid &grid, ThreadPool &pool = ThreadPool::serial());
+
+  // Neighbours of the particle at index part
+  [[nodiscard]] std::span<int const> neighbours(int part) const;
+
+  // Increasing density of a particle from every neighbour in its list
+  void incDensity(ParticleStore &store, int part, double slSq) const;
+
+  // Transferring accelerations to a particle from every neighbour in its list
+  void accelerationTransfer(ParticleStore &store, int part,
+                            KernelConstants const &constants) const;
+
+  // Entries in all the lists, and number of rebuilds so far
+  [[nodiscard]] int get_numCandidates() const;
+  [[nodiscard]] int get_numRebuilds() const;
+
+private:
+  // Calls function(j) for every particle j != part within the list radius,
+  // looking in the blocks up to reach blocks away
+  template <typename Function>
+  void forEachCandidate(Grid const &grid, int block, int part, Function function) const;
+
+  double skin;
+  int numRebuilds{};
+  // Square of the displacement that triggers a rebuild
+  double limitSq{};
+
+  // The list of particle i is listEntries[listStart[i], listStart[i + 1])
+  std::vector<int> listStart;
+  std::vector<int> listEntries;
+
+  // Positions when the lists were built
+  AlignedVector<ParticleStore::Real> builtX;
+  AlignedVector<ParticleStore::Real> builtY;
+  AlignedVector<ParticleStore::Real> builtZ;
+};
+
+#endif  // FLUID_NEIGHBOUR_LIST_HPP
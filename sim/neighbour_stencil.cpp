@@ -0,0 +1,42 @@
+#include "neighbour_stencil.hpp"
+
+NeighbourStencil::NeighbourStencil(std::array<int, 3> const &numbers)
+    : offsets(static_cast<std::size_t>(numSlots)) {
+  // Offsets and the faces that rule every slot out: a step down an axis
+  // leaves the grid at its lower face, a step up at its upper face
+  std::array<std::uint8_t, numSlots> blockedBy{};
+  for (int dz = -1; dz <= 1; dz++) {
+    for (int dy = -1; dy <= 1; dy++) {
+      for (int dx = -1; dx <= 1; dx++) {
+        auto const slot = static_cast<std::size_t>((dx + 1) + 3 * (dy + 1) + 9 * (dz + 1));
+        offsets[slot] = dx + numbers[0] * (dy + numbers[1] * dz);
+        std::array<int, 3> const steps = {dx, dy, dz};
+        for (std::size_t axis = 0; axis < 3; axis++) {
+          if (steps[axis] < 0) { blockedBy[slot] |= lowerFace(axis); }
+          if (steps[axis] > 0) { blockedBy[slot] |= upperFace(axis); }
+        }
+      }
+    }
+  }
+  for (std::size_t faces = 0; faces < numFaceMasks; faces++) {
+    for (std::size_t slot = 0; slot < numSlots; slot++) {
+      if ((blockedBy[slot] & faces) == 0) { faceSlots[faces] |= 1U << slot; }
+    }
+  }
+
+  // Faces of every block, in linear index order
+  blockFaces.reserve(static_cast<std::size_t>(numbers[0] * numbers[1] * numbers[2]));
+  for (int iz = 0; iz < numbers[2]; iz++) {
+    for (int iy = 0; iy < numbers[1]; iy++) {
+      for (int ix = 0; ix < numbers[0]; ix++) {
+        std::array<int, 3> const coords = {ix, iy, iz};
+        std::uint8_t faces = 0;
+        for (std::size_t axis = 0; axis < 3; axis++) {
+          if (coords[axis] == 0) { faces |= lowerFace(axis); }
+          if (coords[axis] == numbers[axis] - 1) { faces |= upperFace(axis); }
+        }
+        blockFaces.push_back(faces);
+      }
+    }
+  }
+}
@@ -0,0 +1,71 @@
+#ifndef FLUID_NEIGHBOUR_STENCIL_HPP
+#define FLUID_NEIGHBOUR_STENCIL_HPP
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Adjacency of the blocks of a grid as a table instead of per-block lists.
+// The 27 blocks around a block are slots (dx + 1) + 3 (dy + 1) + 9 (dz + 1),
+// each with the difference of linear indices it is at. Which slots lie
+// inside the grid only depends on the faces the block touches, so a block
+// keeps a byte of faces and its neighbours are a mask of slots: O(blocks)
+// memory, and every neighbour is its block's index plus an offset
+class NeighbourStencil {
+public:
+  static constexpr int numSlots = 27;
+  static constexpr int centreSlot = 13;
+  static constexpr int numFaceMasks = 64;
+
+  // Bits of the faces of the grid a block touches: the lower and the upper
+  // face of each axis
+  static constexpr std::uint8_t lowerFace(std::size_t axis) {
+    return static_cast<std::uint8_t>(1U << (2 * axis));
+  }
+  static constexpr std::uint8_t upperFace(std::size_t axis) {
+    return static_cast<std::uint8_t>(2U << (2 * axis));
+  }
+  static constexpr std::uint8_t allFaces = numFaceMasks - 1;
+
+  // Slots with a larger linear index than the centre (half of the
+  // neighbours), so visiting them visits every pair of blocks once
+  static constexpr std::uint32_t forwardSlots = ((1U << numSlots) - 1) & ~((2U << centreSlot) - 1);
+
+  NeighbourStencil() = default;
+
+  // Stencil of a grid of numbers[0] x numbers[1] x numbers[2] blocks
+  explicit NeighbourStencil(std::array<int, 3> const &numbers);
+
+  // Differences of linear indices of the slots. They live on the heap, so a
+  // span of them stays valid when the stencil is moved
+  [[nodiscard]] std::span<int const> get_offsets() const { return offsets; }
+
+  // Faces of the grid that a block touches
+  [[nodiscard]] std::uint8_t faces(int block) const {
+    return blockFaces[static_cast<std::size_t>(block)];
+  }
+
+  // Slots inside the grid for a block touching faces (including the centre)
+  [[nodiscard]] std::uint32_t slots(std::uint8_t faces) const { return faceSlots[faces]; }
+
+  // Slots inside the grid around a block
+  [[nodiscard]] std::uint32_t neighbourSlots(int block) const { return slots(faces(block)); }
+
+  // Blocks around block (including itself) in increasing linear index
+  template <typename Function>
+  void forEachNeighbour(int block, Function function) const {
+    for (std::uint32_t mask = neighbourSlots(block); mask != 0; mask &= mask - 1) {
+      function(block + offsets[static_cast<std::size_t>(std::countr_zero(mask))]);
+    }
+  }
+
+private:
+  std::vector<int> offsets;
+  std::array<std::uint32_t, numFaceMasks> faceSlots{};
+  std::vector<std::uint8_t> blockFaces;
+};
+
+#endif  // FLUID_NEIGHBOUR_STENCIL_HPP
@@ -2,104 +2,205 @@
 
 using namespace std;
 
-template <typename T>
-  requires(std::is_integral_v<T> or std::is_floating_point_v<T>)
-char *as_writable_buffer(T &value) {
-  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-  return reinterpret_cast<char *>(&value);
-}
-
-template <typename T>
-  requires(std::is_integral_v<T> or std::is_floating_point_v<T>)
-char const *as_buffer(T const &value) {
-  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-  return reinterpret_cast<char const *>(&value);
-}
-
-template <typename T>
-  requires(std::is_integral_v<T> or std::is_floating_point_v<T>)
-T read_binary_value(std::istream &is) {
-  T value{};
-  is.read(as_writable_buffer(value), sizeof(value));
-  return value;
-}
-
-template <typename T>
-  requires(std::is_integral_v<T> or std::is_floating_point_v<T>)
-void write_binary_value(T value, std::ostream &os) {
-  os.write(as_buffer(value), sizeof(value));
-}
-
-int parser(std::array<char *, 4> args) {
-  int const nts = std::stoi(args[1]); // number of time steps
-  std::string const inputfile = args[2];
-  std::string const outputfile = args[3];
-
-  // Read input file
-  Grid grid = readInput(inputfile);
+int parser(ProgramOptions const &options) {
+  // Read input file, or the checkpoint to restart from and the steps it
+  // has done
+  ThreadPool pool(options.threads);
+  std::optional<Profiler> profiler;
+  if (not options.profileFile.empty()) { profiler.emplace(); }
+  if (profiler and options.perfCounters and not profiler->enablePerfCounters(pool)) {
+    std::cerr << "Warning: Hardware counters unavailable (" << profiler->get_perfError()
+              << "), profiling without them\n";
+  }
+  Profiler *const profiled = profiler ? &*profiler : nullptr;
+  std::optional<Grid> input;
+  int firstStep = 0;
+  try {
+    if (options.restartFile.empty()) {
+      SimulationConfig const config =
+          options.configFile.empty() ? defaultConfig : readConfig(options.configFile);
+      input.emplace(readInput(options.inputFile, profiled, config));
+    } else {
+      PhaseTimer const timer(profiled, Phase::read);
+      input.emplace(readCheckpoint(options.restartFile, firstStep));
+    }
+  } catch (std::exception const &error) {
+    std::cerr << "Error: " << error.what() << '\n';
+    return -1;
+  }
+  Grid &grid = *input;
+  if (options.cellOrder != grid.get_cellOrder()) {
+    grid.set_cellOrder(options.cellOrder);
+    grid.repositionParticles();
+  }
 
   // Print parameters and simulation
   if (printParameters(grid) == 1) {
     // simulation here
-    for (int i = 0; i < nts; i++) {
-      simulateOneStep(grid);
+    std::optional<SnapshotWriter> snapshots;
+    try {
+      if (options.dumpEvery > 0) {
+        // Positions are quantized within the tank of the run
+        ArchiveParameters parameters;
+        parameters.boxLowerBound = grid.get_config().boxLowerBound;
+        parameters.boxUpperBound = grid.get_config().boxUpperBound;
+        snapshots.emplace(options.outputFile, options.dumpFormat, parameters);
+      }
+    } catch (std::exception const &error) {
+      std::cerr << "Error: " << error.what() << '\n';
+      return -1;
     }
+    // Traces go next to the output file
+    std::optional<StageTracer> tracer;
+    if (not options.traceStage.empty()) {
+      std::optional<TraceStage> stage;
+      if (options.traceStage != "all") { parseTraceStage(options.traceStage, stage.emplace()); }
+      tracer.emplace(std::filesystem::path(options.outputFile).parent_path().string(), stage,
+                     options.traceFirstStep, options.traceLastStep);
+    }
+    StageTracer *const traced = tracer ? &*tracer : nullptr;
+    // After every step, hand a frame to the writer thread every dumpEvery
+    // steps and write a checkpoint every checkpointEvery steps
+    std::vector<std::byte> checkpointBuffer;
+    auto const afterStep = [&options, &grid, &pool, &snapshots, &checkpointBuffer](int step) {
+      if (snapshots and step % options.dumpEvery == 0) { snapshots->submit(grid, step, pool); }
+      if (options.checkpointEvery > 0 and step % options.checkpointEvery == 0) {
+        writeCheckpoint(checkpointName(options.outputFile), grid, step, checkpointBuffer);
+      }
+    };
+    try {
+      if (options.verletSkin > 0) {
+        NeighbourList lists(options.verletSkin * grid.get_smoothingLength());
+        for (int step = firstStep + 1; step <= options.timeSteps; step++) {
+          if (traced != nullptr) { traced->set_step(step); }
+          simulateOneStep(grid, lists, pool, traced, profiled);
+          afterStep(step);
+        }
+      } else {
+        for (int step = firstStep + 1; step <= options.timeSteps; step++) {
+          if (traced != nullptr) { traced->set_step(step); }
+          simulateOneStep(grid, PairMode::symmetric, pool, traced, profiled);
+          afterStep(step);
+        }
+      }
+    } catch (std::system_error const &error) {
+      std::cerr << "Error: " << error.what() << '\n';
+      return -1;
+    }
+    try {
+      if (snapshots) { snapshots->finish(); }
+      if (tracer) { tracer->finish(); }
+    } catch (std::exception const &error) {
+      std::cerr << "Error: " << error.what() << '\n';
+      return -1;
+    }
+    if (options.schedulerStats) { printWorkerStats(pool); }
+    if (options.cacheReport) { printStencilTraffic(grid); }
   }
 
   // Write output file
-  writeOutput(outputfile, grid);
+  try {
+    PhaseTimer const timer(profiled, Phase::write);
+    writeOutput(options.outputFile, grid, pool);
+  } catch (std::system_error const &error) {
+    std::cerr << "Error: " << error.what() << '\n';
+    return -1;
+  }
 
+  if (profiler) { return writeProfile(options, *profiler, grid, options.timeSteps - firstStep); }
   return 0;
 }
 
-// read input file
-Grid readInput(const std::string &inputfile) {
-  std::ifstream input_file(inputfile, std::ios::binary);
-
-  // Read header vales
-  auto ppm = read_binary_value<float>(input_file); // particles per meter
-  int const nump = read_binary_value<int>(input_file);
-
-  // Create and update Grid
-  Grid grid(ppm, nump);
-  grid.update_grid();
-
-  int count = -1; // count number of particles
-
-  while (!input_file.eof()) {
-    count += 1;
-    grid.add_particle_to_block(readParticle(input_file, count));
+// write the profile report to the file of --profile, or to the standard
+// output for "-"
+int writeProfile(ProgramOptions const &options, Profiler const &profiler, Grid const &grid,
+                 int steps) {
+  int const particles = grid.get_particles().size();
+  if (options.profileFile == "-") {
+    profiler.writeReport(std::cout, particles, steps, options.threads);
+    return 0;
   }
-  input_file.close();
-
-  grid.set_count(count);
-  for (const auto &centerBlock : grid.get_blocks()) {
-    grid.findAdjBlocks(centerBlock.second);
+  std::ofstream report(options.profileFile);
+  profiler.writeReport(report, particles, steps, options.threads);
+  if (not report) {
+    std::cerr << "Error: Cannot write the profile to " << options.profileFile << '\n';
+    return -1;
   }
-
-  return grid;
+  return 0;
 }
 
-Particle readParticle(std::ifstream &input_file, int count) {
-  // Read particle values
-  std::vector<float> position;
-  std::vector<float> vectorhv;
-  std::vector<float> velocity;
+namespace {
+  // Bytes of the header (particles per meter, number of particles) and of
+  // every particle record (position, hv and velocity)
+  constexpr std::size_t headerBytes = sizeof(float) + sizeof(int);
+  constexpr std::size_t recordFloats = 9;
+  constexpr std::size_t recordBytes = recordFloats * sizeof(float);
+
+  // Decode whole records straight into the store; particle ids are the
+  // record numbers
+  void decodeParticles(std::span<std::byte const> records, ParticleStore &store,
+                       std::array<double, 3> const &externalAcceleration) {
+    auto const numParts = records.size() / recordBytes;
+    store.resize(static_cast<int>(numParts));
+    for (std::size_t part = 0; part < numParts; part++) {
+      std::array<float, recordFloats> record{};
+      std::memcpy(record.data(), records.subspan(part * recordBytes, recordBytes).data(),
+                  recordBytes);
+      store.id[part] = static_cast<int>(part);
+      store.px[part] = record[0];
+      store.py[part] = record[1];
+      store.pz[part] = record[2];
+      store.hvx[part] = record[3];
+      store.hvy[part] = record[4];
+      store.hvz[part] = record[5];
+      store.vx[part] = record[6];
+      store.vy[part] = record[7];
+      store.vz[part] = record[8];
+      store.density[part] = 0.0;
+      store.ax[part] = static_cast<ParticleStore::Accumulator>(externalAcceleration[0]);
+      store.ay[part] = static_cast<ParticleStore::Accumulator>(externalAcceleration[1]);
+      store.az[part] = static_cast<ParticleStore::Accumulator>(externalAcceleration[2]);
+    }
+  }
+}  // namespace
+
+// read input file: map it, check its size against the header and decode
+// every record in one pass
+Grid readInput(const std::string &inputfile, Profiler *profiler,
+               SimulationConfig const &config) {
+  MappedFile const file(inputfile);
+  std::span<std::byte const> const bytes = file.bytes();
+  if (bytes.size() < headerBytes) {
+    throw std::runtime_error(inputfile + ": file too short for the header");
+  }
 
-  position.push_back(read_binary_value<float>(input_file));
-  position.push_back(read_binary_value<float>(input_file));
-  position.push_back(read_binary_value<float>(input_file));
-  vectorhv.push_back(read_binary_value<float>(input_file));
-  vectorhv.push_back(read_binary_value<float>(input_file));
-  vectorhv.push_back(read_binary_value<float>(input_file));
-  velocity.push_back(read_binary_value<float>(input_file));
-  velocity.push_back(read_binary_value<float>(input_file));
-  velocity.push_back(read_binary_value<float>(input_file));
+  // Read header vales
+  float ppm = 0; // particles per meter
+  int nump = 0;
+  std::memcpy(&ppm, bytes.data(), sizeof(ppm));
+  std::memcpy(&nump, bytes.subspan(sizeof(ppm)).data(), sizeof(nump));
+  auto const records = bytes.subspan(headerBytes);
+  if (records.size() % recordBytes != 0) {
+    throw std::runtime_error(inputfile + ": last particle record is incomplete");
+  }
 
-  // Create particle
-  Particle const part(count, position, vectorhv, velocity);
+  // Create the Grid; a count different from the header is reported by
+  // printParameters
+  Grid grid = [ppm, nump, profiler, &config] {
+    PhaseTimer const timer(profiler, Phase::grid);
+    return Grid(ppm, nump, config);
+  }();
+  {
+    PhaseTimer const timer(profiler, Phase::read);
+    decodeParticles(records, grid.get_particles(), config.externalAcceleration);
+  }
+  {
+    PhaseTimer const timer(profiler, Phase::grid);
+    grid.set_count(grid.get_particles().size());
+    grid.repositionParticles();
+  }
 
-  return part;
+  return grid;
 }
 
 // print parameters
@@ -123,150 +224,72 @@ int printParameters(Grid &grid) {
   return 0;
 }
 
-void writeOutput(const std::string &outputfile, Grid &grid) {
-  std::ofstream output_file(outputfile, std::ios::binary);
-
-  // Sort all the particles
-  std::vector<Particle> particles;
-  for (auto block : grid.get_blocks()) {
-    std::vector<Particle> temp = block.second.getParticles();
-    particles.insert(particles.end(), temp.begin(), temp.end());
-  }
-  mergeSort(particles, 0, static_cast<int>(particles.size() - 1));
-
-  write_binary_value(grid.get_ppm(), output_file);
-  write_binary_value(grid.get_np(), output_file);
-
-  for (const auto &particle : particles) {
-    writeParticle(particle, output_file);
+// print tasks run, tasks stolen and idle time of every worker
+void printWorkerStats(ThreadPool const &pool) {
+  auto const stats = pool.get_stats();
+  for (std::size_t worker = 0; worker < stats.size(); worker++) {
+    std::cout << "Worker " << worker << ": " << stats[worker].tasksRun << " tasks, "
+              << stats[worker].tasksStolen << " stolen, " << stats[worker].idleSeconds
+              << " s idle" << '\n';
   }
-  output_file.close();
 }
 
-void writeParticle(Particle particle, std::ofstream &output_file) {
-  float const posx = particle.get_px();
-  float const posy = particle.get_py();
-  float const posz = particle.get_pz();
-  float const hvx = particle.get_hvx();
-  float const hvy = particle.get_hvy();
-  float const hvz = particle.get_hvz();
-  double const accx = particle.get_ax();
-  double const accy = particle.get_ay();
-  double const accz = particle.get_az();
-
-  write_binary_value(posx, output_file);
-  write_binary_value(posy, output_file);
-  write_binary_value(posz, output_file);
-  write_binary_value(hvx, output_file);
-  write_binary_value(hvy, output_file);
-  write_binary_value(hvz, output_file);
-  write_binary_value(accx, output_file);
-  write_binary_value(accy, output_file);
-  write_binary_value(accz, output_file);
+// print the modelled cache traffic of the density stage
+void printStencilTraffic(Grid const &grid) {
+  StencilTraffic const traffic = stencilTraffic(grid);
+  std::cout << "Density stencil: " << traffic.lines << " lines, " << traffic.l1Misses
+            << " L1 misses, " << traffic.l2Misses << " L2 misses" << '\n';
 }
 
-// Merge sort ascending order by particle.get_id()
-void merge(std::vector<Particle> &particles, int left, int middle, int right) {
-  int const num1 = middle - left + 1;
-  int const num2 = right - middle;
-
-  std::vector<Particle> lll(particles.begin() + left,
-                            particles.begin() + left + num1);
-  std::vector<Particle> rrr(particles.begin() + middle + 1,
-                            particles.begin() + middle + 1 + num2);
-
-  int iii = 0;
-  int jjj = 0;
-  int kkk = left;
+// Fill buffer with the output file: the header, then the record of every
+// particle at the position of its id. Ids are dense, so this is a single
+// scatter and needs no sort
+void encodeOutput(Grid const &grid, std::vector<std::byte> &buffer, ThreadPool &pool) {
+  ParticleStore const &store = grid.get_particles();
+  buffer.resize(headerBytes + static_cast<std::size_t>(store.size()) * recordBytes);
+  float const ppm = grid.get_ppm();
+  int const nump = grid.get_np();
+  std::memcpy(buffer.data(), &ppm, sizeof(ppm));
+  std::memcpy(&buffer[sizeof(ppm)], &nump, sizeof(nump));
+
+  pool.parallelFor(store.size(), [&store, &buffer](int begin, int end) {
+    for (auto part = static_cast<std::size_t>(begin); part < static_cast<std::size_t>(end);
+         part++) {
+      auto const value = [&store, part](AlignedVector<ParticleStore::Real> const &array) {
+        return static_cast<float>(array[part]);
+      };
+      std::array<float, recordFloats> const record{
+          value(store.px),  value(store.py),  value(store.pz),
+          value(store.hvx), value(store.hvy), value(store.hvz),
+          value(store.vx),  value(store.vy),  value(store.vz)};
+      auto const offset = headerBytes + static_cast<std::size_t>(store.id[part]) * recordBytes;
+      std::memcpy(&buffer[offset], record.data(), recordBytes);
+    }
+  });
+}
 
-  while (iii < num1 && jjj < num2) {
-    particles[kkk++] =
-        (lll[iii].get_id() <= rrr[jjj].get_id()) ? lll[iii++] : rrr[jjj++];
+// Write the whole buffer with as few write calls as the kernel allows
+void writeBuffer(const std::string &outputfile, std::span<std::byte const> bytes) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-vararg)
+  int const descriptor = ::open(outputfile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (descriptor < 0) { throw std::system_error(errno, std::generic_category(), outputfile); }
+  while (not bytes.empty()) {
+    ssize_t const written = ::write(descriptor, bytes.data(), bytes.size());
+    if (written < 0) {
+      if (errno == EINTR) { continue; }
+      int const error = errno;
+      ::close(descriptor);
+      throw std::system_error(error, std::generic_category(), outputfile);
+    }
+    bytes = bytes.subspan(static_cast<std::size_t>(written));
   }
-
-  while (iii < num1) {
-    particles[kkk++] = lll[iii++];
-  }
-
-  while (jjj < num2) {
-    particles[kkk++] = rrr[jjj++];
+  if (::close(descriptor) != 0) {
+    throw std::system_error(errno, std::generic_category(), outputfile);
   }
 }
 
-// void merge(std::vector<Particle> &particles, int left, int middle, int right)
-// {
-//   int i, j, k;
-//   int n1 = middle - left + 1;
-//   int n2 = right - middle;
-//
-//   /* create temp arrays */
-//   std::vector<Particle> L;
-//   std::vector<Particle> R;
-//
-//   /* Copy data to temp arrays L[] and R[] */
-//   for (i = 0; i < n1; i++)
-//     L.emplace_back(particles[left + i]);
-//   for (j = 0; j < n2; j++)
-//     R.emplace_back(particles[middle + 1 + j]);
-//
-//   /* Merge the temp arrays back into arr[l..r]*/
-//   i = 0;    // Initial index of first subarray
-//   j = 0;    // Initial index of second subarray
-//   k = left; // Initial index of merged subarray
-//   while (i < n1 && j < n2) {
-//     if (L[i].get_id() <= R[j].get_id()) {
-//       particles[k] = L[i];
-//       i++;
-//     } else {
-//       particles[k] = R[j];
-//       j++;
-//     }
-//     k++;
-//   }
-//
-//   /* Copy the remaining elements of L[], if there are any */
-//   while (i < n1) {
-//     particles[k] = L[i];
-//     i++;
-//     k++;
-//   }
-//
-//   /* Copy the remaining elements of R[], if there are any */
-//   while (j < n2) {
-//     particles[k] = R[j];
-//     j++;
-//     k++;
-//   }
-//
-//   L.clear();
-//   R.clear();
-// }
-
-// mergesort recursive (don't delete)
-// void mergeSort(std::vector<Particle> &particles, int left, int right) {
-//   if (left < right) {
-//     // Same as (l+r)/2, but avoids overflow for
-//     // large l and h
-//     int const middle = left + (right - left) / 2;
-//
-//     // Sort first and second halves
-//     mergeSort(particles, left, middle);
-//     mergeSort(particles, middle + 1, right);
-//
-//     merge(particles, left, middle, right);
-//   }
-// }
-
-// mergesort interative to fix clang-tidy warning
-#include <vector>
-
-void mergeSort(std::vector<Particle> &particles, int left, int right) {
-  for (int currentSize = 1; currentSize <= right - left; currentSize *= 2) {
-    for (int leftStart = left; leftStart < right;
-         leftStart += 2 * currentSize) {
-      int const middle = std::min(leftStart + currentSize - 1, right);
-      int const rightEnd = std::min(leftStart + 2 * currentSize - 1, right);
-      merge(particles, leftStart, middle, rightEnd);
-    }
-  }
+void writeOutput(const std::string &outputfile, Grid const &grid, ThreadPool &pool) {
+  std::vector<std::byte> buffer;
+  encodeOutput(grid, buffer, pool);
+  writeBuffer(outputfile, buffer);
 }
@@ -1,35 +1,67 @@
 #ifndef PARSER_H
 #define PARSER_H
 
+#include "cache_model.hpp"
+#include "checkpoint.hpp"
 #include "constants.hpp"
 #include "grid.hpp"
+#include "mapped_file.hpp"
 #include "particle.hpp"
+#include "profiler.hpp"
+#include "progargs.hpp"
+#include "simulation_config.hpp"
 #include "simulation.hpp"
+#include "snapshot_writer.hpp"
 #include <array>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <locale>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <unistd.h>
 #include <utility>
 #include <vector>
 
-int parser(std::array<char *, 4> args);
+int parser(ProgramOptions const &options);
 
-// read binary value from file
-Grid readInput(const std::string &inputfile);
+// read binary value from file; throws if the file cannot be mapped or
+// does not hold a header and whole particle records. A profiler gets the
+// time of the decoding as the read phase and the rest as the grid phase.
+// The grid simulates with config
+Grid readInput(const std::string &inputfile, Profiler *profiler = nullptr,
+               SimulationConfig const &config = defaultConfig);
 
-Particle readParticle(std::ifstream &input_file, int count);
+// write the report of --profile for a run of steps steps; returns -1 if it
+// cannot be written
+int writeProfile(ProgramOptions const &options, Profiler const &profiler, Grid const &grid,
+                 int steps);
 
 // print parameters
 int printParameters(Grid &grid);
 
-// write binary value to file
-void writeOutput(const std::string &outputfile, Grid &grid);
+// print what every worker of the pool did
+void printWorkerStats(ThreadPool const &pool);
 
-void writeParticle(Particle particle, std::ofstream &output_file);
+// print the modelled cache traffic of the density stage
+void printStencilTraffic(Grid const &grid);
 
-// mergesort for particles array
-void merge(std::vector<Particle> &particles, int left, int middle, int right);
+// encode the output file into buffer, reusing its capacity; particles go
+// to the record of their id
+void encodeOutput(Grid const &grid, std::vector<std::byte> &buffer,
+                  ThreadPool &pool = ThreadPool::serial());
 
-void mergeSort(std::vector<Particle> &particles, int left, int right);
+// write bytes to the file in as few write calls as possible; throws
+// std::system_error on failure
+void writeBuffer(const std::string &outputfile, std::span<std::byte const> bytes);
+
+// write the output file: header and one record per particle, sorted by id
+void writeOutput(const std::string &outputfile, Grid const &grid,
+                 ThreadPool &pool = ThreadPool::serial());
 
 #endif // PARSER_H
@@ -4,7 +4,9 @@
 Particle::Particle(int particleID, std::vector<float> partPosition,
                    std::vector<float> partHv, std::vector<float> partVelocity)
     : id(particleID), position(std::move(partPosition)),
-     hv(std::move(partHv)), velocity(std::move(partVelocity)), density(0.0), acceleration(Constants::getExternalAcceleration()), accelerated(false) {}
+     hv(std::move(partHv)), velocity(std::move(partVelocity)), density(0.0),
+     acceleration(Constants::externalAcceleration.begin(), Constants::externalAcceleration.end()),
+     accelerated(false) {}
 
 // Destructor
 Particle::~Particle() = default;
@@ -13,7 +15,7 @@ Particle::Particle(const Particle &other) = default;
 // Getters and setters for each variables
 int Particle::get_id() const { return id; }
 
-std::vector<float> Particle::get_position() { return position; }
+std::vector<float> Particle::get_position() const { return position; }
 void Particle::set_position(std::vector<float> newPosition) {
   position = std::move(newPosition);
 }
@@ -21,23 +23,26 @@ float Particle::get_px() const { return position[0]; }
 float Particle::get_py() const { return position[1]; }
 float Particle::get_pz() const { return position[2]; }
 
-std::vector<float> Particle::get_hv() { return hv; }
+std::vector<float> Particle::get_hv() const { return hv; }
 void Particle::set_hv(std::vector<float> newHv) { hv = std::move(newHv); }
 float Particle::get_hvx() const { return hv[0]; }
 float Particle::get_hvy() const { return hv[1]; }
 float Particle::get_hvz() const { return hv[2]; }
 
-std::vector<float> Particle::get_velocity() { return velocity; }
+std::vector<float> Particle::get_velocity() const { return velocity; }
 void Particle::set_velocity(std::vector<float> newVelocity) {
   velocity = std::move(newVelocity);
 }
+float Particle::get_vx() const { return velocity[0]; }
+float Particle::get_vy() const { return velocity[1]; }
+float Particle::get_vz() const { return velocity[2]; }
 
 double Particle::get_density() const { return density; }
 void Particle::set_density(double newDensity) { density = newDensity; }
-std::vector<double> Particle::get_acceleration() { return acceleration; }
-double Particle::get_ax() { return acceleration[0]; }
-double Particle::get_ay() { return acceleration[1]; }
-double Particle::get_az() { return acceleration[2]; }
+std::vector<double> Particle::get_acceleration() const { return acceleration; }
+double Particle::get_ax() const { return acceleration[0]; }
+double Particle::get_ay() const { return acceleration[1]; }
+double Particle::get_az() const { return acceleration[2]; }
 void Particle::set_acceleration(std::vector<double> newAcc) {
   acceleration = std::move(newAcc);
 }
@@ -34,27 +34,30 @@ public:
 
   [[nodiscard]] int get_id() const;
   // Getters and setters for each variables
-  std::vector<float> get_position();
+  [[nodiscard]] std::vector<float> get_position() const;
   void set_position(std::vector<float> position);
   [[nodiscard]] float get_px() const;
   [[nodiscard]] float get_py() const;
   [[nodiscard]] float get_pz() const;
 
-  std::vector<float> get_hv();
+  [[nodiscard]] std::vector<float> get_hv() const;
   void set_hv(std::vector<float> hv);
   [[nodiscard]] float get_hvx() const;
   [[nodiscard]] float get_hvy() const;
   [[nodiscard]] float get_hvz() const;
 
-  std::vector<float> get_velocity();
+  [[nodiscard]] std::vector<float> get_velocity() const;
   void set_velocity(std::vector<float> velocity);
+  [[nodiscard]] float get_vx() const;
+  [[nodiscard]] float get_vy() const;
+  [[nodiscard]] float get_vz() const;
 
   [[nodiscard]] double get_density() const;
   void set_density(double density);
-  std::vector<double> get_acceleration();
-  double get_ax();
-  double get_ay();
-  double get_az();
+  [[nodiscard]] std::vector<double> get_acceleration() const;
+  [[nodiscard]] double get_ax() const;
+  [[nodiscard]] double get_ay() const;
+  [[nodiscard]] double get_az() const;
   void set_acceleration(std::vector<double>);
   [[nodiscard]] bool hasAccelerated() const;
   void updateAccBool();
@@ -0,0 +1,120 @@
+#include "particle_store.hpp"
+
+#include <cstring>
+#include <type_traits>
+
+template <typename Policy>
+int BasicParticleStore<Policy>::size() const { return static_cast<int>(id.size()); }
+
+template <typename Policy>
+void BasicParticleStore<Policy>::reserve(int capacity) {
+  auto const cap = static_cast<std::size_t>(capacity);
+  forEachArray([cap](auto & array) { array.reserve(cap); });
+}
+
+template <typename Policy>
+void BasicParticleStore<Policy>::clear() {
+  forEachArray([](auto & array) { array.clear(); });
+}
+
+template <typename Policy>
+void BasicParticleStore<Policy>::resize(int count) {
+  auto const newSize = static_cast<std::size_t>(count);
+  forEachArray([newSize](auto & array) { array.resize(newSize); });
+}
+
+// Scatter one array at a time so every pass streams through memory
+template <typename Policy>
+void BasicParticleStore<Policy>::scatter(BasicParticleStore & target,
+                                         std::vector<int> const & destination) const {
+  target.resize(size());
+  forEachArray(target, [&destination](auto const & from, auto & into) {
+    for (std::size_t i = 0; i < from.size(); i++) {
+      into[static_cast<std::size_t>(destination[i])] = from[i];
+    }
+  });
+}
+
+// Append a particle to the end of every array
+template <typename Policy>
+int BasicParticleStore<Policy>::addParticle(Particle const & part) {
+  int const index = size();
+  id.push_back(part.get_id());
+  px.push_back(static_cast<Real>(part.get_px()));
+  py.push_back(static_cast<Real>(part.get_py()));
+  pz.push_back(static_cast<Real>(part.get_pz()));
+  hvx.push_back(static_cast<Real>(part.get_hvx()));
+  hvy.push_back(static_cast<Real>(part.get_hvy()));
+  hvz.push_back(static_cast<Real>(part.get_hvz()));
+  vx.push_back(static_cast<Real>(part.get_vx()));
+  vy.push_back(static_cast<Real>(part.get_vy()));
+  vz.push_back(static_cast<Real>(part.get_vz()));
+  density.push_back(static_cast<Accumulator>(part.get_density()));
+  ax.push_back(static_cast<Accumulator>(part.get_ax()));
+  ay.push_back(static_cast<Accumulator>(part.get_ay()));
+  az.push_back(static_cast<Accumulator>(part.get_az()));
+  return index;
+}
+
+// Gather the arrays of one index back into a Particle, which keeps the
+// precision of the .fld files
+template <typename Policy>
+Particle BasicParticleStore<Policy>::getParticle(int index) const {
+  auto const idx = static_cast<std::size_t>(index);
+  auto const toFloat = [idx](AlignedVector<Real> const & array) {
+    return static_cast<float>(array[idx]);
+  };
+  Particle part(id[idx], {toFloat(px), toFloat(py), toFloat(pz)},
+                {toFloat(hvx), toFloat(hvy), toFloat(hvz)},
+                {toFloat(vx), toFloat(vy), toFloat(vz)});
+  part.set_density(static_cast<double>(density[idx]));
+  part.set_acceleration({static_cast<double>(ax[idx]), static_cast<double>(ay[idx]),
+                         static_cast<double>(az[idx])});
+  return part;
+}
+
+namespace {
+  // Bytes of an array of count values, padded to the next alignment boundary
+  template <typename Array>
+  std::size_t paddedBytes(std::size_t count) {
+    std::size_t const bytes = count * sizeof(typename Array::value_type);
+    return (bytes + particleAlignment - 1) / particleAlignment * particleAlignment;
+  }
+}  // namespace
+
+template <typename Policy>
+std::size_t BasicParticleStore<Policy>::packedBytes(int count) {
+  auto const numParts = static_cast<std::size_t>(count);
+  std::size_t bytes = 0;
+  BasicParticleStore const layout;
+  layout.forEachArray([numParts, &bytes](auto const & array) {
+    bytes += paddedBytes<std::remove_cvref_t<decltype(array)>>(numParts);
+  });
+  return bytes;
+}
+
+// One memcpy per array, so packing streams at memory bandwidth
+template <typename Policy>
+void BasicParticleStore<Policy>::pack(std::span<std::byte> bytes) const {
+  auto const numParts = static_cast<std::size_t>(size());
+  std::size_t offset = 0;
+  forEachArray([numParts, bytes, &offset](auto const & array) {
+    std::memcpy(bytes.subspan(offset).data(), array.data(), numParts * sizeof(array[0]));
+    offset += paddedBytes<std::remove_cvref_t<decltype(array)>>(numParts);
+  });
+}
+
+template <typename Policy>
+void BasicParticleStore<Policy>::unpack(std::span<std::byte const> bytes, int count) {
+  resize(count);
+  auto const numParts = static_cast<std::size_t>(count);
+  std::size_t offset = 0;
+  forEachArray([numParts, bytes, &offset](auto & array) {
+    std::memcpy(array.data(), bytes.subspan(offset).data(), numParts * sizeof(array[0]));
+    offset += paddedBytes<std::remove_cvref_t<decltype(array)>>(numParts);
+  });
+}
+
+template class BasicParticleStore<MixedPrecision>;
+template class BasicParticleStore<DoublePrecision>;
+template class BasicParticleStore<FloatPrecision>;
@@ -0,0 +1,173 @@
+#ifndef FLUID_PARTICLE_STORE_HPP
+#define FLUID_PARTICLE_STORE_HPP
+
+#include "particle.hpp"
+#include "precision.hpp"
+
+#include <cstddef>
+#include <new>
+#include <span>
+#include <vector>
+
+// Alignment of every particle array (one cache line, wide enough for AVX-512)
+constexpr std::size_t particleAlignment = 64;
+
+// Allocator that places every array on a particleAlignment boundary so the
+// kernels can use aligned vector loads on the start of each array
+template <typename T, std::size_t Alignment = particleAlignment>
+class AlignedAllocator {
+public:
+  using value_type = T;
+
+  template <typename U>
+  struct rebind {
+    using other = AlignedAllocator<U, Alignment>;
+  };
+
+  AlignedAllocator() noexcept = default;
+
+  template <typename U>
+  // NOLINTNEXTLINE(google-explicit-constructor,hicpp-explicit-conversions)
+  AlignedAllocator(AlignedAllocator<U, Alignment> const & /*other*/) noexcept { }
+
+  T * allocate(std::size_t count) {
+    return static_cast<T *>(::operator new(count * sizeof(T), std::align_val_t{Alignment}));
+  }
+
+  void deallocate(T * pointer, std::size_t /*count*/) noexcept {
+    ::operator delete(pointer, std::align_val_t{Alignment});
+  }
+
+  template <typename U>
+  bool operator==(AlignedAllocator<U, Alignment> const & /*other*/) const noexcept {
+    return true;
+  }
+};
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+// Structure-of-arrays storage for every particle of the simulation. Blocks,
+// the grid and the parser refer to particles by their index in these arrays.
+// The types of the arrays come from a precision policy (precision.hpp)
+template <typename Policy>
+class BasicParticleStore {
+public:
+  using Real = typename Policy::Real;
+  using Accumulator = typename Policy::Accumulator;
+
+  AlignedVector<int> id;
+  AlignedVector<Real> px;
+  AlignedVector<Real> py;
+  AlignedVector<Real> pz;
+  AlignedVector<Real> hvx;
+  AlignedVector<Real> hvy;
+  AlignedVector<Real> hvz;
+  AlignedVector<Real> vx;
+  AlignedVector<Real> vy;
+  AlignedVector<Real> vz;
+  AlignedVector<Accumulator> density;
+  AlignedVector<Accumulator> ax;
+  AlignedVector<Accumulator> ay;
+  AlignedVector<Accumulator> az;
+
+  // Number of particles stored
+  [[nodiscard]] int size() const;
+
+  // Reserve room for capacity particles in every array
+  void reserve(int capacity);
+
+  // Remove every particle
+  void clear();
+
+  // Resize every array to count particles
+  void resize(int count);
+
+  // Copy the particle at every index i to index destination[i] of target,
+  // resizing target to hold all particles
+  void scatter(BasicParticleStore & target, std::vector<int> const & destination) const;
+
+  // Append a particle and return its index
+  int addParticle(Particle const & part);
+
+  // Build a Particle with the values stored at index
+  [[nodiscard]] Particle getParticle(int index) const;
+
+  // Bytes of every array of count particles one after the other, each
+  // padded to particleAlignment: the layout written by pack
+  [[nodiscard]] static std::size_t packedBytes(int count);
+
+  // Copy every array into bytes, which holds packedBytes(size())
+  void pack(std::span<std::byte> bytes) const;
+
+  // Resize to count particles and copy every array from bytes, which holds
+  // packedBytes(count)
+  void unpack(std::span<std::byte const> bytes, int count);
+
+private:
+  // Apply function to every array of the store
+  template <typename Function>
+  void forEachArray(Function function) {
+    function(id);
+    function(px);
+    function(py);
+    function(pz);
+    function(hvx);
+    function(hvy);
+    function(hvz);
+    function(vx);
+    function(vy);
+    function(vz);
+    function(density);
+    function(ax);
+    function(ay);
+    function(az);
+  }
+
+  template <typename Function>
+  void forEachArray(Function function) const {
+    function(id);
+    function(px);
+    function(py);
+    function(pz);
+    function(hvx);
+    function(hvy);
+    function(hvz);
+    function(vx);
+    function(vy);
+    function(vz);
+    function(density);
+    function(ax);
+    function(ay);
+    function(az);
+  }
+
+  // Apply function to every array of the store and the matching array of other
+  template <typename Function>
+  void forEachArray(BasicParticleStore & other, Function function) const {
+    function(id, other.id);
+    function(px, other.px);
+    function(py, other.py);
+    function(pz, other.pz);
+    function(hvx, other.hvx);
+    function(hvy, other.hvy);
+    function(hvz, other.hvz);
+    function(vx, other.vx);
+    function(vy, other.vy);
+    function(vz, other.vz);
+    function(density, other.density);
+    function(ax, other.ax);
+    function(ay, other.ay);
+    function(az, other.az);
+  }
+};
+
+// Every policy is instantiated in particle_store.cpp
+extern template class BasicParticleStore<MixedPrecision>;
+extern template class BasicParticleStore<DoublePrecision>;
+extern template class BasicParticleStore<FloatPrecision>;
+
+// Store of the simulation, in the precision it was built with
+using ParticleStore = BasicParticleStore<ActivePrecision>;
+
+#endif  // FLUID_PARTICLE_STORE_HPP
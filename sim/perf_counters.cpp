@@ -0,0 +1,128 @@
+#include "perf_counters.hpp"
+
+#include <cerrno>
+#include <string>
+#include <system_error>
+
+#ifdef __linux__
+  #include <linux/perf_event.h>
+  #include <sys/ioctl.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+#endif
+
+#ifdef __linux__
+namespace {
+  constexpr std::array<std::uint64_t, numPerfEvents> eventConfigs = {
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES};
+
+  // Layout of a read of a group with PERF_FORMAT_GROUP, TOTAL_TIME_ENABLED,
+  // TOTAL_TIME_RUNNING and ID
+  struct GroupRead {
+    std::uint64_t count;
+    std::uint64_t timeEnabled;
+    std::uint64_t timeRunning;
+    std::array<std::array<std::uint64_t, 2>, numPerfEvents> values;
+  };
+
+  int openEvent(std::uint64_t config, int threadId, int leader) {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                       PERF_FORMAT_TOTAL_TIME_RUNNING | PERF_FORMAT_ID;
+    return static_cast<int>(
+        syscall(SYS_perf_event_open, &attr, threadId, -1, leader, PERF_FLAG_FD_CLOEXEC));
+  }
+}  // namespace
+
+PerfCounters::PerfCounters(std::span<int const> threadIds) {
+  for (int const threadId : threadIds) {
+    Group group{};
+    group.fds.fill(-1);
+    group.leader = -1;
+    for (std::size_t event = 0; event < eventConfigs.size(); event++) {
+      // Later threads only open the events the first one could
+      if (not groups.empty() and not opened[event]) { continue; }
+      int const leaderFd =
+          group.leader < 0 ? -1 : group.fds[static_cast<std::size_t>(group.leader)];
+      int const fd = openEvent(eventConfigs[event], threadId, leaderFd);
+      if (fd < 0) {
+        if (error.empty()) {
+          error = std::string(perfEventNames[event]) + ": " +
+                  std::generic_category().message(errno);
+        }
+        continue;
+      }
+      group.fds[event] = fd;
+      if (ioctl(fd, PERF_EVENT_IOC_ID, &group.ids[event]) != 0) { group.ids[event] = 0; }
+      if (group.leader < 0) { group.leader = static_cast<int>(event); }
+      if (groups.empty()) { opened[event] = true; }
+    }
+    if (group.leader < 0) {
+      closeGroups();
+      return;
+    }
+    groups.push_back(group);
+  }
+  error.clear();
+}
+
+PerfCounters::~PerfCounters() { closeGroups(); }
+
+void PerfCounters::closeGroups() {
+  for (Group const &group : groups) {
+    for (int const fd : group.fds) {
+      if (fd >= 0) { close(fd); }
+    }
+  }
+  groups.clear();
+  opened.fill(false);
+}
+
+PerfCounts PerfCounters::read() const {
+  PerfCounts counts{};
+  for (std::size_t event = 0; event < counts.size(); event++) {
+    counts[event] = opened[event] ? 0 : -1;
+  }
+  for (Group const &group : groups) {
+    GroupRead values{};
+    auto const leaderFd = group.fds[static_cast<std::size_t>(group.leader)];
+    if (::read(leaderFd, &values, sizeof(values)) <= 0 or values.timeRunning == 0) { continue; }
+    double const scale = static_cast<double>(values.timeEnabled) /
+                         static_cast<double>(values.timeRunning);
+    for (std::size_t value = 0; value < values.count and value < values.values.size(); value++) {
+      for (std::size_t event = 0; event < group.ids.size(); event++) {
+        if (group.fds[event] >= 0 and group.ids[event] == values.values[value][1]) {
+          counts[event] += static_cast<std::int64_t>(
+              static_cast<double>(values.values[value][0]) * scale);
+        }
+      }
+    }
+  }
+  return counts;
+}
+#else
+PerfCounters::PerfCounters(std::span<int const> /*threadIds*/)
+    : error("hardware counters need Linux perf_event_open") { }
+
+PerfCounters::~PerfCounters() = default;
+
+void PerfCounters::closeGroups() { }
+
+PerfCounts PerfCounters::read() const {
+  PerfCounts counts{};
+  counts.fill(-1);
+  return counts;
+}
+#endif
+
+bool PerfCounters::available() const { return not groups.empty(); }
+
+bool PerfCounters::counted(PerfEvent event) const { return opened[static_cast<std::size_t>(event)]; }
+
+std::string const &PerfCounters::get_error() const { return error; }
@@ -0,0 +1,66 @@
+#ifndef FLUID_PERF_COUNTERS_HPP
+#define FLUID_PERF_COUNTERS_HPP
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Hardware events counted per phase of the profile. The ratio of
+// instructions to cycles is the IPC
+enum class PerfEvent { cycles, instructions, cacheMisses, branchMisses };
+
+inline constexpr int numPerfEvents = 4;
+inline constexpr std::array<std::string_view, numPerfEvents> perfEventNames = {
+  "cycles", "instructions", "cacheMisses", "branchMisses"};
+
+// Count of every event; -1 for the events that could not be opened
+using PerfCounts = std::array<std::int64_t, numPerfEvents>;
+
+// One group of the events on each of a set of threads, opened with Linux
+// perf_event_open (user space only, so the default perf_event_paranoid
+// allows it). An event the CPU or the kernel does not offer is left out; if
+// none can be opened, for example in a container without access to the PMU,
+// the counters are unavailable and read returns -1 for every event
+class PerfCounters {
+public:
+  explicit PerfCounters(std::span<int const> threadIds);
+  ~PerfCounters();
+
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+  PerfCounters(PerfCounters &&) = delete;
+  PerfCounters &operator=(PerfCounters &&) = delete;
+
+  [[nodiscard]] bool available() const;
+
+  // Whether event is counted (on the first thread at least)
+  [[nodiscard]] bool counted(PerfEvent event) const;
+
+  // Why the counters are unavailable
+  [[nodiscard]] std::string const &get_error() const;
+
+  // Counts of all the threads so far, scaled up for the time the kernel
+  // had them switched out when there were more events than counters. Only
+  // consistent while the threads are not running solver work
+  [[nodiscard]] PerfCounts read() const;
+
+private:
+  void closeGroups();
+
+  // File descriptor of every event on one thread, -1 when not opened; the
+  // first one open leads the group
+  struct Group {
+    std::array<int, numPerfEvents> fds;
+    std::array<std::uint64_t, numPerfEvents> ids;
+    int leader;
+  };
+
+  std::vector<Group> groups;
+  std::array<bool, numPerfEvents> opened{};
+  std::string error;
+};
+
+#endif  // FLUID_PERF_COUNTERS_HPP
@@ -0,0 +1,42 @@
+#ifndef FLUID_PRECISION_HPP
+#define FLUID_PRECISION_HPP
+
+// Precision policies of the particle store and the kernels. Real is the
+// type of the stored position, hv and velocity; Accumulator the type of the
+// stored density and acceleration and of the sums the kernels build
+template <typename RealT, typename AccumulatorT>
+struct Precision {
+  using Real = RealT;
+  using Accumulator = AccumulatorT;
+};
+
+// Float storage with double sums: the layout of the .fld files, with sums
+// accurate enough to match the reference traces
+using MixedPrecision = Precision<float, double>;
+
+// Everything in double, to validate the other policies
+using DoublePrecision = Precision<double, double>;
+
+// Everything in float: density and acceleration take half the bytes, at
+// the cost of accuracy. It runs the scalar kernels, so a float build is
+// slower than a mixed one, which has vectorized kernels
+using FloatPrecision = Precision<float, float>;
+
+// Name of a policy, for reports
+template <typename Policy>
+inline constexpr char const * precisionName = "mixed";
+template <>
+inline constexpr char const * precisionName<DoublePrecision> = "double";
+template <>
+inline constexpr char const * precisionName<FloatPrecision> = "float";
+
+// Policy of the simulation, chosen when building (FLUID_PRECISION in CMake)
+#if defined(FLUID_PRECISION_DOUBLE)
+using ActivePrecision = DoublePrecision;
+#elif defined(FLUID_PRECISION_FLOAT)
+using ActivePrecision = FloatPrecision;
+#else
+using ActivePrecision = MixedPrecision;
+#endif
+
+#endif  // FLUID_PRECISION_HPP
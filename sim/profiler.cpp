@@ -0,0 +1,172 @@
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <mutex>
+
+namespace {
+  struct Registration;
+
+  // Counters of the live threads, linked through their registrations so a
+  // thread joins without allocating, and the sum of those of exited threads
+  struct Registry {
+    std::mutex mutex;
+    Registration *live{};
+    profile::Counters retired{};
+  };
+
+  Registry &registry() {
+    static Registry instance;
+    return instance;
+  }
+
+  // Registration of the counters of one thread, until the thread exits
+  struct Registration {
+    profile::Counters const *counters{&profile::threadCounters};
+    Registration *next{};
+
+    Registration() {
+      std::lock_guard const lock(registry().mutex);
+      next = registry().live;
+      registry().live = this;
+    }
+
+    ~Registration() {
+      std::lock_guard const lock(registry().mutex);
+      for (std::size_t counter = 0; counter < profile::threadCounters.size(); counter++) {
+        registry().retired[counter] += profile::threadCounters[counter];
+      }
+      Registration **link = &registry().live;
+      while (*link != this) { link = &(*link)->next; }
+      *link = next;
+    }
+
+    Registration(const Registration &) = delete;
+    Registration &operator=(const Registration &) = delete;
+    Registration(Registration &&) = delete;
+    Registration &operator=(Registration &&) = delete;
+  };
+
+  // Particles per second of a phase that handled particles count times
+  double throughput(int particles, int count, double seconds) {
+    return seconds > 0.0 ? static_cast<double>(particles) * count / seconds : 0.0;
+  }
+}  // namespace
+
+namespace profile {
+  thread_local constinit Counters threadCounters{};
+  thread_local constinit bool threadRegistered = false;
+
+  void registerThread() {
+    thread_local Registration const registration;
+    threadRegistered = true;
+  }
+
+  Counters totalCounters() {
+    std::lock_guard const lock(registry().mutex);
+    Counters total = registry().retired;
+    for (Registration const *thread = registry().live; thread != nullptr; thread = thread->next) {
+      for (std::size_t counter = 0; counter < total.size(); counter++) {
+        total[counter] += (*thread->counters)[counter];
+      }
+    }
+    return total;
+  }
+}  // namespace profile
+
+Profiler::Profiler() : baseline(profile::totalCounters()) { }
+
+bool Profiler::enablePerfCounters(ThreadPool const &pool) {
+  perfRequested = true;
+  perf = std::make_unique<PerfCounters>(pool.get_threadIds());
+  if (not perf->available()) {
+    perfError = perf->get_error();
+    perf.reset();
+    return false;
+  }
+  return true;
+}
+
+std::string const &Profiler::get_perfError() const { return perfError; }
+
+Profiler::PhaseStart Profiler::beginPhase() const {
+  PhaseStart start{};
+  if (perf) { start.counts = perf->read(); }
+  start.time = std::chrono::steady_clock::now();
+  return start;
+}
+
+void Profiler::endPhase(Phase phase, PhaseStart const &start) {
+  auto const index = static_cast<std::size_t>(phase);
+  seconds[index] += std::chrono::duration<double>(std::chrono::steady_clock::now() - start.time)
+                        .count();
+  if (not perf) { return; }
+  PerfCounts const counts = perf->read();
+  for (std::size_t event = 0; event < counts.size(); event++) {
+    perfCounts[index][event] += counts[event] - start.counts[event];
+  }
+}
+
+double Profiler::get_seconds(Phase phase) const { return seconds[static_cast<std::size_t>(phase)]; }
+
+std::int64_t Profiler::get_counter(Counter counter) const {
+  auto const index = static_cast<std::size_t>(counter);
+  return profile::totalCounters()[index] - baseline[index];
+}
+
+std::int64_t Profiler::get_perfCount(Phase phase, PerfEvent event) const {
+  auto const index = static_cast<std::size_t>(event);
+  if (not perf or not perf->counted(event)) { return -1; }
+  return perfCounts[static_cast<std::size_t>(phase)][index];
+}
+
+// The stages run once per step, the other phases once per run
+void Profiler::writeReport(std::ostream &out, int particles, int steps, int threads) const {
+  double total = 0.0;
+  for (double const phaseSeconds : seconds) { total += phaseSeconds; }
+  out << "{\n";
+  out << "  \"particles\": " << particles << ",\n";
+  out << "  \"steps\": " << steps << ",\n";
+  out << "  \"threads\": " << threads << ",\n";
+  out << "  \"seconds\": " << total << ",\n";
+  out << "  \"phases\": {\n";
+  for (std::size_t phase = 0; phase < seconds.size(); phase++) {
+    auto const current = static_cast<Phase>(phase);
+    int const count = current == Phase::read or current == Phase::grid or
+                              current == Phase::write
+                          ? 1
+                          : steps;
+    out << "    \"" << phaseNames[phase] << "\": {\"seconds\": " << seconds[phase]
+        << ", \"particlesPerSecond\": " << throughput(particles, count, seconds[phase]);
+    writePerfCounts(out, current);
+    out << "}" << (phase + 1 < seconds.size() ? ",\n" : "\n");
+  }
+  out << "  },\n";
+  if (perfRequested) {
+    out << "  \"perfCounters\": {\"available\": " << (perf ? "true" : "false");
+    if (not perf) { out << ", \"error\": \"" << perfError << "\""; }
+    out << "},\n";
+  }
+  out << "  \"counters\": {\n";
+  for (std::size_t counter = 0; counter < counterNames.size(); counter++) {
+    out << "    \"" << counterNames[counter]
+        << "\": " << get_counter(static_cast<Counter>(counter))
+        << (counter + 1 < counterNames.size() ? ",\n" : "\n");
+  }
+  out << "  }\n";
+  out << "}\n";
+}
+
+// The hardware events of a phase as more members of its object, and the
+// instructions per cycle
+void Profiler::writePerfCounts(std::ostream &out, Phase phase) const {
+  if (not perf) { return; }
+  for (std::size_t event = 0; event < perfEventNames.size(); event++) {
+    std::int64_t const count = get_perfCount(phase, static_cast<PerfEvent>(event));
+    if (count >= 0) { out << ", \"" << perfEventNames[event] << "\": " << count; }
+  }
+  std::int64_t const cycles = get_perfCount(phase, PerfEvent::cycles);
+  std::int64_t const instructions = get_perfCount(phase, PerfEvent::instructions);
+  if (cycles > 0 and instructions >= 0) {
+    out << ", \"ipc\": " << static_cast<double>(instructions) / static_cast<double>(cycles);
+  }
+}
@@ -0,0 +1,155 @@
+#ifndef FLUID_PROFILER_HPP
+#define FLUID_PROFILER_HPP
+
+#include "perf_counters.hpp"
+#include "thread_pool.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+// Phases of a run with a wall time in the profile: reading the input,
+// building the grid, the stages of a step in the order they run and
+// writing the output
+enum class Phase {
+  read,
+  grid,
+  repos,
+  initacc,
+  densinc,
+  denstransf,
+  acctransf,
+  partcol,
+  motion,
+  boundint,
+  write
+};
+
+inline constexpr int numPhases = 11;
+inline constexpr std::array<std::string_view, numPhases> phaseNames = {
+  "read",      "grid",    "repos",  "initacc",  "densinc", "denstransf",
+  "acctransf", "partcol", "motion", "boundint", "write"};
+
+// Events counted while profiling: pairs of particles whose distance the
+// density stage tests, the pairs of them within the smoothing length (both
+// once per direction in gather mode), particle collisions with the walls
+// of the box (one per axis), particles repositioned into another block,
+// and the rebuilds of the Verlet lists with the entries they were built with
+enum class Counter {
+  candidatePairs,
+  pairsInside,
+  wallCollisions,
+  blockChanges,
+  verletRebuilds,
+  verletEntries
+};
+
+inline constexpr int numCounters = 6;
+inline constexpr std::array<std::string_view, numCounters> counterNames = {
+  "candidatePairs", "pairsInside",    "wallCollisions",
+  "blockChanges",   "verletRebuilds", "verletEntries"};
+
+namespace profile {
+  using Counters = std::array<std::int64_t, numCounters>;
+
+  // Counters of the calling thread, and whether they are registered for
+  // totalCounters
+  extern thread_local constinit Counters threadCounters;
+  extern thread_local constinit bool threadRegistered;
+
+  // Register the counters of the calling thread until it exits
+  void registerThread();
+
+  // Sum of the counters of every thread, including threads that have
+  // exited. Only exact while no other thread is counting
+  [[nodiscard]] Counters totalCounters();
+
+  // Add amount to a counter of the calling thread. Builds without
+  // FLUID_PROFILE compile it to nothing
+  inline void count([[maybe_unused]] Counter counter, [[maybe_unused]] std::int64_t amount = 1) {
+#ifdef FLUID_PROFILE
+    if (not threadRegistered) { registerThread(); }
+    threadCounters[static_cast<std::size_t>(counter)] += amount;
+#endif
+  }
+}  // namespace profile
+
+// Wall time of every phase, summed over the steps, and the counters since
+// the profiler was created. With hardware counters enabled, also the
+// events of every phase on the threads of the pool
+class Profiler {
+public:
+  // Time and hardware counts at the start of a phase
+  struct PhaseStart {
+    std::chrono::steady_clock::time_point time;
+    PerfCounts counts;
+  };
+
+  Profiler();
+
+  // Count hardware events on the threads of pool. Returns false if no
+  // event can be counted; get_perfError tells why
+  bool enablePerfCounters(ThreadPool const &pool);
+  [[nodiscard]] std::string const &get_perfError() const;
+
+  [[nodiscard]] PhaseStart beginPhase() const;
+  void endPhase(Phase phase, PhaseStart const &start);
+
+  [[nodiscard]] double get_seconds(Phase phase) const;
+  [[nodiscard]] std::int64_t get_counter(Counter counter) const;
+
+  // Count of a hardware event in a phase; -1 if it is not counted
+  [[nodiscard]] std::int64_t get_perfCount(Phase phase, PerfEvent event) const;
+
+  // Write the profile as a JSON object: the run, the seconds, particles per
+  // second and hardware events of every phase, and the counters
+  void writeReport(std::ostream &out, int particles, int steps, int threads) const;
+
+private:
+  void writePerfCounts(std::ostream &out, Phase phase) const;
+
+  std::array<double, numPhases> seconds{};
+  profile::Counters baseline;
+  bool perfRequested{};
+  std::unique_ptr<PerfCounters> perf;
+  std::string perfError;
+  std::array<PerfCounts, numPhases> perfCounts{};
+};
+
+// Adds the wall time (and hardware events) of its scope to a phase of
+// profiler, if there is one. Builds without FLUID_PROFILE compile it to
+// nothing
+class PhaseTimer {
+public:
+  PhaseTimer([[maybe_unused]] Profiler *profiler, [[maybe_unused]] Phase phase) {
+#ifdef FLUID_PROFILE
+    if (profiler != nullptr) {
+      this->profiler = profiler;
+      this->phase = phase;
+      start = profiler->beginPhase();
+    }
+#endif
+  }
+
+  ~PhaseTimer() {
+#ifdef FLUID_PROFILE
+    if (profiler != nullptr) { profiler->endPhase(phase, start); }
+#endif
+  }
+
+  PhaseTimer(const PhaseTimer &) = delete;
+  PhaseTimer &operator=(const PhaseTimer &) = delete;
+  PhaseTimer(PhaseTimer &&) = delete;
+  PhaseTimer &operator=(PhaseTimer &&) = delete;
+
+private:
+  Profiler *profiler{};
+  Phase phase{};
+  Profiler::PhaseStart start{};
+};
+
+#endif  // FLUID_PROFILER_HPP
@@ -1,5 +1,9 @@
 #include "progargs.hpp"
 
+#include "stage_tracer.hpp"
+
+#include <charconv>
+
 int progargs(int argc, std::array<char *, 4> argv) {
   if (argc != 4) {
     std::cerr << "Error: Invalid number of arguments: " << argc - 1 << ".\n";
@@ -26,3 +30,144 @@ int progargs(int argc, std::array<char *, 4> argv) {
 
   return checkFile(argv[2], "reading", -3) + checkFile(argv[3], "writing", -4);
 }
+
+namespace {
+  // Positive integer value of an option
+  int positiveValue(std::string const &name, std::string const &value) {
+    int result = 0;
+    auto const [end, error] = std::from_chars(value.data(), value.data() + value.size(), result);
+    if (error != std::errc{} or end != value.data() + value.size() or result <= 0) {
+      std::cerr << "Error: Invalid value for " << name << ": " << value << "\n";
+      return -1;
+    }
+    return result;
+  }
+
+  // Positive floating point value of an option
+  double positiveReal(std::string const &name, std::string const &value) {
+    double result = 0.0;
+    auto const [end, error] = std::from_chars(value.data(), value.data() + value.size(), result);
+    if (error != std::errc{} or end != value.data() + value.size() or not(result > 0.0)) {
+      std::cerr << "Error: Invalid value for " << name << ": " << value << "\n";
+      return -1.0;
+    }
+    return result;
+  }
+
+  // --trace-stage name|all or --trace-steps a..b, only in builds with tracing
+  bool parseTraceOption(std::string const &name, std::string const &value,
+                        ProgramOptions &options) {
+#ifdef FLUID_TRACE
+    TraceStage stage{};
+    bool const valid = name == "--trace-stage"
+                           ? value == "all" or parseTraceStage(value, stage)
+                           : parseStepRange(value, options.traceFirstStep, options.traceLastStep);
+    if (not valid) {
+      std::cerr << "Error: Invalid value for " << name << ": " << value << "\n";
+      return false;
+    }
+    if (name == "--trace-stage") { options.traceStage = value; }
+    return true;
+#else
+    std::cerr << "Error: " << name << " needs a build with FLUID_TRACE" << "\n";
+    static_cast<void>(value);
+    static_cast<void>(options);
+    return false;
+#endif
+  }
+}  // namespace
+
+int parseOptions(std::span<char *> args, ProgramOptions &options) {
+  std::array<char *, 4> positional = {};
+  int numPositional = 0;
+  for (std::size_t arg = 0; arg < args.size(); arg++) {
+    std::string name = args[arg];
+    if (arg == 0 or not name.starts_with("--")) {
+      if (numPositional < 4) { positional.at(static_cast<std::size_t>(numPositional)) = args[arg]; }
+      numPositional++;
+      continue;
+    }
+    if (name == "--scheduler-stats") {
+      options.schedulerStats = true;
+      continue;
+    }
+    if (name == "--cache-report") {
+      options.cacheReport = true;
+      continue;
+    }
+    if (name == "--perf-counters") {
+      options.perfCounters = true;
+      continue;
+    }
+    std::string value;
+    if (auto const equals = name.find('='); equals != std::string::npos) {
+      value = name.substr(equals + 1);
+      name = name.substr(0, equals);
+    } else if (arg + 1 < args.size()) {
+      value = args[++arg];
+    }
+    if (name == "--threads") {
+      options.threads = positiveValue(name, value);
+      if (options.threads < 0) { return -5; }
+    } else if (name == "--dump-every") {
+      options.dumpEvery = positiveValue(name, value);
+      if (options.dumpEvery < 0) { return -5; }
+    } else if (name == "--dump-format") {
+      if (not parseSnapshotFormat(value, options.dumpFormat)) {
+        std::cerr << "Error: Invalid value for " << name << ": " << value << "\n";
+        return -5;
+      }
+    } else if (name == "--checkpoint-every") {
+      options.checkpointEvery = positiveValue(name, value);
+      if (options.checkpointEvery < 0) { return -5; }
+    } else if (name == "--config") {
+      if (value.empty()) {
+        std::cerr << "Error: Invalid value for " << name << ": " << value << "\n";
+        return -5;
+      }
+      options.configFile = value;
+    } else if (name == "--restart") {
+      if (value.empty()) {
+        std::cerr << "Error: Invalid value for " << name << ": " << value << "\n";
+        return -5;
+      }
+      options.restartFile = value;
+    } else if (name == "--profile") {
+#ifdef FLUID_PROFILE
+      if (value.empty()) {
+        std::cerr << "Error: Invalid value for " << name << ": " << value << "\n";
+        return -5;
+      }
+      options.profileFile = value;
+#else
+      std::cerr << "Error: " << name << " needs a build with FLUID_PROFILE" << "\n";
+      return -5;
+#endif
+    } else if (name == "--trace-stage" or name == "--trace-steps") {
+      if (not parseTraceOption(name, value, options)) { return -5; }
+    } else if (name == "--verlet-skin") {
+      options.verletSkin = positiveReal(name, value);
+      if (options.verletSkin < 0) { return -5; }
+    } else if (name == "--cell-order") {
+      if (not parseCellOrder(value, options.cellOrder)) {
+        std::cerr << "Error: Invalid value for " << name << ": " << value << "\n";
+        return -5;
+      }
+    } else {
+      std::cerr << "Error: Invalid option: " << name << "\n";
+      return -5;
+    }
+  }
+
+  if (options.perfCounters and options.profileFile.empty()) {
+    std::cerr << "Error: --perf-counters needs --profile" << "\n";
+    return -5;
+  }
+
+  int const result = progargs(numPositional, positional);
+  if (result != 0) { return result; }
+  options.timeSteps = std::stoi(positional[1]);
+  options.inputFile = positional[2];
+  options.outputFile = positional[3];
+  return 0;
+}
@@ -1,10 +1,55 @@
 #ifndef PROGARGS_H
 #define PROGARGS_H
 
+#include "cell_order.hpp"
+#include "snapshot_archive.hpp"
+
 #include <array>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <span>
+#include <string>
 
 int progargs(int argc, std::array<char *, 4> argv);
 
+// Arguments of the fluid binary: the three positional ones and the options
+struct ProgramOptions {
+  int timeSteps{};
+  std::string inputFile;
+  std::string outputFile;
+  int threads{1};
+  bool schedulerStats{};
+  // Skin of the Verlet lists as a fraction of the smoothing length; zero
+  // scans the adjacent blocks every step instead
+  double verletSkin{};
+  CellOrder cellOrder{CellOrder::linear};
+  bool cacheReport{};
+  // Write a frame every dumpEvery steps; zero writes only the final state
+  int dumpEvery{};
+  SnapshotFormat dumpFormat{SnapshotFormat::fld};
+  // Write a checkpoint every checkpointEvery steps; restart from
+  // restartFile instead of reading the input file when it is not empty
+  int checkpointEvery{};
+  std::string restartFile;
+  // Trace the stage named traceStage ("all" for every stage) after each of
+  // the steps [traceFirstStep, traceLastStep]; empty traces nothing
+  std::string traceStage;
+  int traceFirstStep{1};
+  int traceLastStep{std::numeric_limits<int>::max()};
+  // Write the profile of the run to profileFile ("-" for the standard
+  // output); empty does not profile
+  std::string profileFile;
+  // Add hardware event counts to the profile
+  bool perfCounters{};
+  // Read the constants and tank from configFile; empty uses the defaults
+  std::string configFile;
+};
+
+// Read "--name value" or "--name=value" options and "--name" flags anywhere
+// in args and check
+// the remaining positional arguments with progargs. Returns progargs' error
+// codes, or -5 for an invalid option
+int parseOptions(std::span<char *> args, ProgramOptions &options);
+
 #endif // PROGARGS_H
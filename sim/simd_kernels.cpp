@@ -0,0 +1,528 @@
+#include "simd_kernels.hpp"
+
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+// The vector kernels work on float positions and double sums: the mixed
+// precision policy
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(FLUID_PRECISION_DOUBLE) && \
+    !defined(FLUID_PRECISION_FLOAT)
+  #define FLUID_SIMD_X86 1
+  #include <immintrin.h>
+#endif
+
+namespace simd {
+  namespace {
+    // Lower bound of the squared distance used in the acceleration transfer
+    constexpr double minDistanceSq = 1e-12;
+
+    // Instruction set selected at start up
+    Isa & currentIsa() {
+      static Isa isa = bestIsa();
+      return isa;
+    }
+
+    // Density increase that a particle at squared distance diffSum adds
+    template <typename Accumulator>
+    Accumulator densityChange(Accumulator slSq, Accumulator diffSum) {
+      Accumulator const diff = slSq - diffSum;
+      return diff * diff * diff;
+    }
+
+    // Scalar row over [first, last); returns the increase of row.part. The
+    // differences and sums are taken in the accumulator type of the policy
+    template <typename Policy, typename Accumulator = typename Policy::Accumulator>
+    Accumulator densityRowTail(BasicParticleStore<Policy> & store, PairRow row, double slSq,
+                               bool symmetric) {
+      auto const idx = static_cast<std::size_t>(row.part);
+      auto const slSqAcc = static_cast<Accumulator>(slSq);
+      Accumulator const pxi = store.px[idx];
+      Accumulator const pyi = store.py[idx];
+      Accumulator const pzi = store.pz[idx];
+      Accumulator sum = 0.0;
+      std::int64_t inside = 0;
+      for (auto jIdx = static_cast<std::size_t>(row.first);
+           jIdx < static_cast<std::size_t>(row.last); jIdx++) {
+        Accumulator const xDiff = pxi - store.px[jIdx];
+        Accumulator const yDiff = pyi - store.py[jIdx];
+        Accumulator const zDiff = pzi - store.pz[jIdx];
+        Accumulator const diffSum = xDiff * xDiff + yDiff * yDiff + zDiff * zDiff;
+        if (diffSum < slSqAcc) {
+          Accumulator const change = densityChange(slSqAcc, diffSum);
+          sum += change;
+          inside++;
+          if (symmetric) { store.density[jIdx] += change; }
+        }
+      }
+      profile::count(Counter::pairsInside, inside);
+      return sum;
+    }
+
+    // Scalar row over [first, last); returns the change of row.part
+    template <typename Policy, typename Accumulator = typename Policy::Accumulator>
+    std::array<Accumulator, 3> accelerationRowTail(BasicParticleStore<Policy> & store,
+                                                   PairRow row,
+                                                   KernelConstants const & constants,
+                                                   bool symmetric) {
+      auto const idx = static_cast<std::size_t>(row.part);
+      auto const slSq = static_cast<Accumulator>(constants.slSq);
+      Accumulator const pxi = store.px[idx];
+      Accumulator const pyi = store.py[idx];
+      Accumulator const pzi = store.pz[idx];
+      std::array<Accumulator, 3> sum = {0.0, 0.0, 0.0};
+      for (int jPart = row.first; jPart < row.last; jPart++) {
+        auto const jIdx = static_cast<std::size_t>(jPart);
+        Accumulator const xDiff = pxi - store.px[jIdx];
+        Accumulator const yDiff = pyi - store.py[jIdx];
+        Accumulator const zDiff = pzi - store.pz[jIdx];
+        if (xDiff * xDiff + yDiff * yDiff + zDiff * zDiff >= slSq) { continue; }
+        auto const accChange = pairAcceleration(store, row.part, jPart, constants);
+        sum[0] += accChange[0];
+        sum[1] += accChange[1];
+        sum[2] += accChange[2];
+        if (symmetric) {
+          store.ax[jIdx] -= accChange[0];
+          store.ay[jIdx] -= accChange[1];
+          store.az[jIdx] -= accChange[2];
+        }
+      }
+      return sum;
+    }
+
+    // Add the change of a whole row to its particle
+    template <typename Policy, typename Accumulator = typename Policy::Accumulator>
+    void addAcceleration(BasicParticleStore<Policy> & store, int part,
+                         std::array<Accumulator, 3> const & change) {
+      auto const idx = static_cast<std::size_t>(part);
+      store.ax[idx] += change[0];
+      store.ay[idx] += change[1];
+      store.az[idx] += change[2];
+    }
+  }  // namespace
+
+  Isa bestIsa() {
+#ifdef FLUID_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") != 0) { return Isa::avx512; }
+    if (__builtin_cpu_supports("avx2") != 0 and __builtin_cpu_supports("fma") != 0) {
+      return Isa::avx2;
+    }
+#endif
+    return Isa::scalar;
+  }
+
+  Isa activeIsa() { return currentIsa(); }
+
+  Isa setIsa(Isa isa) {
+    Isa const best = bestIsa();
+    currentIsa() = static_cast<int>(isa) <= static_cast<int>(best) ? isa : best;
+    return currentIsa();
+  }
+
+  void incDensityRow(ParticleStore & store, PairRow row, double slSq, bool symmetric) {
+    profile::count(Counter::candidatePairs, row.last - row.first);
+    switch (currentIsa()) {
+      case Isa::avx512:
+        incDensityRowAvx512(store, row, slSq, symmetric);
+        break;
+      case Isa::avx2:
+        incDensityRowAvx2(store, row, slSq, symmetric);
+        break;
+      case Isa::scalar:
+        incDensityRowScalar(store, row, slSq, symmetric);
+        break;
+    }
+  }
+
+  template <typename Policy>
+  void incDensityRowScalar(BasicParticleStore<Policy> & store, PairRow row, double slSq,
+                           bool symmetric) {
+    store.density[static_cast<std::size_t>(row.part)] +=
+        densityRowTail(store, row, slSq, symmetric);
+  }
+
+  // Pressure term along the line between the particles plus viscosity term
+  template <typename Policy>
+  std::array<typename Policy::Accumulator, 3>
+      pairAcceleration(BasicParticleStore<Policy> const & store, int iPart, int jPart,
+                       KernelConstants const & constants) {
+    using Accumulator = typename Policy::Accumulator;
+    auto const iIdx = static_cast<std::size_t>(iPart);
+    auto const jIdx = static_cast<std::size_t>(jPart);
+    Accumulator const xDiff = static_cast<Accumulator>(store.px[iIdx]) - store.px[jIdx];
+    Accumulator const yDiff = static_cast<Accumulator>(store.py[iIdx]) - store.py[jIdx];
+    Accumulator const zDiff = static_cast<Accumulator>(store.pz[iIdx]) - store.pz[jIdx];
+    Accumulator const distance =
+        std::sqrt(std::max(xDiff * xDiff + yDiff * yDiff + zDiff * zDiff,
+                           static_cast<Accumulator>(minDistanceSq)));
+    Accumulator const slDiff = static_cast<Accumulator>(constants.smoothingLength) - distance;
+    Accumulator const pressure =
+        static_cast<Accumulator>(constants.accTransConstant1) * (slDiff * slDiff / distance) *
+        (store.density[iIdx] + store.density[jIdx] -
+         static_cast<Accumulator>(2 * constants.fluidDensity));
+    auto const viscosity = static_cast<Accumulator>(constants.accTransConstant2);
+    Accumulator const denominator = store.density[iIdx] * store.density[jIdx];
+    Accumulator const vxDiff = static_cast<Accumulator>(store.vx[jIdx]) - store.vx[iIdx];
+    Accumulator const vyDiff = static_cast<Accumulator>(store.vy[jIdx]) - store.vy[iIdx];
+    Accumulator const vzDiff = static_cast<Accumulator>(store.vz[jIdx]) - store.vz[iIdx];
+    return {(xDiff * pressure + vxDiff * viscosity) / denominator,
+            (yDiff * pressure + vyDiff * viscosity) / denominator,
+            (zDiff * pressure + vzDiff * viscosity) / denominator};
+  }
+
+  void transferAccelerationRow(ParticleStore & store, PairRow row,
+                               KernelConstants const & constants, bool symmetric) {
+    switch (currentIsa()) {
+      case Isa::avx512:
+        transferAccelerationRowAvx512(store, row, constants, symmetric);
+        break;
+      case Isa::avx2:
+        transferAccelerationRowAvx2(store, row, constants, symmetric);
+        break;
+      case Isa::scalar:
+        transferAccelerationRowScalar(store, row, constants, symmetric);
+        break;
+    }
+  }
+
+  template <typename Policy>
+  void transferAccelerationRowScalar(BasicParticleStore<Policy> & store, PairRow row,
+                                     KernelConstants const & constants, bool symmetric) {
+    addAcceleration(store, row.part, accelerationRowTail(store, row, constants, symmetric));
+  }
+
+  // The scalar kernels for every precision policy
+#define FLUID_SCALAR_KERNELS(Policy)                                                        \
+  template void incDensityRowScalar(BasicParticleStore<Policy> &, PairRow, double, bool);   \
+  template std::array<Policy::Accumulator, 3> pairAcceleration(                             \
+      BasicParticleStore<Policy> const &, int, int, KernelConstants const &);               \
+  template void transferAccelerationRowScalar(BasicParticleStore<Policy> &, PairRow,        \
+                                              KernelConstants const &, bool);
+  FLUID_SCALAR_KERNELS(MixedPrecision)
+  FLUID_SCALAR_KERNELS(DoublePrecision)
+  FLUID_SCALAR_KERNELS(FloatPrecision)
+#undef FLUID_SCALAR_KERNELS
+
+#ifdef FLUID_SIMD_X86
+  // NOLINTBEGIN(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+
+  namespace {
+    // Sum of the 4 lanes of a register
+    __attribute__((target("avx2"))) double horizontalSumAvx2(__m256d sum) {
+      __m128d const half = _mm_add_pd(_mm256_castpd256_pd128(sum), _mm256_extractf128_pd(sum, 1));
+      return _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+    }
+  }  // namespace
+
+  // 8 candidates per iteration: squared distances and the smoothing length
+  // test in single precision, then the increase of the candidates inside
+  // the smoothing length in double precision (two halves of 4)
+  __attribute__((target("avx2,fma"))) void
+      incDensityRowAvx2(ParticleStore & store, PairRow row, double slSq, bool symmetric) {
+    constexpr int width = 8;
+    auto const idx = static_cast<std::size_t>(row.part);
+    __m256 const pxi = _mm256_set1_ps(store.px[idx]);
+    __m256 const pyi = _mm256_set1_ps(store.py[idx]);
+    __m256 const pzi = _mm256_set1_ps(store.pz[idx]);
+    __m256 const slSqPs = _mm256_set1_ps(static_cast<float>(slSq));
+    __m256d const slSqPd = _mm256_set1_pd(slSq);
+    __m256d sumLow = _mm256_setzero_pd();
+    __m256d sumHigh = _mm256_setzero_pd();
+    std::int64_t inside = 0;
+    float const * px = store.px.data();
+    float const * py = store.py.data();
+    float const * pz = store.pz.data();
+    double * density = store.density.data();
+
+    int jPart = row.first;
+    for (; jPart + width <= row.last; jPart += width) {
+      __m256 const xDiff = _mm256_sub_ps(pxi, _mm256_loadu_ps(px + jPart));
+      __m256 const yDiff = _mm256_sub_ps(pyi, _mm256_loadu_ps(py + jPart));
+      __m256 const zDiff = _mm256_sub_ps(pzi, _mm256_loadu_ps(pz + jPart));
+      __m256 const diffSum = _mm256_fmadd_ps(
+          zDiff, zDiff, _mm256_fmadd_ps(yDiff, yDiff, _mm256_mul_ps(xDiff, xDiff)));
+      if (_mm256_movemask_ps(_mm256_cmp_ps(diffSum, slSqPs, _CMP_LT_OQ)) == 0) { continue; }
+
+      __m256d const sumLowPd = _mm256_cvtps_pd(_mm256_castps256_ps128(diffSum));
+      __m256d const sumHighPd = _mm256_cvtps_pd(_mm256_extractf128_ps(diffSum, 1));
+      __m256d const insideLow = _mm256_cmp_pd(sumLowPd, slSqPd, _CMP_LT_OQ);
+      __m256d const insideHigh = _mm256_cmp_pd(sumHighPd, slSqPd, _CMP_LT_OQ);
+      inside += std::popcount(static_cast<unsigned>(_mm256_movemask_pd(insideLow))) +
+                std::popcount(static_cast<unsigned>(_mm256_movemask_pd(insideHigh)));
+      __m256d const diffLow = _mm256_and_pd(insideLow, _mm256_sub_pd(slSqPd, sumLowPd));
+      __m256d const diffHigh = _mm256_and_pd(insideHigh, _mm256_sub_pd(slSqPd, sumHighPd));
+      __m256d const changeLow = _mm256_mul_pd(_mm256_mul_pd(diffLow, diffLow), diffLow);
+      __m256d const changeHigh = _mm256_mul_pd(_mm256_mul_pd(diffHigh, diffHigh), diffHigh);
+      sumLow = _mm256_add_pd(sumLow, changeLow);
+      sumHigh = _mm256_add_pd(sumHigh, changeHigh);
+      if (symmetric) {
+        double * target = density + jPart;
+        _mm256_storeu_pd(target, _mm256_add_pd(_mm256_loadu_pd(target), changeLow));
+        _mm256_storeu_pd(target + 4, _mm256_add_pd(_mm256_loadu_pd(target + 4), changeHigh));
+      }
+    }
+
+    double const vectorSum = horizontalSumAvx2(_mm256_add_pd(sumLow, sumHigh));
+    // The scalar tail is not VEX encoded: clear the upper halves first, or
+    // every one of its instructions pays the AVX to SSE transition
+    _mm256_zeroupper();
+    double const tailSum = densityRowTail(store, {row.part, jPart, row.last}, slSq, symmetric);
+    density[idx] += vectorSum + tailSum;
+    profile::count(Counter::pairsInside, inside);
+  }
+
+  // 4 candidates per iteration in double precision: distance, pressure and
+  // viscosity multipliers and the three components stay in registers, and
+  // the lanes outside the smoothing length are zeroed by the mask
+  __attribute__((target("avx2,fma"))) void
+      transferAccelerationRowAvx2(ParticleStore & store, PairRow row,
+                                  KernelConstants const & constants, bool symmetric) {
+    constexpr int width = 4;
+    auto const idx = static_cast<std::size_t>(row.part);
+    __m256d const pxi = _mm256_set1_pd(store.px[idx]);
+    __m256d const pyi = _mm256_set1_pd(store.py[idx]);
+    __m256d const pzi = _mm256_set1_pd(store.pz[idx]);
+    __m256d const vxi = _mm256_set1_pd(store.vx[idx]);
+    __m256d const vyi = _mm256_set1_pd(store.vy[idx]);
+    __m256d const vzi = _mm256_set1_pd(store.vz[idx]);
+    __m256d const densityi = _mm256_set1_pd(store.density[idx]);
+    __m256d const densityOffset =
+        _mm256_set1_pd(store.density[idx] - 2 * constants.fluidDensity);
+    __m256d const slSq = _mm256_set1_pd(constants.slSq);
+    __m256d const smoothingLength = _mm256_set1_pd(constants.smoothingLength);
+    __m256d const minDistance = _mm256_set1_pd(minDistanceSq);
+    __m256d const pressureConstant = _mm256_set1_pd(constants.accTransConstant1);
+    __m256d const viscosity = _mm256_set1_pd(constants.accTransConstant2);
+    __m256d const one = _mm256_set1_pd(1.0);
+    __m256d sumX = _mm256_setzero_pd();
+    __m256d sumY = _mm256_setzero_pd();
+    __m256d sumZ = _mm256_setzero_pd();
+    float const * px = store.px.data();
+    float const * py = store.py.data();
+    float const * pz = store.pz.data();
+    float const * vx = store.vx.data();
+    float const * vy = store.vy.data();
+    float const * vz = store.vz.data();
+    double const * density = store.density.data();
+    double * ax = store.ax.data();
+    double * ay = store.ay.data();
+    double * az = store.az.data();
+
+    int jPart = row.first;
+    for (; jPart + width <= row.last; jPart += width) {
+      __m256d const xDiff = _mm256_sub_pd(pxi, _mm256_cvtps_pd(_mm_loadu_ps(px + jPart)));
+      __m256d const yDiff = _mm256_sub_pd(pyi, _mm256_cvtps_pd(_mm_loadu_ps(py + jPart)));
+      __m256d const zDiff = _mm256_sub_pd(pzi, _mm256_cvtps_pd(_mm_loadu_ps(pz + jPart)));
+      __m256d const diffSum = _mm256_fmadd_pd(
+          zDiff, zDiff, _mm256_fmadd_pd(yDiff, yDiff, _mm256_mul_pd(xDiff, xDiff)));
+      __m256d const inside = _mm256_cmp_pd(diffSum, slSq, _CMP_LT_OQ);
+      if (_mm256_movemask_pd(inside) == 0) { continue; }
+
+      __m256d const densityj = _mm256_loadu_pd(density + jPart);
+      __m256d const distance = _mm256_sqrt_pd(_mm256_max_pd(diffSum, minDistance));
+      __m256d const slDiff = _mm256_sub_pd(smoothingLength, distance);
+      __m256d const pressure = _mm256_mul_pd(
+          _mm256_mul_pd(pressureConstant,
+                        _mm256_div_pd(_mm256_mul_pd(slDiff, slDiff), distance)),
+          _mm256_add_pd(densityOffset, densityj));
+      __m256d const factor = _mm256_div_pd(one, _mm256_mul_pd(densityi, densityj));
+      __m256d const vxDiff = _mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(vx + jPart)), vxi);
+      // Lanes outside the smoothing length are zeroed
+      __m256d const changeX = _mm256_and_pd(
+          inside, _mm256_mul_pd(
+                      _mm256_fmadd_pd(xDiff, pressure, _mm256_mul_pd(vxDiff, viscosity)), factor));
+      __m256d const vyDiff = _mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(vy + jPart)), vyi);
+      __m256d const changeY = _mm256_and_pd(
+          inside, _mm256_mul_pd(
+                      _mm256_fmadd_pd(yDiff, pressure, _mm256_mul_pd(vyDiff, viscosity)), factor));
+      __m256d const vzDiff = _mm256_sub_pd(_mm256_cvtps_pd(_mm_loadu_ps(vz + jPart)), vzi);
+      __m256d const changeZ = _mm256_and_pd(
+          inside, _mm256_mul_pd(
+                      _mm256_fmadd_pd(zDiff, pressure, _mm256_mul_pd(vzDiff, viscosity)), factor));
+      sumX = _mm256_add_pd(sumX, changeX);
+      sumY = _mm256_add_pd(sumY, changeY);
+      sumZ = _mm256_add_pd(sumZ, changeZ);
+      if (symmetric) {
+        _mm256_storeu_pd(ax + jPart, _mm256_sub_pd(_mm256_loadu_pd(ax + jPart), changeX));
+        _mm256_storeu_pd(ay + jPart, _mm256_sub_pd(_mm256_loadu_pd(ay + jPart), changeY));
+        _mm256_storeu_pd(az + jPart, _mm256_sub_pd(_mm256_loadu_pd(az + jPart), changeZ));
+      }
+    }
+
+    std::array<double, 3> const vectorSum = {horizontalSumAvx2(sumX), horizontalSumAvx2(sumY),
+                                             horizontalSumAvx2(sumZ)};
+    _mm256_zeroupper();
+    auto const tailSum =
+        accelerationRowTail(store, {row.part, jPart, row.last}, constants, symmetric);
+    addAcceleration(store, row.part, {vectorSum[0] + tailSum[0], vectorSum[1] + tailSum[1],
+                                      vectorSum[2] + tailSum[2]});
+  }
+
+  // 16 candidates per iteration, with the lanes inside the smoothing length
+  // kept in mask registers
+  __attribute__((target("avx512f"))) void
+      incDensityRowAvx512(ParticleStore & store, PairRow row, double slSq, bool symmetric) {
+    constexpr int width = 16;
+    constexpr int halfWidth = 8;
+    auto const idx = static_cast<std::size_t>(row.part);
+    __m512 const pxi = _mm512_set1_ps(store.px[idx]);
+    __m512 const pyi = _mm512_set1_ps(store.py[idx]);
+    __m512 const pzi = _mm512_set1_ps(store.pz[idx]);
+    __m512 const slSqPs = _mm512_set1_ps(static_cast<float>(slSq));
+    __m512d const slSqPd = _mm512_set1_pd(slSq);
+    __m512d sumLow = _mm512_setzero_pd();
+    __m512d sumHigh = _mm512_setzero_pd();
+    std::int64_t inside = 0;
+    float const * px = store.px.data();
+    float const * py = store.py.data();
+    float const * pz = store.pz.data();
+    double * density = store.density.data();
+
+    int jPart = row.first;
+    for (; jPart + width <= row.last; jPart += width) {
+      __m512 const xDiff = _mm512_sub_ps(pxi, _mm512_loadu_ps(px + jPart));
+      __m512 const yDiff = _mm512_sub_ps(pyi, _mm512_loadu_ps(py + jPart));
+      __m512 const zDiff = _mm512_sub_ps(pzi, _mm512_loadu_ps(pz + jPart));
+      __m512 const diffSum = _mm512_fmadd_ps(
+          zDiff, zDiff, _mm512_fmadd_ps(yDiff, yDiff, _mm512_mul_ps(xDiff, xDiff)));
+      if (_mm512_cmp_ps_mask(diffSum, slSqPs, _CMP_LT_OQ) == 0) { continue; }
+
+      __m512d const sumLowPd = _mm512_cvtps_pd(_mm512_castps512_ps256(diffSum));
+      __m512d const sumHighPd = _mm512_cvtps_pd(
+          _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(diffSum), 1)));
+      __mmask8 const insideLow = _mm512_cmp_pd_mask(sumLowPd, slSqPd, _CMP_LT_OQ);
+      __mmask8 const insideHigh = _mm512_cmp_pd_mask(sumHighPd, slSqPd, _CMP_LT_OQ);
+      inside += std::popcount(static_cast<unsigned>(insideLow)) +
+                std::popcount(static_cast<unsigned>(insideHigh));
+      __m512d const diffLow = _mm512_maskz_sub_pd(insideLow, slSqPd, sumLowPd);
+      __m512d const diffHigh = _mm512_maskz_sub_pd(insideHigh, slSqPd, sumHighPd);
+      __m512d const changeLow = _mm512_mul_pd(_mm512_mul_pd(diffLow, diffLow), diffLow);
+      __m512d const changeHigh = _mm512_mul_pd(_mm512_mul_pd(diffHigh, diffHigh), diffHigh);
+      sumLow = _mm512_add_pd(sumLow, changeLow);
+      sumHigh = _mm512_add_pd(sumHigh, changeHigh);
+      if (symmetric) {
+        double * target = density + jPart;
+        _mm512_mask_storeu_pd(target, insideLow,
+                              _mm512_add_pd(_mm512_loadu_pd(target), changeLow));
+        _mm512_mask_storeu_pd(target + halfWidth, insideHigh,
+                              _mm512_add_pd(_mm512_loadu_pd(target + halfWidth), changeHigh));
+      }
+    }
+
+    double const vectorSum = _mm512_reduce_add_pd(_mm512_add_pd(sumLow, sumHigh));
+    _mm256_zeroupper();
+    double const tailSum = densityRowTail(store, {row.part, jPart, row.last}, slSq, symmetric);
+    density[idx] += vectorSum + tailSum;
+    profile::count(Counter::pairsInside, inside);
+  }
+
+  // 8 candidates per iteration in double precision, with the lanes inside
+  // the smoothing length kept in a mask register
+  __attribute__((target("avx512f"))) void
+      transferAccelerationRowAvx512(ParticleStore & store, PairRow row,
+                                    KernelConstants const & constants, bool symmetric) {
+    constexpr int width = 8;
+    auto const idx = static_cast<std::size_t>(row.part);
+    __m512d const pxi = _mm512_set1_pd(store.px[idx]);
+    __m512d const pyi = _mm512_set1_pd(store.py[idx]);
+    __m512d const pzi = _mm512_set1_pd(store.pz[idx]);
+    __m512d const vxi = _mm512_set1_pd(store.vx[idx]);
+    __m512d const vyi = _mm512_set1_pd(store.vy[idx]);
+    __m512d const vzi = _mm512_set1_pd(store.vz[idx]);
+    __m512d const densityi = _mm512_set1_pd(store.density[idx]);
+    __m512d const densityOffset =
+        _mm512_set1_pd(store.density[idx] - 2 * constants.fluidDensity);
+    __m512d const slSq = _mm512_set1_pd(constants.slSq);
+    __m512d const smoothingLength = _mm512_set1_pd(constants.smoothingLength);
+    __m512d const minDistance = _mm512_set1_pd(minDistanceSq);
+    __m512d const pressureConstant = _mm512_set1_pd(constants.accTransConstant1);
+    __m512d const viscosity = _mm512_set1_pd(constants.accTransConstant2);
+    __m512d const one = _mm512_set1_pd(1.0);
+    __m512d sumX = _mm512_setzero_pd();
+    __m512d sumY = _mm512_setzero_pd();
+    __m512d sumZ = _mm512_setzero_pd();
+    float const * px = store.px.data();
+    float const * py = store.py.data();
+    float const * pz = store.pz.data();
+    float const * vx = store.vx.data();
+    float const * vy = store.vy.data();
+    float const * vz = store.vz.data();
+    double const * density = store.density.data();
+    double * ax = store.ax.data();
+    double * ay = store.ay.data();
+    double * az = store.az.data();
+
+    int jPart = row.first;
+    for (; jPart + width <= row.last; jPart += width) {
+      __m512d const xDiff = _mm512_sub_pd(pxi, _mm512_cvtps_pd(_mm256_loadu_ps(px + jPart)));
+      __m512d const yDiff = _mm512_sub_pd(pyi, _mm512_cvtps_pd(_mm256_loadu_ps(py + jPart)));
+      __m512d const zDiff = _mm512_sub_pd(pzi, _mm512_cvtps_pd(_mm256_loadu_ps(pz + jPart)));
+      __m512d const diffSum = _mm512_fmadd_pd(
+          zDiff, zDiff, _mm512_fmadd_pd(yDiff, yDiff, _mm512_mul_pd(xDiff, xDiff)));
+      __mmask8 const inside = _mm512_cmp_pd_mask(diffSum, slSq, _CMP_LT_OQ);
+      if (inside == 0) { continue; }
+
+      __m512d const densityj = _mm512_maskz_loadu_pd(inside, density + jPart);
+      __m512d const distance = _mm512_sqrt_pd(_mm512_max_pd(diffSum, minDistance));
+      __m512d const slDiff = _mm512_sub_pd(smoothingLength, distance);
+      __m512d const pressure = _mm512_mul_pd(
+          _mm512_mul_pd(pressureConstant,
+                        _mm512_div_pd(_mm512_mul_pd(slDiff, slDiff), distance)),
+          _mm512_add_pd(densityOffset, densityj));
+      __m512d const factor = _mm512_div_pd(one, _mm512_mul_pd(densityi, densityj));
+      __m512d const vxDiff = _mm512_sub_pd(_mm512_cvtps_pd(_mm256_loadu_ps(vx + jPart)), vxi);
+      __m512d const changeX = _mm512_maskz_mul_pd(
+          inside, _mm512_fmadd_pd(xDiff, pressure, _mm512_mul_pd(vxDiff, viscosity)), factor);
+      __m512d const vyDiff = _mm512_sub_pd(_mm512_cvtps_pd(_mm256_loadu_ps(vy + jPart)), vyi);
+      __m512d const changeY = _mm512_maskz_mul_pd(
+          inside, _mm512_fmadd_pd(yDiff, pressure, _mm512_mul_pd(vyDiff, viscosity)), factor);
+      __m512d const vzDiff = _mm512_sub_pd(_mm512_cvtps_pd(_mm256_loadu_ps(vz + jPart)), vzi);
+      __m512d const changeZ = _mm512_maskz_mul_pd(
+          inside, _mm512_fmadd_pd(zDiff, pressure, _mm512_mul_pd(vzDiff, viscosity)), factor);
+      sumX = _mm512_add_pd(sumX, changeX);
+      sumY = _mm512_add_pd(sumY, changeY);
+      sumZ = _mm512_add_pd(sumZ, changeZ);
+      if (symmetric) {
+        _mm512_mask_storeu_pd(ax + jPart, inside,
+                              _mm512_sub_pd(_mm512_loadu_pd(ax + jPart), changeX));
+        _mm512_mask_storeu_pd(ay + jPart, inside,
+                              _mm512_sub_pd(_mm512_loadu_pd(ay + jPart), changeY));
+        _mm512_mask_storeu_pd(az + jPart, inside,
+                              _mm512_sub_pd(_mm512_loadu_pd(az + jPart), changeZ));
+      }
+    }
+
+    std::array<double, 3> const vectorSum = {_mm512_reduce_add_pd(sumX),
+                                             _mm512_reduce_add_pd(sumY),
+                                             _mm512_reduce_add_pd(sumZ)};
+    _mm256_zeroupper();
+    auto const tailSum =
+        accelerationRowTail(store, {row.part, jPart, row.last}, constants, symmetric);
+    addAcceleration(store, row.part, {vectorSum[0] + tailSum[0], vectorSum[1] + tailSum[1],
+                                      vectorSum[2] + tailSum[2]});
+  }
+
+  // NOLINTEND(cppcoreguidelines-pro-bounds-pointer-arithmetic)
+#else
+  void incDensityRowAvx2(ParticleStore & store, PairRow row, double slSq, bool symmetric) {
+    incDensityRowScalar(store, row, slSq, symmetric);
+  }
+
+  void incDensityRowAvx512(ParticleStore & store, PairRow row, double slSq, bool symmetric) {
+    incDensityRowScalar(store, row, slSq, symmetric);
+  }
+
+  void transferAccelerationRowAvx2(ParticleStore & store, PairRow row,
+                                   KernelConstants const & constants, bool symmetric) {
+    transferAccelerationRowScalar(store, row, constants, symmetric);
+  }
+
+  void transferAccelerationRowAvx512(ParticleStore & store, PairRow row,
+                                     KernelConstants const & constants, bool symmetric) {
+    transferAccelerationRowScalar(store, row, constants, symmetric);
+  }
+#endif
+}  // namespace simd
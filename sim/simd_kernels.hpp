@@ -0,0 +1,68 @@
+#ifndef FLUID_SIMD_KERNELS_HPP
+#define FLUID_SIMD_KERNELS_HPP
+
+#include "constants.hpp"
+#include "particle_store.hpp"
+
+#include <array>
+
+// Vectorized particle interaction kernels. Every kernel works on a row: one
+// particle against a contiguous range of particles of the store, which is
+// how blocks lay out their particles after repositioning. The scalar kernels
+// are templates instantiated for every precision policy; the vector kernels
+// exist for the mixed policy, and the other policies use the scalar ones
+namespace simd {
+  // Instruction sets with a kernel implementation
+  enum class Isa { scalar, avx2, avx512 };
+
+  // One particle against the particles [first, last) of the store
+  struct PairRow {
+    int part;
+    int first;
+    int last;
+  };
+
+  // Best instruction set supported by the running CPU
+  [[nodiscard]] Isa bestIsa();
+
+  // Instruction set used by the kernels (bestIsa() unless changed)
+  [[nodiscard]] Isa activeIsa();
+
+  // Use isa for the kernels if the CPU supports it; returns the one in use
+  Isa setIsa(Isa isa);
+
+  // Add to the density of row.part the increase from every particle of the
+  // row within the smoothing length. If symmetric, the increase of each
+  // pair is also added to the other particle
+  void incDensityRow(ParticleStore & store, PairRow row, double slSq, bool symmetric);
+
+  // Same as incDensityRow with an explicit instruction set
+  template <typename Policy>
+  void incDensityRowScalar(BasicParticleStore<Policy> & store, PairRow row, double slSq,
+                           bool symmetric);
+  void incDensityRowAvx2(ParticleStore & store, PairRow row, double slSq, bool symmetric);
+  void incDensityRowAvx512(ParticleStore & store, PairRow row, double slSq, bool symmetric);
+
+  // Acceleration change of particle iPart caused by particle jPart
+  template <typename Policy>
+  [[nodiscard]] std::array<typename Policy::Accumulator, 3>
+      pairAcceleration(BasicParticleStore<Policy> const & store, int iPart, int jPart,
+                       KernelConstants const & constants);
+
+  // Add to the acceleration of row.part the change caused by every particle
+  // of the row within the smoothing length. If symmetric, the change of
+  // each pair is also subtracted from the other particle
+  void transferAccelerationRow(ParticleStore & store, PairRow row,
+                               KernelConstants const & constants, bool symmetric);
+
+  // Same as transferAccelerationRow with an explicit instruction set
+  template <typename Policy>
+  void transferAccelerationRowScalar(BasicParticleStore<Policy> & store, PairRow row,
+                                     KernelConstants const & constants, bool symmetric);
+  void transferAccelerationRowAvx2(ParticleStore & store, PairRow row,
+                                   KernelConstants const & constants, bool symmetric);
+  void transferAccelerationRowAvx512(ParticleStore & store, PairRow row,
+                                     KernelConstants const & constants, bool symmetric);
+}  // namespace simd
+
+#endif  // FLUID_SIMD_KERNELS_HPP
@@ -1,32 +1,256 @@
 // Need to create a function that will do the simulation for ONE iteration...
 #include "simulation.hpp"
 
-// What arguments?
-// One particle, and then we can check its block info for adjacent particles?
-void simulateOneStep(const Grid &simGrid) {
-  // get blocks in a dictionary from simGrid
-  auto blocksDict = simGrid.get_blocks();
-
-  for (const auto &blockPair : blocksDict) {
-    Block blockObj = blockPair.second;
-    for (auto particle : blockObj.getParticles()) {
-      // Run each member function of a block on the particle in question
-      blockObj.accelerationTransfer(particle, simGrid.get_slSq(),
-                                    simGrid.get_accTransConstant1(),
-                                    simGrid.get_accTransConstant2());
-      blockObj.incDensity(particle, simGrid.get_slSq(), simGrid.get_slSixth(),
-                          simGrid.get_densTransConstant());
-      // TODO: check if works, if not change pack to blockObj
-      Block::boxCollisions(particle);
-      Block::particleMotion(particle);
-      Block::boundaryCollisions(particle);
+namespace {
+  // Run function on every particle, split across the pool
+  template <typename Function>
+  void forEachParticle(Grid &simGrid, ThreadPool &pool, Function function) {
+    ParticleStore &store = simGrid.get_particles();
+    pool.parallelFor(store.size(), [&store, &function](int begin, int end) {
+      for (int particle = begin; particle < end; particle++) { function(store, particle); }
+    });
+  }
+
+  // Run kernel on every particle with the configuration of the grid. The
+  // default configuration is passed as a compile time constant, so only
+  // other configurations pay for reading it
+  template <typename Kernel>
+  void forEachParticle(Grid &simGrid, ThreadPool &pool, Kernel kernel,
+                       SimulationConfig const &config) {
+    if (config == defaultConfig) {
+      forEachParticle(simGrid, pool, [&kernel](ParticleStore &store, int particle) {
+        kernel(store, particle, DefaultConfigSource{});
+      });
+    } else {
+      RuntimeConfigSource const source{&config};
+      forEachParticle(simGrid, pool, [&kernel, source](ParticleStore &store, int particle) {
+        kernel(store, particle, source);
+      });
+    }
+  }
+
+  // Run kernel on every block that touches a face of the grid, with its
+  // faces and the configuration of the grid (passed as forEachParticle does)
+  template <typename Kernel>
+  void forEachBoundaryBlock(Grid &simGrid, ThreadPool &pool, Kernel kernel) {
+    ParticleStore &store = simGrid.get_particles();
+    std::vector<Block> const &blocks = simGrid.get_blocks();
+    NeighbourStencil const &stencil = simGrid.get_stencil();
+    std::span<int const> const boundary = simGrid.get_boundaryBlocks();
+    auto const blockAt = [&blocks, boundary](int index) -> Block const & {
+      return blocks[static_cast<std::size_t>(boundary[static_cast<std::size_t>(index)])];
+    };
+    auto const run = [&](auto const &config) {
+      pool.parallelFor(
+          static_cast<int>(boundary.size()),
+          [&](int begin, int end) {
+            for (int index = begin; index < end; index++) {
+              auto const faces = stencil.faces(boundary[static_cast<std::size_t>(index)]);
+              kernel(blockAt(index), store, faces, config);
+            }
+          },
+          [&blockAt](int index) { return blockAt(index).size() + 1; });
+    };
+    if (simGrid.get_config() == defaultConfig) {
+      run(DefaultConfigSource{});
+    } else {
+      run(RuntimeConfigSource{&simGrid.get_config()});
     }
   }
+
+  // Run function on every block, with chunks of blocks weighted by their
+  // particles. Gathering only writes the block's own particles, so any
+  // blocks can run at the same time; visiting pairs symmetrically also
+  // writes the forward blocks, so the rows of blocks run one colour at a time
+  template <typename Function>
+  void forEachBlock(Grid &simGrid, PairMode mode, ThreadPool &pool, Function function) {
+    std::vector<Block> const &blocks = simGrid.get_blocks();
+    if (mode == PairMode::gather) {
+      // In the order of the particles, so that each chunk walks memory forward
+      std::span<int const> const order = simGrid.get_blockOrder();
+      auto const blockAt = [&blocks, order](int rank) -> Block const & {
+        return blocks[static_cast<std::size_t>(order[static_cast<std::size_t>(rank)])];
+      };
+      pool.parallelFor(
+          simGrid.get_numBlocks(),
+          [&blockAt, &function](int begin, int end) {
+            for (int rank = begin; rank < end; rank++) { function(blockAt(rank)); }
+          },
+          [&blockAt](int rank) { return blockAt(rank).size() + 1; });
+      return;
+    }
+    int const rowLength = simGrid.get_numberX();
+    for (int colour = 0; colour < Grid::numColours; colour++) {
+      std::span<int const> const rows = simGrid.get_colourRows(colour);
+      pool.parallelFor(
+          static_cast<int>(rows.size()),
+          [&blocks, &function, rows, rowLength](int begin, int end) {
+            for (auto const rowStart : rows.subspan(static_cast<std::size_t>(begin),
+                                                    static_cast<std::size_t>(end - begin))) {
+              for (int block = rowStart; block < rowStart + rowLength; block++) {
+                function(blocks[static_cast<std::size_t>(block)]);
+              }
+            }
+          },
+          [&blocks, rows, rowLength](int row) {
+            // The blocks of a row are not contiguous in the store under the
+            // morton and hilbert orders, so their sizes are added up
+            int const rowStart = rows[static_cast<std::size_t>(row)];
+            int weight = 0;
+            for (int block = rowStart; block < rowStart + rowLength; block++) {
+              weight += blocks[static_cast<std::size_t>(block)].size() + 1;
+            }
+            return weight;
+          });
+    }
+  }
+
+  // Runs one stage of a step: timed into the profiler, then traced
+  struct StageRunner {
+    Grid &grid;
+    ThreadPool &pool;
+    StageTracer *tracer;
+    Profiler *profiler;
+
+    template <typename Stage>
+    void operator()(TraceStage stage, Stage const &run) const {
+      {
+        PhaseTimer const timer(profiler, static_cast<Phase>(static_cast<int>(Phase::repos) +
+                                                            static_cast<int>(stage)));
+        run();
+      }
+      traceStage(tracer, stage, grid, pool);
+    }
+  };
+}  // namespace
+
+// Density starts at zero and acceleration at the external acceleration
+void initAccelerations(Grid &simGrid, ThreadPool &pool) {
+  forEachParticle(
+      simGrid, pool,
+      [](ParticleStore &store, int particle, auto const &config) {
+        Block::initAcceleration(store, particle, config);
+      },
+      simGrid.get_config());
+}
+
+// Sum the density increases of every pair
+void incrementDensities(Grid &simGrid, PairMode mode, ThreadPool &pool) {
+  ParticleStore &store = simGrid.get_particles();
+  double const slSq = simGrid.get_slSq();
+  forEachBlock(simGrid, mode, pool, [&store, slSq, mode](Block const &blockObj) {
+    if (mode == PairMode::symmetric) {
+      blockObj.incDensityPairs(store, slSq);
+      return;
+    }
+    for (int particle = blockObj.get_begin(); particle < blockObj.get_end(); particle++) {
+      blockObj.incDensity(store, particle, slSq);
+    }
+  });
+}
+
+void transformDensities(Grid &simGrid, ThreadPool &pool) {
+  KernelConstants const constants = simGrid.get_kernelConstants();
+  forEachParticle(simGrid, pool, [&constants](ParticleStore &store, int particle) {
+    Block::transformDensity(store, particle, constants);
+  });
+}
+
+// Accelerations from the densities of every pair
+void transferAccelerations(Grid &simGrid, PairMode mode, ThreadPool &pool) {
+  ParticleStore &store = simGrid.get_particles();
+  KernelConstants const constants = simGrid.get_kernelConstants();
+  forEachBlock(simGrid, mode, pool, [&store, &constants, mode](Block const &blockObj) {
+    if (mode == PairMode::symmetric) {
+      blockObj.accelerationTransferPairs(store, constants);
+      return;
+    }
+    for (int particle = blockObj.get_begin(); particle < blockObj.get_end(); particle++) {
+      blockObj.accelerationTransfer(store, particle, constants);
+    }
+  });
+}
+
+void incrementDensities(Grid &simGrid, NeighbourList const &lists, ThreadPool &pool) {
+  double const slSq = simGrid.get_slSq();
+  forEachParticle(simGrid, pool, [&lists, slSq](ParticleStore &store, int particle) {
+    lists.incDensity(store, particle, slSq);
+  });
+}
+
+void transferAccelerations(Grid &simGrid, NeighbourList const &lists, ThreadPool &pool) {
+  KernelConstants const constants = simGrid.get_kernelConstants();
+  forEachParticle(simGrid, pool, [&lists, &constants](ParticleStore &store, int particle) {
+    lists.accelerationTransfer(store, particle, constants);
+  });
+}
+
+// Wall collisions only for the particles of blocks on the faces of the grid,
+// testing the walls of those faces, as the reference does. With Verlet lists
+// a particle belongs to the block it was sorted into at the last rebuild
+void processCollisions(Grid &simGrid, ThreadPool &pool) {
+  forEachBoundaryBlock(simGrid, pool,
+                       [](Block const &blockObj, ParticleStore &store, std::uint8_t faces,
+                          auto const &config) {
+                         blockObj.processBoxCollisions(store, faces, config);
+                       });
+}
+
+void moveParticles(Grid &simGrid, ThreadPool &pool) {
+  forEachParticle(
+      simGrid, pool,
+      [](ParticleStore &store, int particle, auto const &config) {
+        Block::particleMotion(store, particle, config);
+      },
+      simGrid.get_config());
+}
+
+void processBoundaries(Grid &simGrid, ThreadPool &pool) {
+  forEachBoundaryBlock(simGrid, pool,
+                       [](Block const &blockObj, ParticleStore &store, std::uint8_t faces,
+                          auto const &config) {
+                         blockObj.processBoundaryCollisions(store, faces, config);
+                       });
+}
+
+// One time step, in the stages listed in the README
+void simulateOneStep(Grid &simGrid, PairMode mode, ThreadPool &pool, StageTracer *tracer,
+                     Profiler *profiler) {
+  StageRunner const stage{simGrid, pool, tracer, profiler};
+  // Repositioning of particles in the grid
+  stage(TraceStage::repos, [&simGrid] { simGrid.repositionParticles(); });
+
+  // Computing forces and accelerations for each particle
+  stage(TraceStage::initacc, [&simGrid, &pool] { initAccelerations(simGrid, pool); });
+  stage(TraceStage::densinc, [&simGrid, mode, &pool] { incrementDensities(simGrid, mode, pool); });
+  stage(TraceStage::denstransf, [&simGrid, &pool] { transformDensities(simGrid, pool); });
+  stage(TraceStage::acctransf,
+        [&simGrid, mode, &pool] { transferAccelerations(simGrid, mode, pool); });
+
+  // Collisions with boundaries, movement and box boundary interactions
+  stage(TraceStage::partcol, [&simGrid, &pool] { processCollisions(simGrid, pool); });
+  stage(TraceStage::motion, [&simGrid, &pool] { moveParticles(simGrid, pool); });
+  stage(TraceStage::boundint, [&simGrid, &pool] { processBoundaries(simGrid, pool); });
 }
 
-// Do I need to verify particle blocks?
-//
-//         part.updateBlock(part.position[0], part.position[1],
-//         part.position[2]); // Probably should write an update_block field in
-//         particle class
-//            adjParticle = findBlock(adjParticle);
+void simulateOneStep(Grid &simGrid, NeighbourList &lists, ThreadPool &pool,
+                     StageTracer *tracer, Profiler *profiler) {
+  StageRunner const stage{simGrid, pool, tracer, profiler};
+  // Repositioning of particles in the grid, only together with the lists
+  stage(TraceStage::repos, [&simGrid, &lists, &pool] {
+    if (lists.needsRebuild(simGrid.get_particles())) { lists.rebuild(simGrid, pool); }
+  });
+
+  // Computing forces and accelerations for each particle
+  stage(TraceStage::initacc, [&simGrid, &pool] { initAccelerations(simGrid, pool); });
+  stage(TraceStage::densinc,
+        [&simGrid, &lists, &pool] { incrementDensities(simGrid, lists, pool); });
+  stage(TraceStage::denstransf, [&simGrid, &pool] { transformDensities(simGrid, pool); });
+  stage(TraceStage::acctransf,
+        [&simGrid, &lists, &pool] { transferAccelerations(simGrid, lists, pool); });
+
+  // Collisions with boundaries, movement and box boundary interactions
+  stage(TraceStage::partcol, [&simGrid, &pool] { processCollisions(simGrid, pool); });
+  stage(TraceStage::motion, [&simGrid, &pool] { moveParticles(simGrid, pool); });
+  stage(TraceStage::boundint, [&simGrid, &pool] { processBoundaries(simGrid, pool); });
+}
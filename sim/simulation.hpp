@@ -3,7 +3,52 @@
 #define FLUID_SIMULATION_HPP
 #include "block.hpp"
 #include "grid.hpp"
+#include "neighbour_list.hpp"
+#include "profiler.hpp"
+#include "stage_tracer.hpp"
+#include "thread_pool.hpp"
 
-void simulateOneStep(const Grid &simGrid);
+// How particle interactions are visited
+enum class PairMode {
+  // Every particle gathers the contributions of all its neighbours, so each
+  // pair is visited twice but only one particle is written
+  gather,
+  // Every pair is visited once and the contribution is applied to both
+  // particles
+  symmetric
+};
+
+// Every stage runs on the threads of pool and returns once all of them are
+// done. In symmetric mode the rows of blocks run colour by colour, so the
+// result does not depend on the number of threads. A tracer captures the
+// state after the stages it traces, a profiler adds up the time of each stage
+void simulateOneStep(Grid &simGrid, PairMode mode = PairMode::symmetric,
+                     ThreadPool &pool = ThreadPool::serial(), StageTracer *tracer = nullptr,
+                     Profiler *profiler = nullptr);
+
+// Stages of one time step, in the order simulateOneStep runs them
+void initAccelerations(Grid &simGrid, ThreadPool &pool = ThreadPool::serial());
+void incrementDensities(Grid &simGrid, PairMode mode, ThreadPool &pool = ThreadPool::serial());
+void transformDensities(Grid &simGrid, ThreadPool &pool = ThreadPool::serial());
+void transferAccelerations(Grid &simGrid, PairMode mode,
+                           ThreadPool &pool = ThreadPool::serial());
+// The wall stages only visit the particles of the blocks on the faces of
+// the grid, by the ranges of the last repositioning
+void processCollisions(Grid &simGrid, ThreadPool &pool = ThreadPool::serial());
+void moveParticles(Grid &simGrid, ThreadPool &pool = ThreadPool::serial());
+void processBoundaries(Grid &simGrid, ThreadPool &pool = ThreadPool::serial());
+
+// One time step with Verlet lists. The particles are only repositioned when
+// the lists are rebuilt, which happens once some particle has moved more
+// than half the skin
+void simulateOneStep(Grid &simGrid, NeighbourList &lists,
+                     ThreadPool &pool = ThreadPool::serial(), StageTracer *tracer = nullptr,
+                     Profiler *profiler = nullptr);
+
+// Pair stages over the Verlet lists
+void incrementDensities(Grid &simGrid, NeighbourList const &lists,
+                        ThreadPool &pool = ThreadPool::serial());
+void transferAccelerations(Grid &simGrid, NeighbourList const &lists,
+                           ThreadPool &pool = ThreadPool::serial());
 
 #endif // FLUID_SIMULATION_HPP
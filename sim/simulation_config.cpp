@@ -0,0 +1,96 @@
+#include "simulation_config.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+namespace {
+  constexpr std::array<std::pair<std::string_view, double SimulationConfig::*>, 8> scalars = {{
+      {"radiusMultiplier", &SimulationConfig::radiusMultiplier},
+      {"fluidDensity", &SimulationConfig::fluidDensity},
+      {"stiffnessPressure", &SimulationConfig::stiffnessPressure},
+      {"stiffnessCollisions", &SimulationConfig::stiffnessCollisions},
+      {"damping", &SimulationConfig::damping},
+      {"viscosity", &SimulationConfig::viscosity},
+      {"particleSize", &SimulationConfig::particleSize},
+      {"timeStep", &SimulationConfig::timeStep},
+  }};
+
+  constexpr std::array<std::pair<std::string_view, std::array<double, 3> SimulationConfig::*>, 3>
+      vectors = {{
+          {"externalAcceleration", &SimulationConfig::externalAcceleration},
+          {"boxLowerBound", &SimulationConfig::boxLowerBound},
+          {"boxUpperBound", &SimulationConfig::boxUpperBound},
+      }};
+
+  // Text without the blanks around it
+  std::string_view trim(std::string_view text) {
+    auto const first = text.find_first_not_of(" \t\r");
+    if (first == std::string_view::npos) { return {}; }
+    return text.substr(first, text.find_last_not_of(" \t\r") - first + 1);
+  }
+
+  // Read count blank separated numbers from text; false unless there are
+  // exactly count
+  template <std::size_t Count>
+  bool parseValues(std::string_view text, std::array<double, Count> &values) {
+    for (std::size_t value = 0; value < Count; value++) {
+      text = trim(text);
+      auto const [end, error] = std::from_chars(text.data(), text.data() + text.size(),
+                                                values[value]);
+      if (error != std::errc{}) { return false; }
+      text.remove_prefix(static_cast<std::size_t>(end - text.data()));
+    }
+    return trim(text).empty();
+  }
+
+  // Set the member called name; false if there is none or the value is bad
+  bool setMember(SimulationConfig &config, std::string_view name, std::string_view value) {
+    for (auto const &[scalarName, member] : scalars) {
+      if (name != scalarName) { continue; }
+      std::array<double, 1> parsed{};
+      if (not parseValues(value, parsed)) { return false; }
+      config.*member = parsed[0];
+      return true;
+    }
+    for (auto const &[vectorName, member] : vectors) {
+      if (name == vectorName) { return parseValues(value, config.*member); }
+    }
+    return false;
+  }
+}  // namespace
+
+SimulationConfig readConfig(std::string const &filename) {
+  std::ifstream file(filename);
+  if (not file) { throw std::runtime_error(filename + ": cannot open the configuration"); }
+  SimulationConfig config;
+  std::string line;
+  for (int number = 1; std::getline(file, line); number++) {
+    std::string_view text = line;
+    text = trim(text.substr(0, text.find('#')));
+    if (text.empty()) { continue; }
+    auto const equals = text.find('=');
+    std::string_view const name = trim(text.substr(0, std::min(equals, text.size())));
+    if (equals == std::string_view::npos or
+        not setMember(config, name, text.substr(equals + 1))) {
+      std::ostringstream message;
+      message << filename << ':' << number << ": invalid setting: " << line;
+      throw std::runtime_error(message.str());
+    }
+  }
+
+  bool valid = config.timeStep > 0 and config.radiusMultiplier > 0 and
+               config.fluidDensity > 0 and config.particleSize >= 0;
+  for (std::size_t axis = 0; axis < 3; axis++) {
+    valid = valid and config.boxLowerBound[axis] < config.boxUpperBound[axis];
+  }
+  if (not valid) {
+    throw std::runtime_error(filename + ": the time step, radius multiplier and density must "
+                                        "be positive and every lower bound below its upper one");
+  }
+  return config;
+}
@@ -0,0 +1,48 @@
+#ifndef FLUID_SIMULATION_CONFIG_HPP
+#define FLUID_SIMULATION_CONFIG_HPP
+
+#include "constants.hpp"
+
+#include <array>
+#include <string>
+
+// Physical constants and tank of a simulation, the defaults of
+// constants.hpp unless a configuration file changes them
+struct SimulationConfig {
+  double radiusMultiplier{Constants::radiusMultiplier};
+  double fluidDensity{Constants::fluidDensity};
+  double stiffnessPressure{Constants::stiffnessPressure};
+  double stiffnessCollisions{Constants::stiffnessCollisions};
+  double damping{Constants::damping};
+  double viscosity{Constants::viscosity};
+  double particleSize{Constants::particleSize};
+  double timeStep{Constants::timeStep};
+  std::array<double, 3> externalAcceleration{Constants::externalAcceleration};
+  std::array<double, 3> boxLowerBound{Constants::boxLowerBound};
+  std::array<double, 3> boxUpperBound{Constants::boxUpperBound};
+
+  constexpr bool operator==(SimulationConfig const &other) const = default;
+};
+
+inline constexpr SimulationConfig defaultConfig{};
+
+// Read a configuration file: "name = value" lines, with the names of the
+// SimulationConfig members, three values for the vectors and '#' comments.
+// Members not in the file keep their default. Throws std::runtime_error
+// naming the line of an unknown name or a bad value, and for a time step,
+// radius multiplier or density that is not positive or an empty box
+[[nodiscard]] SimulationConfig readConfig(std::string const &filename);
+
+// Where the per-particle kernels read the configuration. With
+// DefaultConfigSource it is a compile time constant, so the bounds and
+// constants fold into the code; RuntimeConfigSource reads a loaded one
+struct DefaultConfigSource {
+  [[nodiscard]] static constexpr SimulationConfig const &get() { return defaultConfig; }
+};
+
+struct RuntimeConfigSource {
+  SimulationConfig const *config;
+  [[nodiscard]] SimulationConfig const &get() const { return *config; }
+};
+
+#endif  // FLUID_SIMULATION_CONFIG_HPP
@@ -0,0 +1,445 @@
+#include "snapshot_archive.hpp"
+
+#include "constants.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+  constexpr std::array<std::byte, 4> magic = {std::byte{'F'}, std::byte{'L'}, std::byte{'D'},
+                                              std::byte{'Z'}};
+  constexpr std::uint32_t version = 1;
+
+  // Bytes of the header (magic, version, ppm, np, parameters and box
+  // bounds), of an index entry and of the trailer (index offset, number of
+  // frames and magic)
+  constexpr std::size_t headerBytes = 4 + 4 + 4 + 4 + 4 + 4 + 8 + 6 * 8;
+  constexpr std::size_t entryBytes = 8 + 8 + 4 + 4;
+  constexpr std::size_t trailerBytes = 8 + 4 + 4;
+
+  // .fld layout: ppm and np, then nine floats per particle
+  constexpr std::size_t fldHeaderBytes = sizeof(float) + sizeof(std::int32_t);
+  constexpr std::size_t fldRecordBytes = archiveFields * sizeof(float);
+
+  // Fields of a record in the order they are coded: positions, velocities,
+  // then hv, which is coded relative to the velocity
+  constexpr std::array<int, archiveFields> codingOrder = {0, 1, 2, 6, 7, 8, 3, 4, 5};
+
+  // Values per Rice block, and the quotient above which a value is stored
+  // with its bit width instead
+  constexpr std::size_t riceBlock = 64;
+  constexpr std::uint64_t escapeQuotient = 24;
+
+  // Velocities are quantized to at most this many steps either side of zero
+  constexpr double velocityLimit = 0x1p40;
+
+  template <typename T>
+  void appendValue(std::vector<std::byte> &bytes, T value) {
+    std::array<std::byte, sizeof(T)> raw{};
+    std::memcpy(raw.data(), &value, sizeof(T));
+    bytes.insert(bytes.end(), raw.begin(), raw.end());
+  }
+
+  template <typename T>
+  T readValue(std::span<std::byte const> bytes, std::size_t offset) {
+    if (offset + sizeof(T) > bytes.size()) { throw std::runtime_error("archive is truncated"); }
+    T value{};
+    std::memcpy(&value, bytes.subspan(offset, sizeof(T)).data(), sizeof(T));
+    return value;
+  }
+
+  // Bits appended least significant first
+  class BitWriter {
+  public:
+    explicit BitWriter(std::vector<std::byte> &bytes) : bytes(bytes) { }
+
+    // Append the low count bits of value, count <= 64
+    void put(std::uint64_t value, int count) {
+      while (count > 32) {
+        put(value & 0xFFFFFFFFU, 32);
+        value >>= 32U;
+        count -= 32;
+      }
+      if (count < 64) { value &= (std::uint64_t{1} << static_cast<unsigned>(count)) - 1; }
+      buffer |= value << static_cast<unsigned>(filled);
+      filled += count;
+      while (filled >= 8) {
+        bytes.push_back(static_cast<std::byte>(buffer & 0xFFU));
+        buffer >>= 8U;
+        filled -= 8;
+      }
+    }
+
+    void flush() {
+      if (filled > 0) { bytes.push_back(static_cast<std::byte>(buffer & 0xFFU)); }
+      buffer = 0;
+      filled = 0;
+    }
+
+  private:
+    std::vector<std::byte> &bytes;
+    std::uint64_t buffer{};
+    int filled{};
+  };
+
+  class BitReader {
+  public:
+    explicit BitReader(std::span<std::byte const> bytes) : bytes(bytes) { }
+
+    // Next count bits, count <= 64
+    std::uint64_t get(int count) {
+      std::uint64_t value = 0;
+      int shift = 0;
+      while (count > 32) {
+        value |= get(32) << static_cast<unsigned>(shift);
+        shift += 32;
+        count -= 32;
+      }
+      while (filled < count) {
+        if (next == bytes.size()) { throw std::runtime_error("archive frame is truncated"); }
+        buffer |= static_cast<std::uint64_t>(bytes[next++]) << static_cast<unsigned>(filled);
+        filled += 8;
+      }
+      std::uint64_t const mask = (std::uint64_t{1} << static_cast<unsigned>(count)) - 1;
+      value |= (buffer & mask) << static_cast<unsigned>(shift);
+      buffer >>= static_cast<unsigned>(count);
+      filled -= count;
+      return value;
+    }
+
+  private:
+    std::span<std::byte const> bytes;
+    std::size_t next{};
+    std::uint64_t buffer{};
+    int filled{};
+  };
+
+  std::uint64_t zigzag(std::int64_t value) {
+    return (static_cast<std::uint64_t>(value) << 1U) ^ static_cast<std::uint64_t>(value >> 63);
+  }
+
+  std::int64_t unzigzag(std::uint64_t value) {
+    return static_cast<std::int64_t>(value >> 1U) ^ -static_cast<std::int64_t>(value & 1U);
+  }
+
+  // Rice code values in blocks, each with the parameter that suits its mean
+  void riceEncode(std::span<std::uint64_t const> values, BitWriter &writer) {
+    for (std::size_t begin = 0; begin < values.size(); begin += riceBlock) {
+      auto const block = values.subspan(begin, std::min(riceBlock, values.size() - begin));
+      std::uint64_t sum = 0;
+      for (auto const value : block) { sum += std::min(value, std::uint64_t{1} << 48U); }
+      std::uint64_t const mean = sum / block.size();
+      int const parameter = mean > 0 ? static_cast<int>(std::bit_width(mean)) - 1 : 0;
+      writer.put(static_cast<std::uint64_t>(parameter), 6);
+      for (auto const value : block) {
+        std::uint64_t const quotient = value >> static_cast<unsigned>(parameter);
+        if (quotient < escapeQuotient) {
+          // quotient ones and a zero, then the low bits
+          writer.put((std::uint64_t{1} << quotient) - 1, static_cast<int>(quotient) + 1);
+          writer.put(value, parameter);
+        } else {
+          int const width = static_cast<int>(std::bit_width(value));
+          writer.put((std::uint64_t{1} << escapeQuotient) - 1, static_cast<int>(escapeQuotient));
+          writer.put(static_cast<std::uint64_t>(width), 7);
+          writer.put(value, width);
+        }
+      }
+    }
+  }
+
+  void riceDecode(BitReader &reader, std::span<std::uint64_t> values) {
+    for (std::size_t begin = 0; begin < values.size(); begin += riceBlock) {
+      auto const block = values.subspan(begin, std::min(riceBlock, values.size() - begin));
+      int const parameter = static_cast<int>(reader.get(6));
+      for (auto &value : block) {
+        std::uint64_t quotient = 0;
+        while (quotient < escapeQuotient and reader.get(1) == 1) { quotient++; }
+        if (quotient < escapeQuotient) {
+          value = (quotient << static_cast<unsigned>(parameter)) | reader.get(parameter);
+        } else {
+          value = reader.get(static_cast<int>(reader.get(7)));
+        }
+      }
+    }
+  }
+
+  // Quantization of one field: positions as fractions of the box, the
+  // others as multiples of the velocity step
+  struct Quantizer {
+    std::array<double, 3> lower{};
+    std::array<double, 3> extent{};
+    double maxPosition{};
+    double velocityStep{};
+
+    Quantizer(ArchiveParameters const &parameters, std::array<double, 3> const &lowerBound,
+              std::array<double, 3> const &upperBound)
+        : lower(lowerBound), maxPosition(std::ldexp(1.0, parameters.positionBits) - 1),
+          velocityStep(parameters.velocityStep) {
+      for (std::size_t axis = 0; axis < 3; axis++) {
+        extent[axis] = upperBound[axis] - lowerBound[axis];
+      }
+    }
+
+    [[nodiscard]] std::int64_t quantize(int field, float value) const {
+      if (not std::isfinite(value)) { return 0; }
+      if (field < 3) {
+        auto const axis = static_cast<std::size_t>(field);
+        double const fraction = (value - lower[axis]) / extent[axis];
+        return std::llround(std::clamp(fraction * maxPosition, 0.0, maxPosition));
+      }
+      return std::llround(std::clamp(value / velocityStep, -velocityLimit, velocityLimit));
+    }
+
+    [[nodiscard]] float restore(int field, std::int64_t value) const {
+      if (field < 3) {
+        auto const axis = static_cast<std::size_t>(field);
+        return static_cast<float>(lower[axis] +
+                                  static_cast<double>(value) * extent[axis] / maxPosition);
+      }
+      return static_cast<float>(static_cast<double>(value) * velocityStep);
+    }
+  };
+
+  // Value a field is coded against: the velocity for hv, otherwise the
+  // previous particle of a key frame or the same particle of the previous
+  // frame
+  std::int64_t prediction(int field, std::size_t part, bool key,
+                          std::array<std::vector<std::int64_t>, archiveFields> const &current,
+                          std::array<std::vector<std::int64_t>, archiveFields> const &previous) {
+    auto const fieldIndex = static_cast<std::size_t>(field);
+    if (field >= 3 and field < 6) { return current[fieldIndex + 3][part]; }
+    if (key) { return part > 0 ? current[fieldIndex][part - 1] : 0; }
+    return previous[fieldIndex][part];
+  }
+
+  void checkParameters(ArchiveParameters const &parameters) {
+    bool valid = parameters.positionBits >= 1 and parameters.positionBits <= 31 and
+                 parameters.velocityStep > 0 and parameters.keyInterval >= 1;
+    for (std::size_t axis = 0; axis < 3; axis++) {
+      valid = valid and parameters.boxLowerBound[axis] < parameters.boxUpperBound[axis];
+    }
+    if (not valid) { throw std::invalid_argument("invalid archive parameters"); }
+  }
+}  // namespace
+
+bool parseSnapshotFormat(std::string const &name, SnapshotFormat &format) {
+  if (name == "fld") {
+    format = SnapshotFormat::fld;
+  } else if (name == "fldz") {
+    format = SnapshotFormat::fldz;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+ArchiveWriter::ArchiveWriter(std::string const &filename, ArchiveParameters const &parameters)
+    : parameters(parameters) {
+  checkParameters(parameters);
+  file.exceptions(std::ios::failbit | std::ios::badbit);
+  file.open(filename, std::ios::binary | std::ios::trunc);
+}
+
+ArchiveWriter::~ArchiveWriter() {
+  try {
+    close();
+  } catch (...) {
+    // Errors only reach the caller through close
+  }
+}
+
+void ArchiveWriter::writeBytes(std::span<std::byte const> bytes) {
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  file.write(reinterpret_cast<char const *>(bytes.data()),
+             static_cast<std::streamsize>(bytes.size()));
+  outputBytes += bytes.size();
+}
+
+void ArchiveWriter::append(std::span<std::byte const> frame, int step) {
+  if (frame.size() < fldHeaderBytes or (frame.size() - fldHeaderBytes) % fldRecordBytes != 0) {
+    throw std::runtime_error("frame is not in the .fld layout");
+  }
+  auto const numParts = (frame.size() - fldHeaderBytes) / fldRecordBytes;
+  auto const &lowerBound = parameters.boxLowerBound;
+  auto const &upperBound = parameters.boxUpperBound;
+
+  // The header goes out with the first frame, which fixes ppm and the
+  // number of particles
+  if (numParticles < 0) {
+    ppm = readValue<float>(frame, 0);
+    numParticles = static_cast<std::int32_t>(numParts);
+    encoded.clear();
+    encoded.insert(encoded.end(), magic.begin(), magic.end());
+    appendValue(encoded, version);
+    appendValue(encoded, ppm);
+    appendValue(encoded, numParticles);
+    appendValue(encoded, static_cast<std::int32_t>(parameters.positionBits));
+    appendValue(encoded, static_cast<std::int32_t>(parameters.keyInterval));
+    appendValue(encoded, parameters.velocityStep);
+    for (auto const bound : lowerBound) { appendValue(encoded, bound); }
+    for (auto const bound : upperBound) { appendValue(encoded, bound); }
+    writeBytes(encoded);
+    for (std::size_t field = 0; field < archiveFields; field++) {
+      quantized[field].resize(numParts);
+      previous[field].resize(numParts);
+    }
+  } else if (numParts != static_cast<std::size_t>(numParticles)) {
+    throw std::runtime_error("frame has a different number of particles");
+  }
+
+  Quantizer const quantizer(parameters, lowerBound, upperBound);
+  for (std::size_t part = 0; part < numParts; part++) {
+    std::array<float, archiveFields> record{};
+    std::memcpy(record.data(), frame.subspan(fldHeaderBytes + part * fldRecordBytes).data(),
+                fldRecordBytes);
+    for (std::size_t field = 0; field < archiveFields; field++) {
+      quantized[field][part] = quantizer.quantize(static_cast<int>(field), record[field]);
+    }
+  }
+
+  bool const key = index.size() % static_cast<std::size_t>(parameters.keyInterval) == 0;
+  encoded.clear();
+  encoded.push_back(static_cast<std::byte>(key ? 1 : 0));
+  BitWriter writer(encoded);
+  std::vector<std::uint64_t> residuals(numParts);
+  for (int const field : codingOrder) {
+    auto const &values = quantized[static_cast<std::size_t>(field)];
+    for (std::size_t part = 0; part < numParts; part++) {
+      residuals[part] = zigzag(values[part] - prediction(field, part, key, quantized, previous));
+    }
+    riceEncode(residuals, writer);
+  }
+  writer.flush();
+
+  index.push_back({outputBytes, encoded.size(), step, key ? 1 : 0});
+  writeBytes(encoded);
+  std::swap(quantized, previous);
+  inputBytes += static_cast<std::int64_t>(frame.size());
+}
+
+void ArchiveWriter::close() {
+  if (closed) { return; }
+  closed = true;
+  encoded.clear();
+  std::uint64_t const indexOffset = outputBytes;
+  for (auto const &entry : index) {
+    appendValue(encoded, entry.offset);
+    appendValue(encoded, entry.size);
+    appendValue(encoded, entry.step);
+    appendValue(encoded, entry.key);
+  }
+  appendValue(encoded, indexOffset);
+  appendValue(encoded, static_cast<std::uint32_t>(index.size()));
+  encoded.insert(encoded.end(), magic.begin(), magic.end());
+  writeBytes(encoded);
+  file.close();
+}
+
+std::int64_t ArchiveWriter::get_inputBytes() const { return inputBytes; }
+
+std::int64_t ArchiveWriter::get_outputBytes() const {
+  return static_cast<std::int64_t>(outputBytes);
+}
+
+ArchiveReader::ArchiveReader(std::string const &filename) : file(filename) {
+  std::span<std::byte const> const bytes = file.bytes();
+  auto const hasMagic = [&bytes](std::size_t offset) {
+    return offset + magic.size() <= bytes.size() and
+           std::memcmp(bytes.subspan(offset).data(), magic.data(), magic.size()) == 0;
+  };
+  if (bytes.size() < headerBytes + trailerBytes or not hasMagic(0) or
+      not hasMagic(bytes.size() - magic.size())) {
+    throw std::runtime_error(filename + ": not a complete .fldz archive");
+  }
+  if (readValue<std::uint32_t>(bytes, 4) != version) {
+    throw std::runtime_error(filename + ": unsupported .fldz version");
+  }
+  ppm = readValue<float>(bytes, 8);
+  numParticles = readValue<std::int32_t>(bytes, 12);
+  parameters.positionBits = readValue<std::int32_t>(bytes, 16);
+  parameters.keyInterval = readValue<std::int32_t>(bytes, 20);
+  parameters.velocityStep = readValue<double>(bytes, 24);
+  for (std::size_t axis = 0; axis < 3; axis++) {
+    parameters.boxLowerBound[axis] = readValue<double>(bytes, 32 + axis * 8);
+    parameters.boxUpperBound[axis] = readValue<double>(bytes, 56 + axis * 8);
+  }
+  checkParameters(parameters);
+
+  std::size_t const trailer = bytes.size() - trailerBytes;
+  auto const indexOffset = readValue<std::uint64_t>(bytes, trailer);
+  auto const numFrames = readValue<std::uint32_t>(bytes, trailer + 8);
+  if (indexOffset + std::uint64_t{numFrames} * entryBytes != trailer) {
+    throw std::runtime_error(filename + ": corrupt .fldz index");
+  }
+  index.reserve(numFrames);
+  for (std::size_t frame = 0; frame < numFrames; frame++) {
+    std::size_t const entry = indexOffset + frame * entryBytes;
+    ArchiveFrame const read{readValue<std::uint64_t>(bytes, entry),
+                            readValue<std::uint64_t>(bytes, entry + 8),
+                            readValue<std::int32_t>(bytes, entry + 16),
+                            readValue<std::int32_t>(bytes, entry + 20)};
+    if (read.offset < headerBytes or read.offset + read.size > indexOffset or
+        (frame == 0 and read.key == 0)) {
+      throw std::runtime_error(filename + ": corrupt .fldz index");
+    }
+    index.push_back(read);
+  }
+}
+
+int ArchiveReader::get_numFrames() const { return static_cast<int>(index.size()); }
+
+int ArchiveReader::get_step(int frame) const { return index.at(static_cast<std::size_t>(frame)).step; }
+
+std::size_t ArchiveReader::get_frameBytes(int frame) const {
+  return index.at(static_cast<std::size_t>(frame)).size;
+}
+
+ArchiveParameters const &ArchiveReader::get_parameters() const { return parameters; }
+
+void ArchiveReader::decodeFrame(int frame, std::vector<std::byte> &fld) const {
+  auto const target = static_cast<std::size_t>(frame);
+  if (target >= index.size()) { throw std::out_of_range("no such archive frame"); }
+  std::size_t first = target;
+  while (index[first].key == 0) { first--; }
+
+  std::span<std::byte const> const bytes = file.bytes();
+  Quantizer const quantizer(parameters, parameters.boxLowerBound, parameters.boxUpperBound);
+
+  auto const numParts = static_cast<std::size_t>(numParticles);
+  std::array<std::vector<std::int64_t>, archiveFields> current;
+  std::array<std::vector<std::int64_t>, archiveFields> previous;
+  for (std::size_t field = 0; field < archiveFields; field++) {
+    current[field].resize(numParts);
+    previous[field].resize(numParts);
+  }
+  std::vector<std::uint64_t> residuals(numParts);
+  for (std::size_t decoded = first; decoded <= target; decoded++) {
+    ArchiveFrame const &entry = index[decoded];
+    auto const frameBytes = bytes.subspan(entry.offset, entry.size);
+    bool const key = entry.key != 0;
+    BitReader reader(frameBytes.subspan(1));
+    std::swap(current, previous);
+    for (int const field : codingOrder) {
+      riceDecode(reader, residuals);
+      auto &values = current[static_cast<std::size_t>(field)];
+      for (std::size_t part = 0; part < numParts; part++) {
+        values[part] = unzigzag(residuals[part]) + prediction(field, part, key, current, previous);
+      }
+    }
+  }
+
+  fld.resize(fldHeaderBytes + numParts * fldRecordBytes);
+  std::memcpy(fld.data(), &ppm, sizeof(ppm));
+  std::memcpy(&fld[sizeof(ppm)], &numParticles, sizeof(numParticles));
+  for (std::size_t part = 0; part < numParts; part++) {
+    std::array<float, archiveFields> record{};
+    for (std::size_t field = 0; field < archiveFields; field++) {
+      record[field] = quantizer.restore(static_cast<int>(field), current[field][part]);
+    }
+    std::memcpy(&fld[fldHeaderBytes + part * fldRecordBytes], record.data(), fldRecordBytes);
+  }
+}
@@ -0,0 +1,114 @@
+#ifndef FLUID_SNAPSHOT_ARCHIVE_HPP
+#define FLUID_SNAPSHOT_ARCHIVE_HPP
+
+#include "constants.hpp"
+#include "mapped_file.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+
+// Layout of the frames written by --dump-every: one .fld file per frame, or
+// every frame in one compressed .fldz archive
+enum class SnapshotFormat { fld, fldz };
+
+// Parse "fld" or "fldz"; returns false for anything else
+bool parseSnapshotFormat(std::string const &name, SnapshotFormat &format);
+
+// Quantization of a .fldz archive. Positions are stored as positionBits-bit
+// fractions of the box between the bounds, hv and velocities as multiples
+// of velocityStep.
+// Every keyInterval-th frame is stored on its own, the others as the change
+// from the frame before. The defaults keep positions to 1/150 of the
+// particle spacing of small.fld, enough to render the frames
+struct ArchiveParameters {
+  int positionBits{12};
+  double velocityStep{1e-2};
+  int keyInterval{16};
+  std::array<double, 3> boxLowerBound{Constants::boxLowerBound};
+  std::array<double, 3> boxUpperBound{Constants::boxUpperBound};
+};
+
+// Number of values of a particle record in the .fld layout
+inline constexpr int archiveFields = 9;
+
+// Entry of the index of an archive: where a frame is and whether it is a
+// key frame
+struct ArchiveFrame {
+  std::uint64_t offset;
+  std::uint64_t size;
+  std::int32_t step;
+  std::int32_t key;
+};
+
+// Appends frames in the .fld layout to a .fldz archive. Each frame is
+// quantized, turned into differences (from the previous particle in a key
+// frame, from the previous frame otherwise; hv from the velocity) and
+// Rice coded in blocks of 64 values. close writes the index of the frames
+// at the end of the file, which gives the reader random access
+class ArchiveWriter {
+public:
+  explicit ArchiveWriter(std::string const &filename, ArchiveParameters const &parameters = {});
+  ~ArchiveWriter();
+
+  ArchiveWriter(const ArchiveWriter &) = delete;
+  ArchiveWriter &operator=(const ArchiveWriter &) = delete;
+  ArchiveWriter(ArchiveWriter &&) = delete;
+  ArchiveWriter &operator=(ArchiveWriter &&) = delete;
+
+  // Compress a frame laid out as an .fld file, as encodeOutput makes it.
+  // Throws std::runtime_error if its particle count differs from the first
+  // frame, and std::ios_base::failure if the file cannot be written
+  void append(std::span<std::byte const> frame, int step);
+
+  // Write the index. The destructor closes the archive too, ignoring errors
+  void close();
+
+  // Bytes of the .fld frames appended and of the archive written so far
+  [[nodiscard]] std::int64_t get_inputBytes() const;
+  [[nodiscard]] std::int64_t get_outputBytes() const;
+
+private:
+  void writeBytes(std::span<std::byte const> bytes);
+
+  std::ofstream file;
+  ArchiveParameters parameters;
+  float ppm{};
+  std::int32_t numParticles{-1};
+  bool closed{};
+  std::int64_t inputBytes{};
+  std::uint64_t outputBytes{};
+  std::vector<ArchiveFrame> index;
+  std::array<std::vector<std::int64_t>, archiveFields> quantized;
+  std::array<std::vector<std::int64_t>, archiveFields> previous;
+  std::vector<std::byte> encoded;
+};
+
+// Random access to the frames of a .fldz archive. Throws
+// std::runtime_error if the file is not a complete archive
+class ArchiveReader {
+public:
+  explicit ArchiveReader(std::string const &filename);
+
+  [[nodiscard]] int get_numFrames() const;
+  [[nodiscard]] int get_step(int frame) const;
+  [[nodiscard]] std::size_t get_frameBytes(int frame) const;
+  [[nodiscard]] ArchiveParameters const &get_parameters() const;
+
+  // Decode a frame into the .fld layout, reusing the capacity of fld. Frames
+  // after a key frame are rebuilt from it
+  void decodeFrame(int frame, std::vector<std::byte> &fld) const;
+
+private:
+  MappedFile file;
+  ArchiveParameters parameters;
+  float ppm{};
+  std::int32_t numParticles{};
+  std::vector<ArchiveFrame> index;
+};
+
+#endif  // FLUID_SNAPSHOT_ARCHIVE_HPP
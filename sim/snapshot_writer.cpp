@@ -0,0 +1,46 @@
+#include "snapshot_writer.hpp"
+
+#include "parser.hpp"
+
+#include <filesystem>
+#include <utility>
+
+SnapshotWriter::SnapshotWriter(std::string outputfile, SnapshotFormat format,
+                               ArchiveParameters const &parameters)
+    : outputfile(std::move(outputfile)),
+      archive(format == SnapshotFormat::fldz
+                  ? std::make_unique<ArchiveWriter>(archiveName(this->outputfile), parameters)
+                  : nullptr) { }
+
+void SnapshotWriter::submit(Grid const &grid, int step, ThreadPool &pool) {
+  encodeOutput(grid, writer.acquire(), pool);
+  if (archive) {
+    writer.queue([this, step](std::span<std::byte const> bytes) { archive->append(bytes, step); });
+  } else {
+    writer.queue([name = frameName(outputfile, step)](std::span<std::byte const> bytes) {
+      writeBuffer(name, bytes);
+    });
+  }
+}
+
+void SnapshotWriter::finish() {
+  writer.finish();
+  // The writer thread is idle, so the archive is ours to close
+  if (archive) { archive->close(); }
+}
+
+std::int64_t SnapshotWriter::get_framesWritten() const { return writer.get_written(); }
+
+std::int64_t SnapshotWriter::get_waits() const { return writer.get_waits(); }
+
+std::string SnapshotWriter::frameName(std::string const &outputfile, int step) {
+  std::filesystem::path const path(outputfile);
+  std::string const name =
+      path.stem().string() + "-" + std::to_string(step) + path.extension().string();
+  return (path.parent_path() / name).string();
+}
+
+std::string SnapshotWriter::archiveName(std::string const &outputfile) {
+  std::filesystem::path const path(outputfile);
+  return (path.parent_path() / (path.stem().string() + ".fldz")).string();
+}
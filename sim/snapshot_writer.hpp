@@ -0,0 +1,48 @@
+#ifndef FLUID_SNAPSHOT_WRITER_HPP
+#define FLUID_SNAPSHOT_WRITER_HPP
+
+#include "async_writer.hpp"
+#include "grid.hpp"
+#include "snapshot_archive.hpp"
+#include "thread_pool.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Writes frames of a running simulation on a background thread, as .fld
+// files or appended to a .fldz archive. Each submit encodes the state into
+// a buffer of an AsyncWriter, whose thread writes (or compresses) it while
+// the solver keeps stepping; a slow disk slows the solver down through the
+// writer's back-pressure
+class SnapshotWriter {
+public:
+  // Frames are named after outputfile, see frameName and archiveName
+  explicit SnapshotWriter(std::string outputfile, SnapshotFormat format = SnapshotFormat::fld,
+                          ArchiveParameters const &parameters = {});
+
+  // Queue the current state of grid as the frame of step
+  void submit(Grid const &grid, int step, ThreadPool &pool = ThreadPool::serial());
+
+  // Wait until every queued frame is written and close the archive; no
+  // frames can be submitted after. Throws the first write error
+  void finish();
+
+  // Frames written so far, and submits that had to wait for a free buffer
+  [[nodiscard]] std::int64_t get_framesWritten() const;
+  [[nodiscard]] std::int64_t get_waits() const;
+
+  // Name of the frame of a step: "<stem>-<step><extension>" next to outputfile
+  [[nodiscard]] static std::string frameName(std::string const &outputfile, int step);
+
+  // Name of the archive: "<stem>.fldz" next to outputfile
+  [[nodiscard]] static std::string archiveName(std::string const &outputfile);
+
+private:
+  std::string outputfile;
+  std::unique_ptr<ArchiveWriter> archive;
+  // Declared last so its thread stops before the archive goes away
+  AsyncWriter writer;
+};
+
+#endif  // FLUID_SNAPSHOT_WRITER_HPP
@@ -0,0 +1,108 @@
+#include "stage_tracer.hpp"
+
+#include "parser.hpp"
+#include "trace_file.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <utility>
+
+namespace {
+  constexpr std::size_t particleBytes = sizeof(std::int64_t) + traceFields * sizeof(double);
+
+  bool parseStep(std::string_view text, int &step) {
+    auto const [end, error] = std::from_chars(text.data(), text.data() + text.size(), step);
+    return error == std::errc{} and end == text.data() + text.size();
+  }
+}  // namespace
+
+bool parseTraceStage(std::string const &name, TraceStage &stage) {
+  for (std::size_t index = 0; index < traceStages.size(); index++) {
+    if (traceStages[index] == name) {
+      stage = static_cast<TraceStage>(index);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool parseStepRange(std::string const &range, int &first, int &last) {
+  std::string_view const text(range);
+  auto const dots = text.find("..");
+  bool const parsed = dots == std::string_view::npos
+                          ? parseStep(text, first) and parseStep(text, last)
+                          : parseStep(text.substr(0, dots), first) and
+                                parseStep(text.substr(dots + 2), last);
+  return parsed and first >= 1 and last >= first;
+}
+
+void encodeTrace(Grid const &grid, std::vector<std::byte> &buffer, ThreadPool &pool,
+                 bool accumulated) {
+  ParticleStore const &store = grid.get_particles();
+  std::vector<Block> const &blocks = grid.get_blocks();
+  auto const numBlocks = static_cast<std::int32_t>(blocks.size());
+
+  // Offset of every block's count, so the blocks can be filled in parallel
+  std::vector<std::size_t> blockOffset(blocks.size() + 1);
+  blockOffset[0] = sizeof(numBlocks);
+  for (std::size_t block = 0; block < blocks.size(); block++) {
+    auto const count = static_cast<std::size_t>(blocks[block].get_end() - blocks[block].get_begin());
+    blockOffset[block + 1] = blockOffset[block] + sizeof(std::int64_t) + count * particleBytes;
+  }
+  buffer.resize(blockOffset.back());
+  std::memcpy(buffer.data(), &numBlocks, sizeof(numBlocks));
+
+  auto const &external = grid.get_config().externalAcceleration;
+  pool.parallelFor(numBlocks, [&store, &blocks, &blockOffset, &buffer, &external,
+                               accumulated](int begin, int end) {
+    for (auto block = static_cast<std::size_t>(begin); block < static_cast<std::size_t>(end);
+         block++) {
+      Block const &blockObj = blocks[block];
+      std::size_t offset = blockOffset[block];
+      auto const count = static_cast<std::int64_t>(blockObj.get_end() - blockObj.get_begin());
+      std::memcpy(&buffer[offset], &count, sizeof(count));
+      offset += sizeof(count);
+      for (auto part = static_cast<std::size_t>(blockObj.get_begin());
+           part < static_cast<std::size_t>(blockObj.get_end()); part++) {
+        auto const id = static_cast<std::int64_t>(store.id[part]);
+        std::array<double, traceFields> fields{
+            store.px[part],  store.py[part],  store.pz[part],      store.hvx[part],
+            store.hvy[part], store.hvz[part], store.vx[part],      store.vy[part],
+            store.vz[part],  store.density[part], store.ax[part], store.ay[part],
+            store.az[part]};
+        if (not accumulated) {
+          fields[9] = 0.0;
+          std::copy(external.begin(), external.end(), fields.begin() + 10);
+        }
+        std::memcpy(&buffer[offset], &id, sizeof(id));
+        std::memcpy(&buffer[offset + sizeof(id)], fields.data(), sizeof(fields));
+        offset += particleBytes;
+      }
+    }
+  });
+}
+
+StageTracer::StageTracer(std::string directory, std::optional<TraceStage> stage, int firstStep,
+                         int lastStep)
+    : directory(std::move(directory)), stage(stage), firstStep(firstStep), lastStep(lastStep) { }
+
+void StageTracer::set_step(int current) { step = current; }
+
+void StageTracer::capture(TraceStage captured, Grid const &grid, ThreadPool &pool) {
+  if (step < firstStep or step > lastStep or (stage and *stage != captured)) { return; }
+  // Repositioning comes before the densities and accelerations of the step
+  // are reset, so the values left from the last step are not traced
+  encodeTrace(grid, writer.acquire(), pool, captured != TraceStage::repos);
+  auto const name = traceStages.at(static_cast<std::size_t>(captured));
+  std::string filename = (std::filesystem::path(directory) / traceName(name, step)).string();
+  writer.queue([filename = std::move(filename)](std::span<std::byte const> bytes) {
+    writeBuffer(filename, bytes);
+  });
+}
+
+void StageTracer::finish() { writer.finish(); }
+
+std::int64_t StageTracer::get_tracesWritten() const { return writer.get_written(); }
@@ -0,0 +1,71 @@
+#ifndef FLUID_STAGE_TRACER_HPP
+#define FLUID_STAGE_TRACER_HPP
+
+#include "async_writer.hpp"
+#include "grid.hpp"
+#include "thread_pool.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Stages of a time step that can be traced, in the order of traceStages
+enum class TraceStage { repos, initacc, densinc, denstransf, acctransf, partcol, motion, boundint };
+
+// Parse a stage name of traceStages; returns false for anything else
+bool parseTraceStage(std::string const &name, TraceStage &stage);
+
+// Parse "a..b" or "a" into the steps [first, last]; returns false unless
+// 1 <= first <= last
+bool parseStepRange(std::string const &range, int &first, int &last);
+
+// Encode the particles of grid as a .trz trace: blocks by linear index,
+// each with its particles in store order. Reuses the capacity of buffer.
+// Without accumulated the densities and accelerations are written as a step
+// starts them, 0 and the external acceleration, as the reference does
+// before they are computed
+void encodeTrace(Grid const &grid, std::vector<std::byte> &buffer,
+                 ThreadPool &pool = ThreadPool::serial(), bool accumulated = true);
+
+// Captures the state after one stage, or after every stage, of a range of
+// steps into <stage>-base-<step>.trz files of a directory. The traces are
+// written by an AsyncWriter thread, so only their encoding is on the
+// solver's time
+class StageTracer {
+public:
+  // Without a stage every stage is traced
+  StageTracer(std::string directory, std::optional<TraceStage> stage, int firstStep,
+              int lastStep);
+
+  // Step the next captures belong to
+  void set_step(int step);
+
+  // Capture grid after stage if it is traced at the current step
+  void capture(TraceStage stage, Grid const &grid, ThreadPool &pool);
+
+  // Wait until every trace is written. Throws the first write error
+  void finish();
+
+  [[nodiscard]] std::int64_t get_tracesWritten() const;
+
+private:
+  std::string directory;
+  std::optional<TraceStage> stage;
+  int firstStep;
+  int lastStep;
+  int step{};
+  AsyncWriter writer;
+};
+
+// Hook between the stages of simulateOneStep. Builds without FLUID_TRACE
+// compile it to nothing; otherwise it is one test of tracer
+inline void traceStage([[maybe_unused]] StageTracer *tracer, [[maybe_unused]] TraceStage stage,
+                       [[maybe_unused]] Grid const &grid, [[maybe_unused]] ThreadPool &pool) {
+#ifdef FLUID_TRACE
+  if (tracer != nullptr) { tracer->capture(stage, grid, pool); }
+#endif
+}
+
+#endif  // FLUID_STAGE_TRACER_HPP
@@ -0,0 +1,216 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <latch>
+
+#include <unistd.h>
+
+namespace {
+  // Chunks dealt to every worker; more chunks balance better but cost more
+  // scheduling
+  constexpr int chunksPerThread = 8;
+
+  constexpr int halfWordBits = 32;
+  constexpr std::uint64_t halfWordMask = 0xFFFF'FFFFULL;
+
+  std::uint64_t packChunks(int head, int tail) {
+    return (static_cast<std::uint64_t>(tail) << halfWordBits) | static_cast<std::uint64_t>(head);
+  }
+
+  int chunkHead(std::uint64_t chunks) { return static_cast<int>(chunks & halfWordMask); }
+
+  int chunkTail(std::uint64_t chunks) { return static_cast<int>(chunks >> halfWordBits); }
+
+  double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+}  // namespace
+
+ThreadPool::ThreadPool(int numThreads)
+    : workers(std::make_unique<Worker[]>(static_cast<std::size_t>(std::max(numThreads, 1)))) {
+  int const numWorkers = std::max(numThreads, 1) - 1;
+  threads.reserve(static_cast<std::size_t>(numWorkers));
+  threadIds.assign(static_cast<std::size_t>(numWorkers) + 1, static_cast<int>(gettid()));
+  // Every worker reports its id before the pool is used
+  std::latch started(numWorkers);
+  for (int worker = 1; worker <= numWorkers; worker++) {
+    threads.emplace_back([this, worker, &started] {
+      threadIds[static_cast<std::size_t>(worker)] = static_cast<int>(gettid());
+      started.count_down();
+      workerLoop(worker);
+    });
+  }
+  started.wait();
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard const lock(mutex);
+    stopping = true;
+  }
+  start.notify_all();
+  for (auto & thread : threads) { thread.join(); }
+}
+
+int ThreadPool::size() const { return static_cast<int>(threads.size()) + 1; }
+
+ThreadPool & ThreadPool::serial() {
+  static ThreadPool pool(1);
+  return pool;
+}
+
+std::vector<int> const & ThreadPool::get_threadIds() const { return threadIds; }
+
+std::vector<WorkerStats> ThreadPool::get_stats() const {
+  std::vector<WorkerStats> stats;
+  for (int worker = 0; worker < size(); worker++) {
+    stats.push_back(workers[static_cast<std::size_t>(worker)].stats);
+  }
+  return stats;
+}
+
+void ThreadPool::resetStats() {
+  for (int worker = 0; worker < size(); worker++) {
+    workers[static_cast<std::size_t>(worker)].stats = {};
+  }
+}
+
+void ThreadPool::parallelFor(int count, Task task) {
+  if (threads.empty() or count <= 1) {
+    if (count > 0) {
+      task(0, count);
+      workers[0].stats.tasksRun++;
+    }
+    return;
+  }
+  parallelFor(count, task, Weight{});
+}
+
+void ThreadPool::parallelFor(int count, Task task, Weight weight) {
+  if (threads.empty() or count <= 1) {
+    parallelFor(count, task);
+    return;
+  }
+  auto const callStart = std::chrono::steady_clock::now();
+  {
+    std::lock_guard const lock(mutex);
+    splitChunks(count, weight);
+    current = task;
+    pending = static_cast<int>(threads.size());
+    generation++;
+  }
+  start.notify_all();
+  runChunks(0);
+
+  std::unique_lock lock(mutex);
+  done.wait(lock, [this] { return pending == 0; });
+  current = {};
+
+  // Whatever time a worker did not spend on chunks was spent waking up,
+  // looking for chunks to steal or waiting for the others
+  double const elapsed = secondsSince(callStart);
+  for (int worker = 0; worker < size(); worker++) {
+    Worker & state = workers[static_cast<std::size_t>(worker)];
+    state.stats.idleSeconds += std::max(elapsed - state.busySeconds, 0.0);
+  }
+}
+
+// Cut [0, count) into chunks of about the same weight and deal them out to
+// the workers in contiguous runs
+void ThreadPool::splitChunks(int count, Weight weight) {
+  auto const weightOf = [weight](int index) { return weight ? weight(index) : 1; };
+  std::int64_t total = 0;
+  for (int index = 0; index < count; index++) { total += weightOf(index); }
+  std::int64_t const target =
+      std::max<std::int64_t>(total / (static_cast<std::int64_t>(size()) * chunksPerThread), 1);
+
+  chunkStart.clear();
+  chunkStart.push_back(0);
+  std::int64_t chunkWeight = 0;
+  for (int index = 0; index < count; index++) {
+    chunkWeight += weightOf(index);
+    if (chunkWeight >= target and index + 1 < count) {
+      chunkStart.push_back(index + 1);
+      chunkWeight = 0;
+    }
+  }
+  chunkStart.push_back(count);
+
+  int const numChunks = static_cast<int>(chunkStart.size()) - 1;
+  for (int worker = 0; worker < size(); worker++) {
+    Worker & state = workers[static_cast<std::size_t>(worker)];
+    state.chunks.store(packChunks(worker * numChunks / size(), (worker + 1) * numChunks / size()));
+    state.busySeconds = 0.0;
+  }
+}
+
+// Wait for the next parallelFor, run chunks until there are none left and
+// report back
+void ThreadPool::workerLoop(int worker) {
+  std::uint64_t seen = 0;
+  while (true) {
+    {
+      std::unique_lock lock(mutex);
+      start.wait(lock, [this, seen] { return stopping or generation != seen; });
+      if (stopping) { return; }
+      seen = generation;
+    }
+    runChunks(worker);
+    {
+      std::lock_guard const lock(mutex);
+      pending--;
+      if (pending == 0) { done.notify_one(); }
+    }
+  }
+}
+
+// Run the worker's own chunks from the head, then steal from the others
+void ThreadPool::runChunks(int worker) {
+  Worker & state = workers[static_cast<std::size_t>(worker)];
+  double busy = 0.0;
+  while (true) {
+    bool stolen = false;
+    int chunk = takeChunk(worker);
+    if (chunk < 0) {
+      chunk = stealChunk(worker);
+      stolen = true;
+    }
+    if (chunk < 0) { break; }
+
+    auto const chunkBegin = std::chrono::steady_clock::now();
+    auto const idx = static_cast<std::size_t>(chunk);
+    current(chunkStart[idx], chunkStart[idx + 1]);
+    busy += secondsSince(chunkBegin);
+    state.stats.tasksRun++;
+    if (stolen) { state.stats.tasksStolen++; }
+  }
+  state.busySeconds = busy;
+}
+
+// Next chunk from the head of the worker's own run, or -1 if it is empty
+int ThreadPool::takeChunk(int worker) {
+  std::atomic<std::uint64_t> & chunks = workers[static_cast<std::size_t>(worker)].chunks;
+  std::uint64_t range = chunks.load();
+  while (chunkHead(range) < chunkTail(range)) {
+    if (chunks.compare_exchange_weak(range, packChunks(chunkHead(range) + 1, chunkTail(range)))) {
+      return chunkHead(range);
+    }
+  }
+  return -1;
+}
+
+// Last chunk of the first other worker with any left, or -1 if all are empty
+int ThreadPool::stealChunk(int worker) {
+  for (int offset = 1; offset < size(); offset++) {
+    auto const victim = static_cast<std::size_t>((worker + offset) % size());
+    std::atomic<std::uint64_t> & chunks = workers[victim].chunks;
+    std::uint64_t range = chunks.load();
+    while (chunkHead(range) < chunkTail(range)) {
+      if (chunks.compare_exchange_weak(range, packChunks(chunkHead(range), chunkTail(range) - 1))) {
+        return chunkTail(range) - 1;
+      }
+    }
+  }
+  return -1;
+}
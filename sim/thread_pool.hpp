@@ -0,0 +1,95 @@
+#ifndef FLUID_THREAD_POOL_HPP
+#define FLUID_THREAD_POOL_HPP
+
+#include <atomic>
+#include "function_ref.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// What one worker did since the last resetStats
+struct WorkerStats {
+  std::int64_t tasksRun{};
+  std::int64_t tasksStolen{};
+  double idleSeconds{};
+};
+
+// Work-stealing pool of worker threads that run the stages of a step. Every
+// parallelFor cuts its range into chunks of about the same weight and deals
+// them out in contiguous runs, one per worker; a worker that runs out of
+// chunks steals from the end of another worker's run. The thread that calls
+// parallelFor works as worker 0, so a pool of one thread runs everything
+// inline
+class ThreadPool {
+public:
+  // Task over the indices [begin, end). Tasks and weights are references,
+  // so handing the pool a lambda never allocates
+  using Task = FunctionRef<void(int begin, int end)>;
+
+  // Relative cost of one index
+  using Weight = FunctionRef<int(int index)>;
+
+  explicit ThreadPool(int threads);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+  ThreadPool(ThreadPool &&) = delete;
+  ThreadPool &operator=(ThreadPool &&) = delete;
+
+  // Number of threads, including the calling one
+  [[nodiscard]] int size() const;
+
+  // Run task over chunks that cover [0, count) and wait for all of them: a
+  // barrier between stages. Without a weight every index costs the same
+  void parallelFor(int count, Task task);
+  void parallelFor(int count, Task task, Weight weight);
+
+  // Operating system ids of the threads, worker 0 (the thread that created
+  // the pool) first
+  [[nodiscard]] std::vector<int> const &get_threadIds() const;
+
+  // Statistics of every worker, worker 0 first
+  [[nodiscard]] std::vector<WorkerStats> get_stats() const;
+  void resetStats();
+
+  // Pool of one thread, used when no pool is given
+  static ThreadPool &serial();
+
+private:
+  // Chunks [head, tail) still to run by a worker, packed in one word so the
+  // owner (taking the head) and thieves (taking the tail) agree on each
+  // chunk with a single compare and swap
+  struct alignas(64) Worker {
+    std::atomic<std::uint64_t> chunks{};
+    double busySeconds{};
+    WorkerStats stats;
+  };
+
+  void workerLoop(int worker);
+  void runChunks(int worker);
+  [[nodiscard]] int takeChunk(int worker);
+  [[nodiscard]] int stealChunk(int worker);
+  void splitChunks(int count, Weight weight);
+
+  std::vector<std::thread> threads;
+  std::vector<int> threadIds;
+  std::unique_ptr<Worker[]> workers;
+  std::mutex mutex;
+  std::condition_variable start;
+  std::condition_variable done;
+  std::uint64_t generation{};
+  bool stopping{};
+  int pending{};
+
+  // Work of the current parallelFor: chunk c covers the indices
+  // [chunkStart[c], chunkStart[c + 1])
+  Task current;
+  std::vector<int> chunkStart;
+};
+
+#endif  // FLUID_THREAD_POOL_HPP
@@ -0,0 +1,140 @@
+#include "trace_file.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+  constexpr std::size_t particleBytes = sizeof(std::int64_t) + traceFields * sizeof(double);
+
+  template <typename T>
+  T readValue(std::span<std::byte const> bytes, std::size_t offset) {
+    if (offset + sizeof(T) > bytes.size()) { throw std::runtime_error("trace is truncated"); }
+    T value{};
+    std::memcpy(&value, bytes.subspan(offset, sizeof(T)).data(), sizeof(T));
+    return value;
+  }
+
+  // Doubles mapped to integers in the same order, so that neighbouring
+  // doubles are neighbouring integers
+  std::int64_t orderedBits(double value) {
+    auto const bits = std::bit_cast<std::int64_t>(value);
+    return bits < 0 ? std::numeric_limits<std::int64_t>::min() - bits : bits;
+  }
+
+  bool withinTolerance(double expected, double actual, TraceTolerance const &tolerance) {
+    if (std::isnan(expected) or std::isnan(actual)) {
+      return std::isnan(expected) and std::isnan(actual);
+    }
+    return std::abs(expected - actual) <= tolerance.absolute or
+           ulpDistance(expected, actual) <= tolerance.ulps;
+  }
+
+  // Indices of the particles of a block sorted by id
+  std::vector<std::int64_t> sortedById(TraceFile const &trace, int block,
+                                       std::vector<TraceParticle> &particles) {
+    auto const count = trace.get_numParticles(block);
+    particles.clear();
+    for (std::int64_t index = 0; index < count; index++) {
+      particles.push_back(trace.particle(block, index));
+    }
+    std::vector<std::int64_t> order(particles.size());
+    for (std::size_t index = 0; index < order.size(); index++) {
+      order[index] = static_cast<std::int64_t>(index);
+    }
+    std::sort(order.begin(), order.end(), [&particles](std::int64_t lhs, std::int64_t rhs) {
+      return particles[static_cast<std::size_t>(lhs)].id <
+             particles[static_cast<std::size_t>(rhs)].id;
+    });
+    return order;
+  }
+}  // namespace
+
+TraceFile::TraceFile(std::string const &filename) : file(filename) {
+  std::span<std::byte const> const bytes = file.bytes();
+  auto const numBlocks = readValue<std::int32_t>(bytes, 0);
+  if (numBlocks < 0) { throw std::runtime_error(filename + ": not a trace"); }
+  blockStart.reserve(static_cast<std::size_t>(numBlocks));
+  blockSize.reserve(static_cast<std::size_t>(numBlocks));
+  std::size_t offset = sizeof(std::int32_t);
+  for (std::int32_t block = 0; block < numBlocks; block++) {
+    auto const count = readValue<std::int64_t>(bytes, offset);
+    offset += sizeof(std::int64_t);
+    auto const blockBytes = static_cast<std::size_t>(count) * particleBytes;
+    if (count < 0 or offset + blockBytes > bytes.size()) {
+      throw std::runtime_error(filename + ": trace is truncated");
+    }
+    blockStart.push_back(offset);
+    blockSize.push_back(count);
+    offset += blockBytes;
+  }
+}
+
+int TraceFile::get_numBlocks() const { return static_cast<int>(blockStart.size()); }
+
+std::int64_t TraceFile::get_numParticles(int block) const {
+  return blockSize[static_cast<std::size_t>(block)];
+}
+
+TraceParticle TraceFile::particle(int block, std::int64_t index) const {
+  std::size_t const offset = blockStart[static_cast<std::size_t>(block)] +
+                             static_cast<std::size_t>(index) * particleBytes;
+  TraceParticle particle{};
+  std::span<std::byte const> const record = file.bytes().subspan(offset, particleBytes);
+  std::memcpy(&particle.id, record.data(), sizeof(particle.id));
+  std::memcpy(particle.fields.data(), record.subspan(sizeof(particle.id)).data(),
+              sizeof(particle.fields));
+  return particle;
+}
+
+std::int64_t ulpDistance(double lhs, double rhs) {
+  std::int64_t const left = orderedBits(lhs);
+  std::int64_t const right = orderedBits(rhs);
+  auto const distance = static_cast<std::uint64_t>(std::max(left, right)) -
+                       static_cast<std::uint64_t>(std::min(left, right));
+  auto const limit = static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max());
+  return static_cast<std::int64_t>(std::min(distance, limit));
+}
+
+std::optional<TraceMismatch> compareTraces(TraceFile const &expected, TraceFile const &actual,
+                                           TraceTolerance const &tolerance) {
+  if (expected.get_numBlocks() != actual.get_numBlocks()) {
+    return TraceMismatch{TraceMismatch::Kind::numBlocks, -1, -1, -1,
+                         static_cast<double>(expected.get_numBlocks()),
+                         static_cast<double>(actual.get_numBlocks())};
+  }
+  std::vector<TraceParticle> expectedParticles;
+  std::vector<TraceParticle> actualParticles;
+  for (int block = 0; block < expected.get_numBlocks(); block++) {
+    if (expected.get_numParticles(block) != actual.get_numParticles(block)) {
+      return TraceMismatch{TraceMismatch::Kind::blockSize, block, -1, -1,
+                           static_cast<double>(expected.get_numParticles(block)),
+                           static_cast<double>(actual.get_numParticles(block))};
+    }
+    auto const expectedOrder = sortedById(expected, block, expectedParticles);
+    auto const actualOrder = sortedById(actual, block, actualParticles);
+    for (std::size_t index = 0; index < expectedOrder.size(); index++) {
+      auto const &want = expectedParticles[static_cast<std::size_t>(expectedOrder[index])];
+      auto const &have = actualParticles[static_cast<std::size_t>(actualOrder[index])];
+      if (want.id != have.id) {
+        // A particle of the reference is missing from this block
+        return TraceMismatch{TraceMismatch::Kind::missingParticle, block, want.id, -1,
+                             static_cast<double>(want.id), static_cast<double>(have.id)};
+      }
+      for (std::size_t field = 0; field < traceFields; field++) {
+        if (not withinTolerance(want.fields[field], have.fields[field], tolerance)) {
+          return TraceMismatch{TraceMismatch::Kind::field, block, want.id,
+                               static_cast<int>(field), want.fields[field], have.fields[field]};
+        }
+      }
+    }
+  }
+  return std::nullopt;
+}
+
+std::string traceName(std::string_view stage, int step) {
+  return std::string(stage) + "-base-" + std::to_string(step) + ".trz";
+}
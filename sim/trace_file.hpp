@@ -0,0 +1,82 @@
+#ifndef FLUID_TRACE_FILE_HPP
+#define FLUID_TRACE_FILE_HPP
+
+#include "mapped_file.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Fields of a particle in a .trz trace, in file order
+inline constexpr int traceFields = 13;
+inline constexpr std::array<std::string_view, traceFields> traceFieldNames = {
+    "px", "py", "pz", "hvx", "hvy", "hvz", "vx", "vy", "vz", "density", "ax", "ay", "az"};
+
+// Stages of a time step that have traces, in the order they run
+inline constexpr std::array<std::string_view, 8> traceStages = {
+    "repos", "initacc", "densinc", "denstransf", "acctransf", "partcol", "motion", "boundint"};
+
+// One particle of a trace
+struct TraceParticle {
+  std::int64_t id;
+  std::array<double, traceFields> fields;
+};
+
+// A .trz trace mapped into memory: the number of blocks, then for every
+// block its number of particles and, for each, the id and the thirteen
+// fields. Throws std::runtime_error if the file is truncated
+class TraceFile {
+public:
+  explicit TraceFile(std::string const &filename);
+
+  [[nodiscard]] int get_numBlocks() const;
+  [[nodiscard]] std::int64_t get_numParticles(int block) const;
+  [[nodiscard]] TraceParticle particle(int block, std::int64_t index) const;
+
+private:
+  MappedFile file;
+  // Offset of the first particle of every block
+  std::vector<std::size_t> blockStart;
+  std::vector<std::int64_t> blockSize;
+};
+
+// A value matches when it is within absolute or within ulps units in the
+// last place of the reference value
+struct TraceTolerance {
+  double absolute{};
+  std::int64_t ulps{};
+};
+
+// First difference between two traces: the number of blocks, the number
+// of particles of a block, a particle of the reference missing from its
+// block, or a field of a particle out of tolerance. Fields that do not
+// apply to the kind are -1, and expected and actual hold the counts or
+// ids that differ
+struct TraceMismatch {
+  enum class Kind { numBlocks, blockSize, missingParticle, field };
+  Kind kind;
+  int block;
+  std::int64_t id;
+  int field;
+  double expected;
+  double actual;
+};
+
+// Distance between two doubles in units in the last place, saturated
+[[nodiscard]] std::int64_t ulpDistance(double lhs, double rhs);
+
+// Compare actual with the reference expected block by block and, inside a
+// block, particle by particle matched by id. Returns the first mismatch
+[[nodiscard]] std::optional<TraceMismatch>
+    compareTraces(TraceFile const &expected, TraceFile const &actual,
+                  TraceTolerance const &tolerance);
+
+// Name of the trace of a stage after a step: "<stage>-base-<step>.trz"
+[[nodiscard]] std::string traceName(std::string_view stage, int step);
+
+#endif  // FLUID_TRACE_FILE_HPP
@@ -0,0 +1,46 @@
+#include "../sim/parser.hpp"
+#include "../sim/snapshot_archive.hpp"
+
+#include <charconv>
+#include <iostream>
+#include <span>
+#include <string>
+
+// List the frames of a .fldz archive, or convert one of them back to .fld:
+//   fldz <archive.fldz>
+//   fldz <archive.fldz> <frame> <output.fld>
+int main(int argc, char **argv) {
+  std::span const args(argv, static_cast<std::size_t>(argc));
+  if (args.size() != 2 and args.size() != 4) {
+    std::cerr << "Usage: " << args[0] << " <archive.fldz> [<frame> <output.fld>]\n";
+    return -1;
+  }
+  try {
+    ArchiveReader const archive(args[1]);
+    if (args.size() == 2) {
+      std::cout << "frame step bytes\n";
+      for (int frame = 0; frame < archive.get_numFrames(); frame++) {
+        std::cout << frame << ' ' << archive.get_step(frame) << ' '
+                  << archive.get_frameBytes(frame) << '\n';
+      }
+      return 0;
+    }
+
+    std::string const frameArg = args[2];
+    int frame = -1;
+    auto const [end, error] =
+        std::from_chars(frameArg.data(), frameArg.data() + frameArg.size(), frame);
+    if (error != std::errc{} or end != frameArg.data() + frameArg.size() or frame < 0 or
+        frame >= archive.get_numFrames()) {
+      std::cerr << "Error: Invalid frame: " << frameArg << '\n';
+      return -1;
+    }
+    std::vector<std::byte> fld;
+    archive.decodeFrame(frame, fld);
+    writeBuffer(args[3], fld);
+  } catch (std::exception const &error) {
+    std::cerr << "Error: " << error.what() << '\n';
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,130 @@
+#include "../sim/trace_file.hpp"
+
+#include <charconv>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace {
+  void printMismatch(TraceMismatch const &mismatch) {
+    switch (mismatch.kind) {
+      case TraceMismatch::Kind::numBlocks:
+        std::cout << "number of blocks: expected " << mismatch.expected << ", actual "
+                  << mismatch.actual << '\n';
+        break;
+      case TraceMismatch::Kind::blockSize:
+        std::cout << "block " << mismatch.block << ": expected " << mismatch.expected
+                  << " particles, actual " << mismatch.actual << '\n';
+        break;
+      case TraceMismatch::Kind::missingParticle:
+        std::cout << "block " << mismatch.block << ": particle " << mismatch.id
+                  << " is missing\n";
+        break;
+      case TraceMismatch::Kind::field:
+        std::cout.precision(17);
+        std::cout << "block " << mismatch.block << ", particle " << mismatch.id << ", "
+                  << traceFieldNames.at(static_cast<std::size_t>(mismatch.field))
+                  << ": expected " << mismatch.expected << ", actual " << mismatch.actual
+                  << " (difference " << std::abs(mismatch.expected - mismatch.actual) << ", "
+                  << ulpDistance(mismatch.expected, mismatch.actual) << " ulps)\n";
+        break;
+    }
+  }
+
+  // Compare one pair of traces; true if they match
+  bool compareFiles(std::string const &expected, std::string const &actual,
+                    TraceTolerance const &tolerance) {
+    TraceFile const reference(expected);
+    TraceFile const candidate(actual);
+    auto const mismatch = compareTraces(reference, candidate, tolerance);
+    if (mismatch) {
+      std::cout << actual << ": ";
+      printMismatch(*mismatch);
+    }
+    return not mismatch;
+  }
+
+  // Compare every stage of every step that has a reference trace, in the
+  // order they run, and stop at the first divergent one
+  int compareDirectories(std::filesystem::path const &expected,
+                         std::filesystem::path const &actual, TraceTolerance const &tolerance) {
+    int compared = 0;
+    for (int step = 1;; step++) {
+      bool found = false;
+      for (auto const stage : traceStages) {
+        auto const reference = expected / traceName(stage, step);
+        auto const candidate = actual / traceName(stage, step);
+        if (not std::filesystem::exists(reference)) { continue; }
+        found = true;
+        if (not std::filesystem::exists(candidate)) { continue; }
+        compared++;
+        if (not compareFiles(reference.string(), candidate.string(), tolerance)) {
+          std::cout << "First divergent stage: " << stage << " of step " << step << '\n';
+          return 1;
+        }
+      }
+      if (not found) { break; }
+    }
+    std::cout << compared << " traces match\n";
+    return compared > 0 ? 0 : 1;
+  }
+
+  bool parseTolerance(std::string const &name, std::string const &value,
+                      TraceTolerance &tolerance) {
+    char const *const last = value.data() + value.size();
+    if (name == "--abs") {
+      auto const [end, error] = std::from_chars(value.data(), last, tolerance.absolute);
+      return error == std::errc{} and end == last and tolerance.absolute >= 0;
+    }
+    if (name == "--ulps") {
+      auto const [end, error] = std::from_chars(value.data(), last, tolerance.ulps);
+      return error == std::errc{} and end == last and tolerance.ulps >= 0;
+    }
+    return false;
+  }
+}  // namespace
+
+// Compare .trz traces of our run with the reference ones:
+//   trzdiff [--abs X] [--ulps N] <reference.trz> <actual.trz>
+//   trzdiff [--abs X] [--ulps N] <reference directory> <actual directory>
+// Exits with 0 when everything matches and 1 at the first divergence
+int main(int argc, char **argv) {
+  std::span const args(argv, static_cast<std::size_t>(argc));
+  TraceTolerance tolerance;
+  std::vector<std::string> paths;
+  for (std::size_t arg = 1; arg < args.size(); arg++) {
+    std::string name = args[arg];
+    if (not name.starts_with("--")) {
+      paths.push_back(name);
+      continue;
+    }
+    std::string value;
+    if (auto const equals = name.find('='); equals != std::string::npos) {
+      value = name.substr(equals + 1);
+      name = name.substr(0, equals);
+    } else if (arg + 1 < args.size()) {
+      value = args[++arg];
+    }
+    if (not parseTolerance(name, value, tolerance)) {
+      std::cerr << "Error: Invalid option: " << name << ' ' << value << '\n';
+      return -1;
+    }
+  }
+  if (paths.size() != 2) {
+    std::cerr << "Usage: " << args[0] << " [--abs X] [--ulps N] <reference> <actual>\n";
+    return -1;
+  }
+
+  try {
+    if (std::filesystem::is_directory(paths[0])) {
+      return compareDirectories(paths[0], paths[1], tolerance);
+    }
+    return compareFiles(paths[0], paths[1], tolerance) ? 0 : 1;
+  } catch (std::exception const &error) {
+    std::cerr << "Error: " << error.what() << '\n';
+    return -1;
+  }
+}
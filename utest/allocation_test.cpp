@@ -0,0 +1,102 @@
+#include "gtest/gtest.h"
+#include "../sim/neighbour_list.hpp"
+#include "../sim/parser.hpp"
+#include "../sim/profiler.hpp"
+#include "../sim/simulation.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// Every allocation of the test program goes through these, so the tests
+// can count the allocations made while stepping
+namespace {
+  std::atomic<std::int64_t> allocations{0};
+
+  void *countedAllocation(std::size_t size, std::size_t alignment) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void *memory = nullptr;
+    std::size_t const bytes = size == 0 ? 1 : size;
+    if (alignment <= alignof(std::max_align_t)) {
+      memory = std::malloc(bytes);
+    } else if (posix_memalign(&memory, alignment, bytes) != 0) {
+      memory = nullptr;
+    }
+    if (memory == nullptr) { throw std::bad_alloc(); }
+    return memory;
+  }
+}  // namespace
+
+void *operator new(std::size_t size) { return countedAllocation(size, 0); }
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  return countedAllocation(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void *memory) noexcept { std::free(memory); }
+
+void operator delete(void *memory, std::size_t /*size*/) noexcept { std::free(memory); }
+
+void operator delete(void *memory, std::align_val_t /*alignment*/) noexcept { std::free(memory); }
+
+void operator delete(void *memory, std::size_t /*size*/,
+                     std::align_val_t /*alignment*/) noexcept {
+  std::free(memory);
+}
+
+namespace {
+  // Steps before counting: the first steps size the scratch space of the
+  // grid and register the counters of every thread
+  constexpr int warmUpSteps = 3;
+  constexpr int countedSteps = 5;
+}  // namespace
+
+TEST(AllocationTest, StepsDoNotAllocate) {
+  for (int const threads : {1, 4}) {
+    for (PairMode const mode : {PairMode::gather, PairMode::symmetric}) {
+      Grid grid = readInput("small.fld");
+      ThreadPool pool(threads);
+      Profiler profiler;
+      for (int step = 0; step < warmUpSteps; step++) {
+        simulateOneStep(grid, mode, pool, nullptr, &profiler);
+      }
+
+      std::int64_t const before = allocations.load();
+      for (int step = 0; step < countedSteps; step++) {
+        simulateOneStep(grid, mode, pool, nullptr, &profiler);
+      }
+      ASSERT_EQ(allocations.load() - before, 0) << threads << " threads";
+    }
+  }
+}
+
+TEST(AllocationTest, VerletStepsDoNotAllocate) {
+  // A resting lattice just wider than the smoothing length, so the lists
+  // built on the first step last for the others
+  int const side = 6;
+  Grid grid(204, side * side * side);
+  auto const spacing = static_cast<float>(1.1 * grid.get_smoothingLength());
+  int id = 0;
+  for (int k = 0; k < side; k++) {
+    for (int j = 0; j < side; j++) {
+      for (int i = 0; i < side; i++) {
+        std::vector<float> const position = {spacing * static_cast<float>(i - side / 2),
+                                             spacing * static_cast<float>(j - side / 2),
+                                             spacing * static_cast<float>(k - side / 2)};
+        grid.add_particle_to_block(Particle(id++, position, {0, 0, 0}, {0, 0, 0}));
+      }
+    }
+  }
+  grid.repositionParticles();
+
+  ThreadPool pool(4);
+  NeighbourList lists(0.2 * grid.get_smoothingLength());
+  for (int step = 0; step < warmUpSteps; step++) { simulateOneStep(grid, lists, pool); }
+
+  std::int64_t const before = allocations.load();
+  for (int step = 0; step < countedSteps; step++) { simulateOneStep(grid, lists, pool); }
+  ASSERT_EQ(allocations.load() - before, 0);
+  ASSERT_EQ(lists.get_numRebuilds(), 1);
+}
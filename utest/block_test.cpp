@@ -2,6 +2,8 @@
 #include "../sim/block.hpp"
 #include "../sim/grid.hpp"
 
+#include <type_traits>
+
 TEST(BlockTest, ConstructorWithValidBlockIndex) {
   // Create a block with index [0, 0, 0]
   const std::vector<int> blockIndex(3, 0);
@@ -18,8 +20,8 @@ TEST(BlockTest, GetEmptyParticleVector) {
   const std::vector<int> blockIndex(3, 0);
   Block block(blockIndex);
 
-  // Check that the block's particles vector is empty
-  ASSERT_EQ(block.getParticles().size(), 0);
+  // Check that the block's particle range is empty
+  ASSERT_EQ(block.size(), 0);
 }
 
 TEST(BlockTest, AddParticle) {
@@ -28,15 +30,18 @@ TEST(BlockTest, AddParticle) {
   Block block(blockIndex);
 
   // Create a particle and add it to the block
+  ParticleStore store;
   const Particle particle(1, {1.0, 2.0, 3.0}, {4.0, 5.0, 6.0}, {7.0, 8.0, 9.0});
-  block.addParticle(particle);
-
-  // Check that the block's particles vector contains the added particle
-  ASSERT_EQ(block.getParticles().size(), 1);
-  ASSERT_EQ(block.getParticles()[0].get_id(), 1);
-  ASSERT_EQ(block.getParticles()[0].get_position(), (std::vector<float>{1.0, 2.0, 3.0}));
-  ASSERT_EQ(block.getParticles()[0].get_hv(), (std::vector<float>{4.0, 5.0, 6.0}));
-  ASSERT_EQ(block.getParticles()[0].get_velocity(), (std::vector<float>{7.0, 8.0, 9.0}));
+  int const index = store.addParticle(particle);
+  block.setRange(index, index + 1);
+
+  // Check that the block's particle range contains the added particle
+  ASSERT_EQ(block.size(), 1);
+  Particle const stored = store.getParticle(block.get_begin());
+  ASSERT_EQ(stored.get_id(), 1);
+  ASSERT_EQ(stored.get_px(), 1.0);
+  ASSERT_EQ(stored.get_hvy(), 5.0);
+  ASSERT_EQ(stored.get_vz(), 9.0);
 }
 
 TEST(BlockTest, IncreaseDensity) {
@@ -49,16 +54,15 @@ TEST(BlockTest, IncreaseDensity) {
   std::vector<float> const velocity{0.2, 0.4, 0.6};
 
   // Create a particle and add it to the block
-  Particle particle(4, position, halfVelocity, velocity);
-  block.addParticle(particle);
+  ParticleStore store;
+  int const particle = store.addParticle(Particle(4, position, halfVelocity, velocity));
+  block.setRange(particle, particle + 1);
 
   // Increase the density of the particle
-  block.incDensity(particle, grid.get_slSq(),
-                   grid.get_slSixth(),
-                   grid.get_densTransConstant());
+  block.incDensity(store, particle, grid.get_slSq());
 
   // Check that the particle's density has increased
-  ASSERT_EQ(particle.get_density(), 0);
+  ASSERT_EQ(store.density[0], 0);
 }
 
 TEST(BlockTest, FindDistance) {
@@ -67,13 +71,13 @@ TEST(BlockTest, FindDistance) {
   Block block(blockIndex);
 
   // Create two particles and add them to the block
-  const Particle particle1(7, {1.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0});
-  const Particle particle2(8, {1.01, 0.0, 0.0}, {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0});
-  block.addParticle(particle1);
-  block.addParticle(particle2);
+  ParticleStore store;
+  int const particle1 = store.addParticle(Particle(7, {1.0, 0.0, 0.0}, {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}));
+  int const particle2 = store.addParticle(Particle(8, {1.01, 0.0, 0.0}, {0.0, 0.0, 0.0}, {0.0, 0.0, 0.0}));
+  block.setRange(particle1, particle2 + 1);
 
   // Find the distance between the particles
-  const double distance = Block::findDistance(particle1, particle2);
+  const double distance = Block::findDistance(store, particle1, particle2);
 
   // Check that the distance is calculated correctly
   ASSERT_EQ(distance, 0.0099999904632568359);
@@ -88,24 +92,22 @@ TEST(BlockTest, AccelerationTransfer) {
   // Create two particles and add them to the block
   const int nine = 9;
   const int ten = 10;
-  Particle particle1(nine, {0.0, 0.0, 0.0}, {0, 0, 0}, {0, 0, 0});
-  Particle particle2(ten, {0.0, 0.0, 0.0}, {0, 0, 0}, {0, 0, 0});
-  block.addParticle(particle1);
-  block.addParticle(particle2);
+  ParticleStore store;
+  int const particle1 = store.addParticle(Particle(nine, {0.0, 0.0, 0.0}, {0, 0, 0}, {0, 0, 0}));
+  int const particle2 = store.addParticle(Particle(ten, {0.0, 0.0, 0.0}, {0, 0, 0}, {0, 0, 0}));
+  block.setRange(particle1, particle2 + 1);
 
   // Transfer acceleration between the particles
-  block.accelerationTransfer(particle1, grid.get_slSq(),
-                              grid.get_accTransConstant1(),
-                              grid.get_accTransConstant2());
+  block.accelerationTransfer(store, particle1, grid.get_kernelConstants());
 
   // Check that the particles' accelerations have been updated
-  ASSERT_EQ(particle1.get_ax(), 0);
-  ASSERT_EQ(particle1.get_ay(), -9.8);
-  ASSERT_EQ(particle1.get_az(), 0);
+  ASSERT_EQ(store.ax[0], 0);
+  ASSERT_EQ(store.ay[0], static_cast<ParticleStore::Accumulator>(-9.8));
+  ASSERT_EQ(store.az[0], 0);
 
-  ASSERT_EQ(particle2.get_ax(), 0);
-  ASSERT_EQ(particle2.get_ay(), -9.8);
-  ASSERT_EQ(particle2.get_az(), 0);
+  ASSERT_EQ(store.ax[1], 0);
+  ASSERT_EQ(store.ay[1], static_cast<ParticleStore::Accumulator>(-9.8));
+  ASSERT_EQ(store.az[1], 0);
 }
 
 TEST(BlockTest, UpdateParticleMotion) {
@@ -118,16 +120,18 @@ TEST(BlockTest, UpdateParticleMotion) {
   std::vector<float> const halfVelocity{0.1, 0.2, 0.3};
   std::vector<float> const velocity{0.2, 0.4, 0.6};
   const int eleven = 11;
-  Particle particle(eleven, position, halfVelocity, velocity);
-  block.addParticle(particle);
+  ParticleStore store;
+  int const particle = store.addParticle(Particle(eleven, position, halfVelocity, velocity));
+  block.setRange(particle, particle + 1);
 
   // Update the particle's motion
-  Block::particleMotion(particle);
+  Block::particleMotion(store, particle);
 
   // Check that the particle's position, velocity, and hv have been updated
-  ASSERT_NE(particle.get_position(), (std::vector<float>{0.01, 0.0, 0.01}));
-  ASSERT_NE(particle.get_velocity(), (std::vector<float>{0.01, 0.0, 0.01}));
-  ASSERT_NE(particle.get_hv(), (std::vector<float>{0.02, 0.0, 0.02}));
+  Particle const moved = store.getParticle(particle);
+  ASSERT_NE(moved.get_position(), position);
+  ASSERT_NE(moved.get_velocity(), velocity);
+  ASSERT_NE(moved.get_hv(), halfVelocity);
 }
 
 TEST(BlockTest, ProcessParticleBoxCollisions) {
@@ -140,16 +144,18 @@ TEST(BlockTest, ProcessParticleBoxCollisions) {
   std::vector<float> const halfVelocity{0.1, 0.2, 0.3};
   std::vector<float> const velocity{0.2, 0.4, 0.6};
   const int twelve = 12;
-  Particle particle(twelve, position, halfVelocity, velocity);
-  block.addParticle(particle);
+  ParticleStore store;
+  int const particle = store.addParticle(Particle(twelve, position, halfVelocity, velocity));
+  block.setRange(particle, particle + 1);
 
   // Process particle box collisions
-  Block::boxCollisions(particle);
+  Block::boxCollisions(store, particle);
 
   // Check that the particle's position, velocity, and hv have been updated
-  ASSERT_NE(particle.get_position(), (std::vector<float>{0.063, 0.02, 0.02}));
-  ASSERT_NE(particle.get_velocity(), (std::vector<float>{0.02, 0.0, 0.0}));
-  ASSERT_NE(particle.get_hv(), (std::vector<float>{0.04, 0.0, 0.0}));
+  Particle const collided = store.getParticle(particle);
+  ASSERT_NE(collided.get_position(), (std::vector<float>{0.063, 0.02, 0.02}));
+  ASSERT_NE(collided.get_velocity(), (std::vector<float>{0.02, 0.0, 0.0}));
+  ASSERT_NE(collided.get_hv(), (std::vector<float>{0.04, 0.0, 0.0}));
 }
 
 TEST(BlockTest, ProcessParticleBoundaryCollisions) {
@@ -162,13 +168,120 @@ TEST(BlockTest, ProcessParticleBoundaryCollisions) {
   std::vector<float> const halfVelocity{0.1, 0.2, 0.3};
   std::vector<float> const velocity{0.2, 0.4, 0.6};
   const int thirteen = 13;
-  Particle particle(thirteen, position, halfVelocity, velocity);
-  block.addParticle(particle);
+  ParticleStore store;
+  int const particle = store.addParticle(Particle(thirteen, position, halfVelocity, velocity));
+  block.setRange(particle, particle + 1);
 
   // Process particle boundary collisions
-  Block::boundaryCollisions(particle);
+  Block::boundaryCollisions(store, particle);
 
   // Check that the particle's position has been updated
-  ASSERT_NE(particle.get_position(), (std::vector<float>{0.063, 0.02, 0.04}));
+  ASSERT_NE(store.getParticle(particle).get_position(), (std::vector<float>{0.063, 0.02, 0.04}));
+}
+
+TEST(BlockTest, CollisionsOnlyTestTheWallsOfTheFaces) {
+  // A particle past the lower x wall, and copies of it in blocks of their own
+  ParticleStore store;
+  for (int copy = 0; copy < 5; copy++) {
+    store.addParticle(Particle(copy, {-0.07, 0.0, 0.0}, {-0.1, 0.0, 0.0}, {-0.1, 0.0, 0.0}));
+  }
+  auto const blockOf = [](int part) {
+    Block block({0, 0, 0});
+    block.setRange(part, part + 1);
+    return block;
+  };
+  Block::boxCollisions(store, 0);
+  blockOf(1).processBoxCollisions(store, NeighbourStencil::lowerFace(0));
+  blockOf(2).processBoxCollisions(store, NeighbourStencil::upperFace(0));
+  blockOf(3).processBoxCollisions(store, 0);
+
+  // Only the kernels that test the lower x wall push the particle back
+  ASSERT_GT(store.ax[0], 0.0);
+  ASSERT_EQ(store.ax[1], store.ax[0]);
+  ASSERT_EQ(store.ax[2], 0.0);
+  ASSERT_EQ(store.ax[3], 0.0);
+
+  // A block inside the grid leaves its particles alone
+  Block const block = blockOf(4);
+  block.processBoundaryCollisions(store, 0);
+  ASSERT_EQ(store.px[4], store.px[3]);
+  block.processBoundaryCollisions(store, NeighbourStencil::lowerFace(0));
+  ASSERT_GT(store.px[4], -0.065F);
+  ASSERT_GT(store.vx[4], 0.0F);
 }
 
+TEST(BlockTest, PairAccelerationIsAntisymmetric) {
+  const Grid grid(204.0, 2);
+  ParticleStore store;
+  int const particle1 = store.addParticle(Particle(0, {0.0, 0.0, 0.0}, {0, 0, 0}, {0.1, 0.0, 0.0}));
+  int const particle2 = store.addParticle(Particle(1, {0.002, 0.001, 0.0}, {0, 0, 0}, {0.0, 0.2, 0.0}));
+  const double density = 1100.0;
+  store.density[0] = density;
+  store.density[1] = density;
+
+  // The change particle2 causes on particle1 is the opposite of the reverse
+  auto const forward = Block::pairAcceleration(store, particle1, particle2, grid.get_kernelConstants());
+  auto const backward = Block::pairAcceleration(store, particle2, particle1, grid.get_kernelConstants());
+  ASSERT_NE(forward[0], 0.0);
+  ASSERT_EQ(forward[0], -backward[0]);
+  ASSERT_EQ(forward[1], -backward[1]);
+  ASSERT_EQ(forward[2], -backward[2]);
+}
+
+TEST(BlockTest, PairKernelsMatchGatherKernels) {
+  // Particles spread over a few neighbouring blocks
+  const int count = 40;
+  const float spacing = 0.0011;
+  auto fillGrid = [&](Grid &grid) {
+    for (int i = 0; i < count; i++) {
+      grid.add_particle_to_block(Particle(i, {static_cast<float>(i % 4) * spacing * 3,
+                                              static_cast<float>((i / 4) % 5) * spacing * 2,
+                                              static_cast<float>(i / 20) * spacing},
+                                          {0, 0, 0}, {static_cast<float>(i) * 0.01F, 0, 0}));
+    }
+    grid.repositionParticles();
+  };
+  Grid gatherGrid(204.0, count);
+  Grid pairGrid(204.0, count);
+  fillGrid(gatherGrid);
+  fillGrid(pairGrid);
+  ParticleStore &gathered = gatherGrid.get_particles();
+  ParticleStore &paired = pairGrid.get_particles();
+  KernelConstants const constants = gatherGrid.get_kernelConstants();
+
+  // Densities from every particle's neighbours and from every pair once
+  for (auto const &block : gatherGrid.get_blocks()) {
+    for (int part = block.get_begin(); part < block.get_end(); part++) {
+      block.incDensity(gathered, part, constants.slSq);
+    }
+  }
+  for (auto const &block : pairGrid.get_blocks()) { block.incDensityPairs(paired, constants.slSq); }
+  // The sums run in another order, so they differ by the rounding of the
+  // precision the sums are built in
+  bool const floatSums = std::is_same_v<ParticleStore::Accumulator, float>;
+  double const densityTolerance = floatSums ? 1e-5 : 1e-12;
+  double const accelerationTolerance = floatSums ? 1e-3 : 1e-9;
+  for (int part = 0; part < count; part++) {
+    ASSERT_GT(gathered.density[part], 0.0);
+    ASSERT_NEAR(paired.density[part], gathered.density[part],
+                densityTolerance * gathered.density[part]);
+    Block::transformDensity(gathered, part, constants);
+    Block::transformDensity(paired, part, constants);
+  }
+
+  // Accelerations from every particle's neighbours and from every pair once
+  for (auto const &block : gatherGrid.get_blocks()) {
+    for (int part = block.get_begin(); part < block.get_end(); part++) {
+      block.accelerationTransfer(gathered, part, constants);
+    }
+  }
+  for (auto const &block : pairGrid.get_blocks()) { block.accelerationTransferPairs(paired, constants); }
+  for (int part = 0; part < count; part++) {
+    ASSERT_NEAR(paired.ax[part], gathered.ax[part],
+                accelerationTolerance * (1 + std::abs(gathered.ax[part])));
+    ASSERT_NEAR(paired.ay[part], gathered.ay[part],
+                accelerationTolerance * (1 + std::abs(gathered.ay[part])));
+    ASSERT_NEAR(paired.az[part], gathered.az[part],
+                accelerationTolerance * (1 + std::abs(gathered.az[part])));
+  }
+}
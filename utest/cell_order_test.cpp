@@ -0,0 +1,91 @@
+#include "gtest/gtest.h"
+#include "../sim/cache_model.hpp"
+#include "../sim/cell_order.hpp"
+#include "../sim/parser.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+TEST(CellOrderTest, MortonKeyInterleavesBits) {
+  ASSERT_EQ(mortonKey({1, 0, 0}), 1);
+  ASSERT_EQ(mortonKey({0, 1, 0}), 2);
+  ASSERT_EQ(mortonKey({0, 0, 1}), 4);
+  ASSERT_EQ(mortonKey({3, 0, 1}), 0b001'101);
+}
+
+TEST(CellOrderTest, HilbertStepsAreFaceNeighbours) {
+  // Along a Hilbert curve consecutive cells always share a face
+  int const side = 8;
+  auto const ranks = curveRanks({side, side, side}, CellOrder::hilbert);
+  std::vector<int> byRank(ranks.size());
+  for (std::size_t cell = 0; cell < ranks.size(); cell++) {
+    byRank[static_cast<std::size_t>(ranks[cell])] = static_cast<int>(cell);
+  }
+  for (std::size_t rank = 1; rank < byRank.size(); rank++) {
+    int const from = byRank[rank - 1];
+    int const to = byRank[rank];
+    int const distance = std::abs(from % side - to % side) +
+                         std::abs((from / side) % side - (to / side) % side) +
+                         std::abs(from / (side * side) - to / (side * side));
+    ASSERT_EQ(distance, 1) << "rank " << rank;
+  }
+}
+
+TEST(CellOrderTest, RanksArePermutations) {
+  for (CellOrder const order : {CellOrder::linear, CellOrder::morton, CellOrder::hilbert}) {
+    auto ranks = curveRanks({15, 21, 15}, order);
+    std::sort(ranks.begin(), ranks.end());
+    for (std::size_t rank = 0; rank < ranks.size(); rank++) {
+      ASSERT_EQ(ranks[rank], static_cast<int>(rank));
+    }
+  }
+}
+
+TEST(CellOrderTest, BlocksFollowTheCurveInMemory) {
+  Grid grid = readInput("small.fld");
+  grid.set_cellOrder(CellOrder::hilbert);
+  grid.repositionParticles();
+
+  // Blocks are consecutive ranges in the order of get_blockOrder, and each
+  // range holds the particles of its block
+  int next = 0;
+  for (auto const block : grid.get_blockOrder()) {
+    Block const &blockObj = grid.get_blocks()[static_cast<std::size_t>(block)];
+    ASSERT_EQ(blockObj.get_begin(), next);
+    for (int part = blockObj.get_begin(); part < blockObj.get_end(); part++) {
+      ASSERT_EQ(grid.findBlockIndex(part), block);
+    }
+    next = blockObj.get_end();
+  }
+  ASSERT_EQ(next, grid.get_particles().size());
+}
+
+TEST(CellOrderTest, CacheModelEvictsLeastRecentlyUsed) {
+  // One set of two ways
+  CacheModel cache(2 * CacheModel::lineBytes, 2);
+  ASSERT_FALSE(cache.accessLine(1));
+  ASSERT_FALSE(cache.accessLine(2));
+  ASSERT_TRUE(cache.accessLine(1));
+  ASSERT_FALSE(cache.accessLine(3));  // evicts 2
+  ASSERT_TRUE(cache.accessLine(1));
+  ASSERT_FALSE(cache.accessLine(2));
+  ASSERT_EQ(cache.get_accesses(), 6);
+  ASSERT_EQ(cache.get_misses(), 4);
+}
+
+TEST(CellOrderTest, CurvesReduceStencilMisses) {
+  // Caches small enough that the stencil of small.fld does not fit, to check
+  // that the curves keep neighbouring blocks close in memory. At real cache
+  // sizes the curves show no gain. The caches scale with the size of the
+  // stored positions, so the ratio is the same in every precision
+  constexpr std::size_t scale = sizeof(ParticleStore::Real) / sizeof(float);
+  CacheSizes const sizes{4 * 1024 * scale, 4, 32 * 1024 * scale, 8};
+  Grid grid = readInput("small.fld");
+  StencilTraffic const linear = stencilTraffic(grid, sizes);
+  for (CellOrder const order : {CellOrder::morton, CellOrder::hilbert}) {
+    grid.set_cellOrder(order);
+    grid.repositionParticles();
+    StencilTraffic const curve = stencilTraffic(grid, sizes);
+    ASSERT_LT(curve.l1Misses, linear.l1Misses);
+  }
+}
@@ -0,0 +1,47 @@
+#include "gtest/gtest.h"
+#include "../sim/checkpoint.hpp"
+#include "../sim/parser.hpp"
+
+#include <filesystem>
+
+namespace {
+  std::string tempFile(std::string const &name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+  }
+}  // namespace
+
+TEST(CheckpointTest, RestartContinuesExactly) {
+  Grid grid = readInput("small.fld");
+  grid.set_cellOrder(CellOrder::hilbert);
+  simulateOneStep(grid);
+  std::string const filename = tempFile("checkpoint_test.chk");
+  std::vector<std::byte> buffer;
+  writeCheckpoint(filename, grid, 1, buffer);
+
+  int step = 0;
+  Grid restored = readCheckpoint(filename, step);
+  ASSERT_EQ(step, 1);
+  ASSERT_EQ(restored.get_np(), grid.get_np());
+  ASSERT_EQ(restored.get_count(), grid.get_count());
+  ASSERT_EQ(restored.get_ppm(), grid.get_ppm());
+  ASSERT_EQ(restored.get_cellOrder(), CellOrder::hilbert);
+
+  // One more step on both gives the same state, bit for bit
+  simulateOneStep(grid);
+  simulateOneStep(restored);
+  std::vector<std::byte> expected;
+  std::vector<std::byte> actual;
+  writeCheckpoint(filename, grid, 2, expected);
+  writeCheckpoint(filename, restored, 2, actual);
+  ASSERT_EQ(actual, expected);
+  std::filesystem::remove(filename);
+}
+
+TEST(CheckpointTest, RejectsOtherFiles) {
+  int step = 0;
+  ASSERT_THROW(static_cast<void>(readCheckpoint("small.fld", step)), std::runtime_error);
+}
+
+TEST(CheckpointTest, CheckpointName) {
+  ASSERT_EQ(checkpointName("out/final.fld"), "out/final.chk");
+}
@@ -1,20 +1,23 @@
 #include "gtest/gtest.h"
 #include "../sim/grid.hpp"
 
+#include <algorithm>
+#include <span>
+
 TEST(GridConstructorTest, ConstructorWithCorrectValues) {
   // Create a grid with 10 particles per million (ppm) and 1000 particles
   Grid const grid(10.0, 1000);
-  const auto &upperBound = Constants::getBoxUpperBound();
-  const auto &lowerBound = Constants::getBoxLowerBound();
+  const auto &upperBound = Constants::boxUpperBound;
+  const auto &lowerBound = Constants::boxLowerBound;
 
   // Check that the grid's variables are initialized correctly
   ASSERT_EQ(grid.get_ppm(), 10.0);
   ASSERT_EQ(grid.get_np(), 1000);
   ASSERT_EQ(grid.get_particleMass(), Constants::fluidDensity / pow(10.0, 3));
   ASSERT_EQ(grid.get_smoothingLength(), Constants::radiusMultiplier / 10.0);
-  ASSERT_EQ(grid.get_numberX(), (upperBound[0] - lowerBound[0]) / (Constants::radiusMultiplier / 10.0));
-  ASSERT_EQ(grid.get_numberY(), (upperBound[1] - lowerBound[1]) / (Constants::radiusMultiplier / 10.0));
-  ASSERT_EQ(grid.get_numberZ(), (upperBound[2] - lowerBound[2]) / (Constants::radiusMultiplier / 10.0));
+  ASSERT_EQ(grid.get_numberX(), std::max(1, static_cast<int>((upperBound[0] - lowerBound[0]) / (Constants::radiusMultiplier / 10.0))));
+  ASSERT_EQ(grid.get_numberY(), std::max(1, static_cast<int>((upperBound[1] - lowerBound[1]) / (Constants::radiusMultiplier / 10.0))));
+  ASSERT_EQ(grid.get_numberZ(), std::max(1, static_cast<int>((upperBound[2] - lowerBound[2]) / (Constants::radiusMultiplier / 10.0))));
   ASSERT_EQ(grid.get_sizeX(), (upperBound[0] - lowerBound[0]) / grid.get_numberX());
   ASSERT_EQ(grid.get_sizeY(), (upperBound[1] - lowerBound[1]) / grid.get_numberY());
   ASSERT_EQ(grid.get_sizeZ(), (upperBound[2] - lowerBound[2]) / grid.get_numberZ());
@@ -22,9 +25,9 @@ TEST(GridConstructorTest, ConstructorWithCorrectValues) {
   ASSERT_EQ(grid.get_slCu(), pow(grid.get_smoothingLength(), 3));
   ASSERT_EQ(grid.get_slSixth(), pow(grid.get_smoothingLength(), 6));
   ASSERT_EQ(grid.get_slNinth(), pow(grid.get_smoothingLength(), 9));
-  ASSERT_EQ(grid.get_densTransConstant(), (315.0 / 64 * M_PI * grid.get_slNinth()) * grid.get_particleMass());
-  ASSERT_EQ(grid.get_accTransConstant1(), (15 / M_PI * grid.get_slSixth()) * ((3 * grid.get_particleMass() * Constants::stiffnessPressure) / 2));
-  ASSERT_EQ(grid.get_accTransConstant2(), (45 / M_PI * grid.get_slSixth()) * Constants::viscosity * grid.get_particleMass());
+  ASSERT_EQ(grid.get_densTransConstant(), (315.0 / (64 * M_PI * grid.get_slNinth())) * grid.get_particleMass());
+  ASSERT_EQ(grid.get_accTransConstant1(), (15 / (M_PI * grid.get_slSixth())) * ((3 * grid.get_particleMass() * Constants::stiffnessPressure) / 2));
+  ASSERT_EQ(grid.get_accTransConstant2(), (45 / (M_PI * grid.get_slSixth())) * Constants::viscosity * grid.get_particleMass());
 }
 
 TEST(GridAddParticleToBlockTest, AddParticleToExistingBlock) {
@@ -36,11 +39,12 @@ TEST(GridAddParticleToBlockTest, AddParticleToExistingBlock) {
   // Create a particle and add it to the grid
   Particle const particle(1, {1.0, 2.0, 3.0}, {4.0, 5.0, 6.0}, {7.0, 8.0, 9.0});
   grid.add_particle_to_block(particle);
+  grid.repositionParticles();
 
   // Check that the particle is in the grid's blocks
   std::vector<int> const blockIndices = grid.findBlock(particle);
-  ASSERT_EQ(grid.get_blocks().count(blockIndices), 1);
-//   ASSERT_EQ(grid.get_blocks()[blockIndices].get_particles().size(), 1);
+  int const block = grid.blockIndex(blockIndices[0], blockIndices[1], blockIndices[2]);
+  ASSERT_EQ(grid.get_blocks()[block].size(), 1);
 }
 
 TEST(GridAddParticleToBlockTest, AddParticleToNewBlock) {
@@ -52,11 +56,12 @@ const int npnp = 1000;
   // Create a particle and add it to the grid
   Particle const particle(2, {11.0, 12.0, 13.0}, {14.0, 15.0, 16.0}, {17.0, 18.0, 19.0});
   grid.add_particle_to_block(particle);
+  grid.repositionParticles();
 
   // Check that the particle is in the grid's blocks
   std::vector<int> const blockIndices = grid.findBlock(particle);
-  ASSERT_EQ(grid.get_blocks().count(blockIndices), 1);
-//   ASSERT_EQ(grid.get_blocks()[blockIndices].get_particles().size(), 1);
+  int const block = grid.blockIndex(blockIndices[0], blockIndices[1], blockIndices[2]);
+  ASSERT_EQ(grid.get_blocks()[block].size(), 1);
 }
 
 TEST(GridUpdateGridTest, UpdateGridWithNewParameters) {
@@ -64,8 +69,8 @@ TEST(GridUpdateGridTest, UpdateGridWithNewParameters) {
   const int ppm = 10;
   const int npnp = 1000;
   Grid grid(ppm, npnp);
-  const auto &upperBound = Constants::getBoxUpperBound();
-  const auto &lowerBound = Constants::getBoxLowerBound();
+  const auto &upperBound = Constants::boxUpperBound;
+  const auto &lowerBound = Constants::boxLowerBound;
 
   // Update the grid's parameters
   grid.update_grid();
@@ -75,9 +80,9 @@ TEST(GridUpdateGridTest, UpdateGridWithNewParameters) {
   ASSERT_EQ(grid.get_np(), 1000);
   ASSERT_EQ(grid.get_particleMass(), Constants::fluidDensity / pow(10.0, 3));
   ASSERT_EQ(grid.get_smoothingLength(), Constants::radiusMultiplier / 10.0);
-  ASSERT_EQ(grid.get_numberX(), (upperBound[0] - lowerBound[0]) / (Constants::radiusMultiplier / 10.0));
-  ASSERT_EQ(grid.get_numberY(), (upperBound[1] - lowerBound[1]) / (Constants::radiusMultiplier / 10.0));
-  ASSERT_EQ(grid.get_numberZ(), (upperBound[2] - lowerBound[2]) / (Constants::radiusMultiplier / 10.0));
+  ASSERT_EQ(grid.get_numberX(), std::max(1, static_cast<int>((upperBound[0] - lowerBound[0]) / (Constants::radiusMultiplier / 10.0))));
+  ASSERT_EQ(grid.get_numberY(), std::max(1, static_cast<int>((upperBound[1] - lowerBound[1]) / (Constants::radiusMultiplier / 10.0))));
+  ASSERT_EQ(grid.get_numberZ(), std::max(1, static_cast<int>((upperBound[2] - lowerBound[2]) / (Constants::radiusMultiplier / 10.0))));
   ASSERT_EQ(grid.get_sizeX(), (upperBound[0] - lowerBound[0]) / grid.get_numberX());
   ASSERT_EQ(grid.get_sizeY(), (upperBound[1] - lowerBound[1]) / grid.get_numberY());
   ASSERT_EQ(grid.get_sizeZ(), (upperBound[2] - lowerBound[2]) / grid.get_numberZ());
@@ -85,9 +90,9 @@ TEST(GridUpdateGridTest, UpdateGridWithNewParameters) {
   ASSERT_EQ(grid.get_slCu(), pow(grid.get_smoothingLength(), 3));
   ASSERT_EQ(grid.get_slSixth(), pow(grid.get_smoothingLength(), 6));
   ASSERT_EQ(grid.get_slNinth(), pow(grid.get_smoothingLength(), 9));
-  ASSERT_EQ(grid.get_densTransConstant(), (315.0 / 64 * M_PI * grid.get_slNinth()) * grid.get_particleMass());
-  ASSERT_EQ(grid.get_accTransConstant1(), (15 / M_PI * grid.get_slSixth()) * ((3 * grid.get_particleMass() * Constants::stiffnessPressure) / 2));
-  ASSERT_EQ(grid.get_accTransConstant2(), (45 / M_PI * grid.get_slSixth()) * Constants::viscosity * grid.get_particleMass());
+  ASSERT_EQ(grid.get_densTransConstant(), (315.0 / (64 * M_PI * grid.get_slNinth())) * grid.get_particleMass());
+  ASSERT_EQ(grid.get_accTransConstant1(), (15 / (M_PI * grid.get_slSixth())) * ((3 * grid.get_particleMass() * Constants::stiffnessPressure) / 2));
+  ASSERT_EQ(grid.get_accTransConstant2(), (45 / (M_PI * grid.get_slSixth())) * Constants::viscosity * grid.get_particleMass());
 }
 
 TEST(GridFindBlockTest, FindBlockWithValidParticlePosition) {
@@ -105,3 +110,81 @@ TEST(GridFindBlockTest, FindBlockWithValidParticlePosition) {
   ASSERT_EQ(blockIndices[1], 0);
   ASSERT_EQ(blockIndices[2], 0);
 }
+
+TEST(GridBlockIndexTest, LinearIndexRoundTrip) {
+  // Create a grid with the particles per meter of small.fld
+  const float ppm = 204.0;
+  const int npnp = 4800;
+  Grid const grid(ppm, npnp);
+
+  // Check that the grid has the expected number of blocks
+  ASSERT_EQ(grid.get_numberX(), 15);
+  ASSERT_EQ(grid.get_numberY(), 21);
+  ASSERT_EQ(grid.get_numberZ(), 15);
+  ASSERT_EQ(grid.get_numBlocks(), 15 * 21 * 15);
+
+  // Check that linear indices and block coordinates round trip
+  for (int block = 0; block < grid.get_numBlocks(); block++) {
+    auto const coords = grid.blockCoordinates(block);
+    ASSERT_EQ(grid.blockIndex(coords[0], coords[1], coords[2]), block);
+    ASSERT_EQ(grid.get_blocks()[block].get_index()[0], coords[0]);
+    ASSERT_EQ(grid.get_blocks()[block].get_index()[1], coords[1]);
+    ASSERT_EQ(grid.get_blocks()[block].get_index()[2], coords[2]);
+  }
+}
+
+TEST(GridBlockIndexTest, BoundaryBlocksAreTheOuterShell) {
+  Grid const grid(204.0, 0);
+
+  // Every block but the 13 x 19 x 13 inner ones touches a face
+  std::span<int const> const boundary = grid.get_boundaryBlocks();
+  ASSERT_EQ(std::ssize(boundary), grid.get_numBlocks() - 13 * 19 * 13);
+  for (auto const block : boundary) { ASSERT_NE(grid.get_stencil().faces(block), 0); }
+
+  // In the order of the particles
+  std::span<int const> const order = grid.get_blockOrder();
+  ASSERT_TRUE(std::is_sorted(boundary.begin(), boundary.end(), [order](int lhs, int rhs) {
+    return std::find(order.begin(), order.end(), lhs) < std::find(order.begin(), order.end(), rhs);
+  }));
+}
+
+TEST(GridRepositionTest, ParticlesAreSortedByBlock) {
+  const float ppm = 204.0;
+  const int npnp = 4;
+  Grid grid(ppm, npnp);
+
+  // Add particles in blocks that are out of order with the particle ids
+  grid.add_particle_to_block(Particle(0, {0.06, 0.09, 0.06}, {0, 0, 0}, {0, 0, 0}));
+  grid.add_particle_to_block(Particle(1, {-0.06, -0.07, -0.06}, {0, 0, 0}, {0, 0, 0}));
+  grid.add_particle_to_block(Particle(2, {0.06, 0.09, 0.06}, {0, 0, 0}, {0, 0, 0}));
+  grid.add_particle_to_block(Particle(3, {0.0, 0.0, 0.0}, {0, 0, 0}, {0, 0, 0}));
+  grid.repositionParticles();
+
+  // Check that particles are stored in block order, stable within a block
+  ParticleStore const &store = grid.get_particles();
+  ASSERT_EQ(store.size(), 4);
+  ASSERT_EQ(store.id[0], 1);
+  ASSERT_EQ(store.id[1], 3);
+  ASSERT_EQ(store.id[2], 0);
+  ASSERT_EQ(store.id[3], 2);
+
+  // Check that every block's range holds exactly its particles
+  int total = 0;
+  for (int block = 0; block < grid.get_numBlocks(); block++) {
+    Block const &blk = grid.get_blocks()[block];
+    ASSERT_EQ(blk.get_begin(), total);
+    for (int part = blk.get_begin(); part < blk.get_end(); part++) {
+      ASSERT_EQ(grid.findBlockIndex(part), block);
+    }
+    total += blk.size();
+  }
+  ASSERT_EQ(total, 4);
+
+  // Moving a particle to another block is picked up on the next repositioning
+  grid.get_particles().px[0] = 0.06;
+  grid.get_particles().py[0] = 0.09;
+  grid.get_particles().pz[0] = 0.06;
+  grid.repositionParticles();
+  ASSERT_EQ(store.id[0], 3);
+  ASSERT_EQ(grid.get_blocks()[grid.findBlockIndex(3)].size(), 3);
+}
@@ -0,0 +1,145 @@
+#include "gtest/gtest.h"
+#include "../sim/neighbour_list.hpp"
+#include "../sim/parser.hpp"
+#include "../sim/profiler.hpp"
+#include "../sim/simulation.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+TEST(NeighbourListTest, ListsHoldEveryParticleWithinRadius) {
+  Grid grid = readInput("small.fld");
+  double const skin = 0.3 * grid.get_smoothingLength();
+  NeighbourList lists(skin);
+  ASSERT_TRUE(lists.needsRebuild(grid.get_particles()));
+  lists.rebuild(grid);
+
+  // Compare with every pair of particles, including the blocks two away
+  ParticleStore const &store = grid.get_particles();
+  double const radius = grid.get_smoothingLength() + skin;
+  int total = 0;
+  for (int part = 0; part < store.size(); part += 7) {
+    std::vector<int> expected;
+    for (int other = 0; other < store.size(); other++) {
+      auto const idx = static_cast<std::size_t>(part);
+      auto const otherIdx = static_cast<std::size_t>(other);
+      double const xDiff = static_cast<double>(store.px[idx]) - store.px[otherIdx];
+      double const yDiff = static_cast<double>(store.py[idx]) - store.py[otherIdx];
+      double const zDiff = static_cast<double>(store.pz[idx]) - store.pz[otherIdx];
+      if (other != part and xDiff * xDiff + yDiff * yDiff + zDiff * zDiff < radius * radius) {
+        expected.push_back(other);
+      }
+    }
+    std::vector<int> actual(lists.neighbours(part).begin(), lists.neighbours(part).end());
+    std::sort(actual.begin(), actual.end());
+    ASSERT_EQ(actual, expected) << "particle " << part;
+    total += static_cast<int>(actual.size());
+  }
+  ASSERT_GT(total, 0);
+  ASSERT_EQ(lists.get_numRebuilds(), 1);
+}
+
+TEST(NeighbourListTest, RebuildAfterHalfSkinDisplacement) {
+  Grid grid = readInput("small.fld");
+  double const skin = 0.2 * grid.get_smoothingLength();
+  NeighbourList lists(skin);
+  lists.rebuild(grid);
+  ASSERT_FALSE(lists.needsRebuild(grid.get_particles()));
+
+  // Just under half the skin keeps the lists, just over it does not
+  ParticleStore &store = grid.get_particles();
+  float const original = store.px[10];
+  store.px[10] = original + static_cast<float>(0.49 * skin);
+  ASSERT_FALSE(lists.needsRebuild(store));
+  store.px[10] = original + static_cast<float>(0.51 * skin);
+  ASSERT_TRUE(lists.needsRebuild(store));
+}
+
+TEST(NeighbourListTest, StepsMatchBlockScan) {
+  Grid blockGrid = readInput("small.fld");
+  Grid listGrid = readInput("small.fld");
+  NeighbourList lists(0.2 * listGrid.get_smoothingLength());
+  ThreadPool pool(3);
+  for (int step = 0; step < 2; step++) {
+    simulateOneStep(blockGrid, PairMode::gather);
+    simulateOneStep(listGrid, lists, pool);
+  }
+
+  // Same particles in a different order: compare by id
+  ParticleStore const &expected = blockGrid.get_particles();
+  ParticleStore const &actual = listGrid.get_particles();
+  std::vector<std::size_t> byId(static_cast<std::size_t>(actual.size()));
+  for (std::size_t i = 0; i < byId.size(); i++) {
+    byId[static_cast<std::size_t>(actual.id[i])] = i;
+  }
+  for (std::size_t i = 0; i < static_cast<std::size_t>(expected.size()); i++) {
+    std::size_t const j = byId[static_cast<std::size_t>(expected.id[i])];
+    ASSERT_NEAR(actual.px[j], expected.px[i], 1e-4 * (std::abs(expected.px[i]) + 1.0));
+    ASSERT_NEAR(actual.density[j], expected.density[i], 1e-5 * expected.density[i]);
+  }
+}
+
+TEST(NeighbourListTest, ListsAreReusedWhileParticlesMoveLittle) {
+  // A resting lattice just wider than the smoothing length only falls
+  // under gravity, a tiny fraction of the skin per step
+  float const ppm = 204;
+  int const side = 6;
+  Grid grid(ppm, side * side * side);
+  auto const spacing = static_cast<float>(1.1 * grid.get_smoothingLength());
+  int id = 0;
+  for (int k = 0; k < side; k++) {
+    for (int j = 0; j < side; j++) {
+      for (int i = 0; i < side; i++) {
+        std::vector<float> const position = {spacing * static_cast<float>(i - side / 2),
+                                             spacing * static_cast<float>(j - side / 2),
+                                             spacing * static_cast<float>(k - side / 2)};
+        grid.add_particle_to_block(Particle(id++, position, {0, 0, 0}, {0, 0, 0}));
+      }
+    }
+  }
+  grid.repositionParticles();
+
+  NeighbourList lists(0.2 * grid.get_smoothingLength());
+  for (int step = 0; step < 10; step++) { simulateOneStep(grid, lists); }
+  ASSERT_EQ(lists.get_numRebuilds(), 1);
+  // Every inner particle keeps its six nearest neighbours in its list
+  ASSERT_GE(lists.get_numCandidates(), 6 * (side - 2) * (side - 2) * (side - 2));
+}
+
+#ifdef FLUID_PROFILE
+TEST(NeighbourListTest, LargeSkinKeepsTheWallCollisions) {
+  // Half of this skin is wider than a block, so without rebuilding before
+  // particles leave their blocks the walls would miss the ones that reach
+  // them from an interior block
+  Grid blockGrid = readInput("small.fld");
+  Grid listGrid = readInput("small.fld");
+  NeighbourList lists(8 * listGrid.get_smoothingLength());
+  ASSERT_GT(lists.get_skin() / 2, listGrid.get_sizeX());
+  std::int64_t blockCollisions = 0;
+  std::int64_t listCollisions = 0;
+  for (int step = 0; step < 3; step++) {
+    {
+      Profiler const profiler;
+      simulateOneStep(blockGrid, PairMode::gather);
+      blockCollisions += profiler.get_counter(Counter::wallCollisions);
+    }
+    Profiler const profiler;
+    simulateOneStep(listGrid, lists);
+    listCollisions += profiler.get_counter(Counter::wallCollisions);
+  }
+  ASSERT_EQ(listCollisions, blockCollisions);
+
+  ParticleStore const &expected = blockGrid.get_particles();
+  ParticleStore const &actual = listGrid.get_particles();
+  std::vector<std::size_t> byId(static_cast<std::size_t>(actual.size()));
+  for (std::size_t i = 0; i < byId.size(); i++) {
+    byId[static_cast<std::size_t>(actual.id[i])] = i;
+  }
+  for (std::size_t i = 0; i < static_cast<std::size_t>(expected.size()); i++) {
+    std::size_t const j = byId[static_cast<std::size_t>(expected.id[i])];
+    ASSERT_NEAR(actual.px[j], expected.px[i], 1e-4 * (std::abs(expected.px[i]) + 1.0));
+    ASSERT_NEAR(actual.py[j], expected.py[i], 1e-4 * (std::abs(expected.py[i]) + 1.0));
+    ASSERT_NEAR(actual.pz[j], expected.pz[i], 1e-4 * (std::abs(expected.pz[i]) + 1.0));
+  }
+}
+#endif
@@ -0,0 +1,106 @@
+#include "gtest/gtest.h"
+#include "../sim/grid.hpp"
+#include "../sim/neighbour_stencil.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <vector>
+
+namespace {
+  // Blocks at most one step away from a block along every axis, clipped to
+  // the grid, as bounds of block coordinates (inclusive)
+  struct ClippedRange {
+    std::array<int, 3> lower;
+    std::array<int, 3> upper;
+  };
+
+  ClippedRange clippedRange(Grid const &grid, int block) {
+    auto const coords = grid.blockCoordinates(block);
+    std::array<int, 3> const numbers = {grid.get_numberX(), grid.get_numberY(),
+                                        grid.get_numberZ()};
+    ClippedRange range{};
+    for (std::size_t axis = 0; axis < 3; axis++) {
+      range.lower[axis] = std::max(coords[axis] - 1, 0);
+      range.upper[axis] = std::min(coords[axis] + 1, numbers[axis] - 1);
+    }
+    return range;
+  }
+}  // namespace
+
+TEST(NeighbourStencilTest, ClippedRangeOfCornerAndInterior) {
+  Grid const grid(204, 0);
+  auto const corner = clippedRange(grid, grid.blockIndex(0, 0, 0));
+  ASSERT_EQ(corner.lower, (std::array<int, 3>{0, 0, 0}));
+  ASSERT_EQ(corner.upper, (std::array<int, 3>{1, 1, 1}));
+  auto const last = clippedRange(grid, grid.get_numBlocks() - 1);
+  ASSERT_EQ(last.lower, (std::array<int, 3>{13, 19, 13}));
+  ASSERT_EQ(last.upper, (std::array<int, 3>{14, 20, 14}));
+}
+
+TEST(NeighbourStencilTest, NeighboursMatchClippedRange) {
+  Grid const grid(204, 0);
+  NeighbourStencil const &stencil = grid.get_stencil();
+
+  // Check that every block gets the blocks of its clipped range, in the
+  // order of their linear indices
+  for (int block = 0; block < grid.get_numBlocks(); block++) {
+    auto const range = clippedRange(grid, block);
+    std::vector<int> expected;
+    for (int k = range.lower[2]; k <= range.upper[2]; k++) {
+      for (int j = range.lower[1]; j <= range.upper[1]; j++) {
+        for (int i = range.lower[0]; i <= range.upper[0]; i++) {
+          expected.push_back(grid.blockIndex(i, j, k));
+        }
+      }
+    }
+    std::vector<int> actual;
+    stencil.forEachNeighbour(block, [&actual](int adjBlock) { actual.push_back(adjBlock); });
+    ASSERT_EQ(actual, expected) << "block " << block;
+  }
+}
+
+TEST(NeighbourStencilTest, FacesOfCornersEdgesAndInterior) {
+  Grid const grid(204, 0);
+  NeighbourStencil const &stencil = grid.get_stencil();
+  auto const neighbours = [&stencil](int block) {
+    return std::popcount(stencil.neighbourSlots(block));
+  };
+
+  int const corner = grid.blockIndex(0, 0, 0);
+  ASSERT_EQ(stencil.faces(corner), NeighbourStencil::lowerFace(0) |
+                                       NeighbourStencil::lowerFace(1) |
+                                       NeighbourStencil::lowerFace(2));
+  ASSERT_EQ(neighbours(corner), 8);
+
+  int const edge = grid.blockIndex(grid.get_numberX() - 1, 0, 5);
+  ASSERT_EQ(stencil.faces(edge), NeighbourStencil::upperFace(0) | NeighbourStencil::lowerFace(1));
+  ASSERT_EQ(neighbours(edge), 12);
+
+  int const face = grid.blockIndex(5, 6, grid.get_numberZ() - 1);
+  ASSERT_EQ(stencil.faces(face), NeighbourStencil::upperFace(2));
+  ASSERT_EQ(neighbours(face), 18);
+
+  int const interior = grid.blockIndex(5, 6, 7);
+  ASSERT_EQ(stencil.faces(interior), 0);
+  ASSERT_EQ(neighbours(interior), NeighbourStencil::numSlots);
+}
+
+TEST(NeighbourStencilTest, ForwardSlotsHaveLargerIndices) {
+  Grid const grid(204, 0);
+  NeighbourStencil const &stencil = grid.get_stencil();
+  auto const offsets = stencil.get_offsets();
+  for (std::size_t slot = 0; slot < offsets.size(); slot++) {
+    bool const forward = (NeighbourStencil::forwardSlots >> slot & 1U) != 0;
+    ASSERT_EQ(forward, offsets[slot] > 0) << "slot " << slot;
+  }
+  ASSERT_EQ(offsets[NeighbourStencil::centreSlot], 0);
+}
+
+TEST(NeighbourStencilTest, SingleLayerHasNoNeighboursAcrossIt) {
+  // One block along y: both of its faces are on the grid boundary
+  NeighbourStencil const stencil({4, 1, 3});
+  int const block = 1 + 4 * 1;
+  ASSERT_EQ(stencil.faces(block), NeighbourStencil::lowerFace(1) | NeighbourStencil::upperFace(1));
+  ASSERT_EQ(std::popcount(stencil.neighbourSlots(block)), 9);
+}
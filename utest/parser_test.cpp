@@ -0,0 +1,118 @@
+#include "gtest/gtest.h"
+#include "../sim/parser.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+
+namespace {
+  // Copy of small.fld cut after the given number of bytes
+  std::string truncatedCopy(std::uintmax_t bytes) {
+    std::string const filename =
+        (std::filesystem::temp_directory_path() / "parser_test_truncated.fld").string();
+    std::filesystem::copy_file("small.fld", filename,
+                               std::filesystem::copy_options::overwrite_existing);
+    std::filesystem::resize_file(filename, bytes);
+    return filename;
+  }
+}  // namespace
+
+TEST(ParserTest, ReadsEveryParticleOnce) {
+  Grid const grid = readInput("small.fld");
+  ParticleStore const &store = grid.get_particles();
+
+  // Exactly the particles in the header, with no extra one at the end
+  ASSERT_EQ(grid.get_np(), 4800);
+  ASSERT_EQ(grid.get_count(), grid.get_np());
+  ASSERT_EQ(store.size(), grid.get_np());
+
+  std::vector<int> ids(store.id.begin(), store.id.end());
+  std::sort(ids.begin(), ids.end());
+  for (int i = 0; i < store.size(); i++) { ASSERT_EQ(ids[static_cast<std::size_t>(i)], i); }
+}
+
+TEST(ParserTest, DecodesRecordFields) {
+  // First record of small.fld, read field by field
+  std::ifstream input("small.fld", std::ios::binary);
+  input.seekg(sizeof(float) + sizeof(int));
+  std::array<float, 9> record{};
+  input.read(reinterpret_cast<char *>(record.data()), sizeof(record));
+
+  Grid const grid = readInput("small.fld");
+  ParticleStore const &store = grid.get_particles();
+  auto const first = std::find(store.id.begin(), store.id.end(), 0);
+  ASSERT_NE(first, store.id.end());
+  auto const i = static_cast<std::size_t>(first - store.id.begin());
+  ASSERT_EQ(store.px[i], record[0]);
+  ASSERT_EQ(store.py[i], record[1]);
+  ASSERT_EQ(store.pz[i], record[2]);
+  ASSERT_EQ(store.hvx[i], record[3]);
+  ASSERT_EQ(store.hvy[i], record[4]);
+  ASSERT_EQ(store.hvz[i], record[5]);
+  ASSERT_EQ(store.vx[i], record[6]);
+  ASSERT_EQ(store.vy[i], record[7]);
+  ASSERT_EQ(store.vz[i], record[8]);
+  ASSERT_EQ(store.density[i], 0.0);
+  ASSERT_EQ(store.ay[i],
+            static_cast<ParticleStore::Accumulator>(Constants::externalAcceleration[1]));
+}
+
+TEST(ParserTest, MissingRecordsLowerTheCount) {
+  // Ten whole records short of the header's count
+  std::string const filename = truncatedCopy(8 + 4790 * 36);
+  Grid const grid = readInput(filename);
+  ASSERT_EQ(grid.get_np(), 4800);
+  ASSERT_EQ(grid.get_count(), 4790);
+  std::remove(filename.c_str());
+}
+
+TEST(ParserTest, IncompleteRecordThrows) {
+  std::string const filename = truncatedCopy(8 + 4790 * 36 + 5);
+  ASSERT_THROW(static_cast<void>(readInput(filename)), std::runtime_error);
+  std::remove(filename.c_str());
+}
+
+TEST(ParserTest, MissingFileThrows) {
+  ASSERT_THROW(static_cast<void>(readInput("no-such-file.fld")), std::system_error);
+}
+
+TEST(ParserTest, OutputRecordsAreSortedById) {
+  Grid const grid = readInput("small.fld");
+  std::vector<std::byte> buffer;
+  encodeOutput(grid, buffer);
+  ASSERT_EQ(buffer.size(), 8 + 4800 * 36);
+
+  // A freshly read grid is written back unchanged, whatever the block order
+  MappedFile const input("small.fld");
+  ASSERT_EQ(buffer.size(), input.bytes().size());
+  ASSERT_TRUE(std::equal(buffer.begin(), buffer.end(), input.bytes().begin()));
+}
+
+TEST(ParserTest, OutputDoesNotDependOnThreads) {
+  Grid grid = readInput("small.fld");
+  simulateOneStep(grid);
+  std::vector<std::byte> serial;
+  encodeOutput(grid, serial);
+  ThreadPool pool(4);
+  std::vector<std::byte> threaded;
+  encodeOutput(grid, threaded, pool);
+  ASSERT_EQ(serial, threaded);
+}
+
+TEST(ParserTest, WrittenOutputReadsBack) {
+  Grid grid = readInput("small.fld");
+  simulateOneStep(grid);
+  std::string const filename =
+      (std::filesystem::temp_directory_path() / "parser_test_output.fld").string();
+  writeOutput(filename, grid);
+
+  Grid const reread = readInput(filename);
+  ASSERT_EQ(reread.get_count(), grid.get_count());
+  std::vector<std::byte> expected;
+  std::vector<std::byte> actual;
+  encodeOutput(grid, expected);
+  encodeOutput(reread, actual);
+  ASSERT_EQ(actual, expected);
+  std::remove(filename.c_str());
+}
@@ -24,7 +24,9 @@ TEST(ParticleTest, ConstructorTest) {
   ASSERT_EQ(particle.get_density(), 0.0);
 
   // Check that the particle's acceleration is set to the external acceleration
-  ASSERT_EQ(particle.get_acceleration(), Constants::getExternalAcceleration());
+  ASSERT_EQ(particle.get_acceleration(),
+            std::vector<double>(Constants::externalAcceleration.begin(),
+                                Constants::externalAcceleration.end()));
 
   // Check that the particle's accelerated flag is initialized to false
   ASSERT_FALSE(particle.hasAccelerated());
@@ -0,0 +1,90 @@
+#include "gtest/gtest.h"
+#include "../sim/particle_store.hpp"
+
+#include <cstdint>
+
+TEST(ParticleStoreTest, AddParticleAppendsToEveryArray) {
+  ParticleStore store;
+  Particle const particle(5, {0.1, 0.2, 0.3}, {0.4, 0.5, 0.6}, {0.7, 0.8, 0.9});
+
+  // The first particle goes to index 0
+  int const index = store.addParticle(particle);
+  ASSERT_EQ(index, 0);
+  ASSERT_EQ(store.size(), 1);
+
+  // Check that every array holds the particle's values
+  ASSERT_EQ(store.id[0], 5);
+  ASSERT_EQ(store.px[0], 0.1F);
+  ASSERT_EQ(store.py[0], 0.2F);
+  ASSERT_EQ(store.pz[0], 0.3F);
+  ASSERT_EQ(store.hvx[0], 0.4F);
+  ASSERT_EQ(store.hvy[0], 0.5F);
+  ASSERT_EQ(store.hvz[0], 0.6F);
+  ASSERT_EQ(store.vx[0], 0.7F);
+  ASSERT_EQ(store.vy[0], 0.8F);
+  ASSERT_EQ(store.vz[0], 0.9F);
+  ASSERT_EQ(store.density[0], 0.0);
+  using Accumulator = ParticleStore::Accumulator;
+  ASSERT_EQ(store.ax[0], static_cast<Accumulator>(Constants::externalAcceleration[0]));
+  ASSERT_EQ(store.ay[0], static_cast<Accumulator>(Constants::externalAcceleration[1]));
+  ASSERT_EQ(store.az[0], static_cast<Accumulator>(Constants::externalAcceleration[2]));
+}
+
+TEST(ParticleStoreTest, GetParticleRoundTrip) {
+  ParticleStore store;
+  store.addParticle(Particle(1, {1.0, 2.0, 3.0}, {4.0, 5.0, 6.0}, {7.0, 8.0, 9.0}));
+  int const index = store.addParticle(Particle(2, {0.1, 0.2, 0.3}, {0.4, 0.5, 0.6}, {0.7, 0.8, 0.9}));
+  const double thirt = 13.5;
+  store.density[1] = thirt;
+  store.ax[1] = 1.0;
+
+  // Check that the particle is rebuilt from the arrays at its index
+  Particle const particle = store.getParticle(index);
+  ASSERT_EQ(particle.get_id(), 2);
+  ASSERT_EQ(particle.get_position(), (std::vector<float>{0.1, 0.2, 0.3}));
+  ASSERT_EQ(particle.get_hv(), (std::vector<float>{0.4, 0.5, 0.6}));
+  ASSERT_EQ(particle.get_velocity(), (std::vector<float>{0.7, 0.8, 0.9}));
+  ASSERT_EQ(particle.get_density(), thirt);
+  ASSERT_EQ(particle.get_ax(), 1.0);
+}
+
+TEST(ParticleStoreTest, ArraysAreAligned) {
+  ParticleStore store;
+  store.reserve(3);
+  for (int i = 0; i < 3; i++) {
+    store.addParticle(Particle(i, {0, 0, 0}, {0, 0, 0}, {0, 0, 0}));
+  }
+
+  // Check that each array starts on a particleAlignment boundary
+  ASSERT_EQ(reinterpret_cast<std::uintptr_t>(store.px.data()) % particleAlignment, 0);
+  ASSERT_EQ(reinterpret_cast<std::uintptr_t>(store.hvy.data()) % particleAlignment, 0);
+  ASSERT_EQ(reinterpret_cast<std::uintptr_t>(store.vz.data()) % particleAlignment, 0);
+  ASSERT_EQ(reinterpret_cast<std::uintptr_t>(store.density.data()) % particleAlignment, 0);
+  ASSERT_EQ(reinterpret_cast<std::uintptr_t>(store.ax.data()) % particleAlignment, 0);
+
+  // Check that clearing empties every array
+  store.clear();
+  ASSERT_EQ(store.size(), 0);
+  ASSERT_TRUE(store.pz.empty());
+}
+
+TEST(ParticleStoreTest, PackUnpackRoundTrip) {
+  ParticleStore store;
+  for (int i = 0; i < 5; i++) {
+    store.addParticle(Particle(i, {0.1F * i, 0.2F, 0.3F}, {0.4F, 0.5F, 0.6F}, {0.7F, 0.8F, 0.9F}));
+  }
+  store.density[3] = 2.5;
+  store.az[4] = -1.5;
+
+  std::vector<std::byte> bytes(ParticleStore::packedBytes(store.size()));
+  store.pack(bytes);
+  ParticleStore copy;
+  copy.unpack(bytes, store.size());
+
+  ASSERT_EQ(copy.size(), 5);
+  ASSERT_EQ(copy.id[2], 2);
+  ASSERT_EQ(copy.px[4], store.px[4]);
+  ASSERT_EQ(copy.vz[1], store.vz[1]);
+  ASSERT_EQ(copy.density[3], 2.5);
+  ASSERT_EQ(copy.az[4], -1.5);
+}
@@ -0,0 +1,58 @@
+#include "gtest/gtest.h"
+#include "../sim/perf_counters.hpp"
+#include "../sim/profiler.hpp"
+#include "../sim/thread_pool.hpp"
+
+#include <cmath>
+#include <sstream>
+
+namespace {
+  // Some work on every thread of the pool
+  void spin(ThreadPool &pool) {
+    std::vector<double> sums(64);
+    pool.parallelFor(static_cast<int>(sums.size()), [&sums](int begin, int end) {
+      for (auto chunk = static_cast<std::size_t>(begin); chunk < static_cast<std::size_t>(end);
+           chunk++) {
+        for (int i = 1; i < 100000; i++) { sums[chunk] += std::sqrt(static_cast<double>(i)); }
+      }
+    });
+    ASSERT_GT(sums[0], 0.0);
+  }
+}  // namespace
+
+TEST(PerfCountersTest, CountsOrReportsWhyNot) {
+  ThreadPool pool(2);
+  PerfCounters const counters(pool.get_threadIds());
+  if (not counters.available()) {
+    ASSERT_FALSE(counters.get_error().empty());
+    for (std::int64_t const count : counters.read()) { ASSERT_EQ(count, -1); }
+    GTEST_SKIP() << "hardware counters unavailable: " << counters.get_error();
+  }
+  ASSERT_TRUE(counters.counted(PerfEvent::cycles) or counters.counted(PerfEvent::instructions));
+  PerfCounts const before = counters.read();
+  spin(pool);
+  PerfCounts const after = counters.read();
+  for (std::size_t event = 0; event < before.size(); event++) {
+    ASSERT_GE(after[event], before[event]) << perfEventNames[event];
+  }
+}
+
+#ifdef FLUID_PROFILE
+TEST(PerfCountersTest, ProfileReportsAvailability) {
+  ThreadPool pool(2);
+  Profiler profiler;
+  bool const available = profiler.enablePerfCounters(pool);
+  ASSERT_EQ(available, profiler.get_perfError().empty());
+  {
+    PhaseTimer const timer(&profiler, Phase::densinc);
+    spin(pool);
+  }
+  std::ostringstream report;
+  profiler.writeReport(report, 1, 1, pool.size());
+  ASSERT_NE(report.str().find(available ? "\"available\": true" : "\"available\": false"),
+            std::string::npos);
+  if (available and profiler.get_perfCount(Phase::densinc, PerfEvent::cycles) >= 0) {
+    ASSERT_GT(profiler.get_perfCount(Phase::densinc, PerfEvent::cycles), 0);
+  }
+}
+#endif
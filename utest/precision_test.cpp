@@ -0,0 +1,91 @@
+#include "gtest/gtest.h"
+#include "../sim/parser.hpp"
+#include "../sim/simd_kernels.hpp"
+#include "../sim/trace_file.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <sstream>
+#include <type_traits>
+
+namespace {
+  // Densities of the reference trace of the first density increase, by id
+  std::map<std::int64_t, double> referenceDensities() {
+    TraceFile const trace("trz/small/densinc-base-1.trz");
+    std::map<std::int64_t, double> densities;
+    for (int block = 0; block < trace.get_numBlocks(); block++) {
+      for (std::int64_t index = 0; index < trace.get_numParticles(block); index++) {
+        TraceParticle const particle = trace.particle(block, index);
+        densities[particle.id] = particle.fields[9];
+      }
+    }
+    return densities;
+  }
+
+  // Largest relative error of the summed density increases of the first
+  // particles of small.fld with the arrays and sums of Policy
+  template <typename Policy>
+  double densityError(std::map<std::int64_t, double> const &reference) {
+    Grid grid = readInput("small.fld");
+    initAccelerations(grid);
+    ParticleStore const &loaded = grid.get_particles();
+    BasicParticleStore<Policy> store;
+    for (int part = 0; part < loaded.size(); part++) {
+      store.addParticle(loaded.getParticle(part));
+    }
+
+    const int checked = 300;
+    double worst = 0.0;
+    for (int part = 0; part < checked; part++) {
+      simd::incDensityRowScalar(store, {part, 0, part}, grid.get_slSq(), false);
+      simd::incDensityRowScalar(store, {part, part + 1, store.size()}, grid.get_slSq(), false);
+      auto const idx = static_cast<std::size_t>(part);
+      double const expected = reference.at(store.id[idx]);
+      double const actual = store.density[idx];
+      worst = std::max(worst, std::abs(actual - expected) / (expected + 1e-20));
+    }
+    return worst;
+  }
+}  // namespace
+
+// Every policy against the reference traces; the errors are recorded so the
+// test report shows what each policy costs in accuracy
+TEST(PrecisionTest, DensityIncreaseMatchesTraceForEveryPolicy) {
+  auto const reference = referenceDensities();
+  ASSERT_EQ(reference.size(), 4800);
+
+  double const mixed = densityError<MixedPrecision>(reference);
+  double const full = densityError<DoublePrecision>(reference);
+  double const single = densityError<FloatPrecision>(reference);
+  auto const record = [](char const *key, double error) {
+    std::ostringstream value;
+    value << std::scientific << error;
+    RecordProperty(key, value.str());
+  };
+  record("mixedError", mixed);
+  record("doubleError", full);
+  record("floatError", single);
+
+  ASSERT_LT(mixed, 1e-6);
+  ASSERT_LT(full, 1e-6);
+  ASSERT_LT(single, 1e-5);
+}
+
+TEST(PrecisionTest, StoreKeepsThePolicyTypes) {
+  static_assert(std::is_same_v<BasicParticleStore<MixedPrecision>::Real, float>);
+  static_assert(std::is_same_v<BasicParticleStore<MixedPrecision>::Accumulator, double>);
+  static_assert(std::is_same_v<BasicParticleStore<FloatPrecision>::Accumulator, float>);
+
+  BasicParticleStore<DoublePrecision> store;
+  store.addParticle(Particle(7, {0.25F, -0.5F, 1.0F}, {0, 0, 0}, {0, 0, 0}));
+  store.density[0] = 1.0 / 3.0;
+  Particle const part = store.getParticle(0);
+  ASSERT_EQ(part.get_id(), 7);
+  ASSERT_EQ(part.get_py(), -0.5F);
+  ASSERT_EQ(part.get_density(), 1.0 / 3.0);
+  ASSERT_LT(BasicParticleStore<FloatPrecision>::packedBytes(64),
+            BasicParticleStore<MixedPrecision>::packedBytes(64));
+  ASSERT_LT(BasicParticleStore<MixedPrecision>::packedBytes(64),
+            BasicParticleStore<DoublePrecision>::packedBytes(64));
+}
@@ -0,0 +1,62 @@
+#include "gtest/gtest.h"
+#include "../sim/neighbour_list.hpp"
+#include "../sim/parser.hpp"
+#include "../sim/profiler.hpp"
+#include "../sim/simulation.hpp"
+
+#include <sstream>
+#include <thread>
+
+#ifdef FLUID_PROFILE
+TEST(ProfilerTest, KeepsCountersOfExitedThreads) {
+  Profiler const profiler;
+  std::thread counting([] { profile::count(Counter::wallCollisions, 3); });
+  counting.join();
+  profile::count(Counter::wallCollisions);
+  ASSERT_EQ(profiler.get_counter(Counter::wallCollisions), 4);
+}
+
+TEST(ProfilerTest, TimesEveryStage) {
+  Grid grid = readInput("small.fld");
+  Profiler profiler;
+  simulateOneStep(grid, PairMode::symmetric, ThreadPool::serial(), nullptr, &profiler);
+  for (int phase = static_cast<int>(Phase::repos); phase <= static_cast<int>(Phase::boundint);
+       phase++) {
+    ASSERT_GT(profiler.get_seconds(static_cast<Phase>(phase)), 0.0) << phase;
+  }
+  ASSERT_EQ(profiler.get_seconds(Phase::read), 0.0);
+  // The particles have not moved since they were read
+  ASSERT_EQ(profiler.get_counter(Counter::blockChanges), 0);
+  ASSERT_GT(profiler.get_counter(Counter::candidatePairs),
+            profiler.get_counter(Counter::pairsInside));
+
+  std::ostringstream report;
+  profiler.writeReport(report, grid.get_particles().size(), 1, 1);
+  ASSERT_NE(report.str().find("\"densinc\": {\"seconds\": "), std::string::npos);
+  ASSERT_NE(report.str().find("\"pairsInside\": "), std::string::npos);
+}
+
+TEST(ProfilerTest, CountsVerletRebuilds) {
+  Grid grid = readInput("small.fld");
+  NeighbourList lists(0.2 * grid.get_smoothingLength());
+  Profiler const profiler;
+  for (int step = 0; step < 3; step++) {
+    simulateOneStep(grid, lists, ThreadPool::serial(), nullptr, nullptr);
+  }
+  ASSERT_EQ(profiler.get_counter(Counter::verletRebuilds), lists.get_numRebuilds());
+  ASSERT_GE(profiler.get_counter(Counter::verletEntries), lists.get_numCandidates());
+  ASSERT_GT(lists.get_numCandidates(), 0);
+}
+
+TEST(ProfilerTest, GatherCountsEveryPairTwice) {
+  Grid grid = readInput("small.fld");
+  initAccelerations(grid);
+  Profiler const symmetric;
+  incrementDensities(grid, PairMode::symmetric);
+  std::int64_t const pairs = symmetric.get_counter(Counter::pairsInside);
+  Profiler const gather;
+  incrementDensities(grid, PairMode::gather);
+  ASSERT_GT(pairs, 0);
+  ASSERT_EQ(gather.get_counter(Counter::pairsInside), 2 * pairs);
+}
+#endif
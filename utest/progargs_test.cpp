@@ -54,3 +54,117 @@ TEST(ProgargsTest, CannotOpenOutputFile) {
 
   ASSERT_EQ(result, -4);
 }
+
+TEST(ProgargsTest, ThreadsOption) {
+  std::array<char *, 6> argv = {"fluid", "--threads", "8", "10", "small.fld", "out/test.fld"};
+  ProgramOptions options;
+
+  int const result = parseOptions(argv, options);
+
+  ASSERT_EQ(result, 0);
+  ASSERT_EQ(options.threads, 8);
+  ASSERT_EQ(options.timeSteps, 10);
+  ASSERT_EQ(options.inputFile, "small.fld");
+  ASSERT_EQ(options.outputFile, "out/test.fld");
+}
+
+TEST(ProgargsTest, ThreadsOptionWithEquals) {
+  std::array<char *, 5> argv = {"fluid", "10", "small.fld", "out/test.fld", "--threads=3"};
+  ProgramOptions options;
+
+  ASSERT_EQ(parseOptions(argv, options), 0);
+  ASSERT_EQ(options.threads, 3);
+}
+
+TEST(ProgargsTest, InvalidThreads) {
+  std::array<char *, 6> argv = {"fluid", "--threads", "0", "10", "small.fld", "out/test.fld"};
+  ProgramOptions options;
+
+  ASSERT_EQ(parseOptions(argv, options), -5);
+}
+
+TEST(ProgargsTest, UnknownOption) {
+  std::array<char *, 5> argv = {"fluid", "--fast", "10", "small.fld", "out/test.fld"};
+  ProgramOptions options;
+
+  ASSERT_EQ(parseOptions(argv, options), -5);
+}
+
+TEST(ProgargsTest, OptionsKeepPositionalChecks) {
+  std::array<char *, 4> argv = {"fluid", "--threads=2", "10", "small.fld"};
+  ProgramOptions options;
+
+  ASSERT_EQ(parseOptions(argv, options), -1);
+}
+
+TEST(ProgargsTest, DumpEveryOption) {
+  std::array<char *, 6> argv = {"fluid", "10", "small.fld", "out/test.fld", "--dump-every", "5"};
+  ProgramOptions options;
+
+  ASSERT_EQ(parseOptions(argv, options), 0);
+  ASSERT_EQ(options.dumpEvery, 5);
+}
+
+TEST(ProgargsTest, DumpFormatOption) {
+  std::array<char *, 5> argv = {"fluid", "10", "small.fld", "out/test.fld", "--dump-format=fldz"};
+  ProgramOptions options;
+
+  ASSERT_EQ(parseOptions(argv, options), 0);
+  ASSERT_EQ(options.dumpFormat, SnapshotFormat::fldz);
+
+  std::array<char *, 5> invalid = {"fluid", "10", "small.fld", "out/test.fld", "--dump-format=zip"};
+  ASSERT_EQ(parseOptions(invalid, options), -5);
+}
+
+TEST(ProgargsTest, CheckpointOptions) {
+  std::array<char *, 8> argv = {"fluid", "--checkpoint-every", "50", "--restart", "out/run.chk",
+                                "10", "small.fld", "out/test.fld"};
+  ProgramOptions options;
+
+  ASSERT_EQ(parseOptions(argv, options), 0);
+  ASSERT_EQ(options.checkpointEvery, 50);
+  ASSERT_EQ(options.restartFile, "out/run.chk");
+}
+
+TEST(ProgargsTest, TraceOptions) {
+  std::array<char *, 6> argv = {"fluid",       "--trace-stage=densinc", "--trace-steps=2..4",
+                                "10",          "small.fld",             "out/test.fld"};
+  ProgramOptions options;
+
+#ifdef FLUID_TRACE
+  ASSERT_EQ(parseOptions(argv, options), 0);
+  ASSERT_EQ(options.traceStage, "densinc");
+  ASSERT_EQ(options.traceFirstStep, 2);
+  ASSERT_EQ(options.traceLastStep, 4);
+#else
+  ASSERT_EQ(parseOptions(argv, options), -5);
+#endif
+}
+
+TEST(ProgargsTest, ProfileOption) {
+  std::array<char *, 5> argv = {"fluid", "--profile=-", "10", "small.fld", "out/test.fld"};
+  ProgramOptions options;
+
+#ifdef FLUID_PROFILE
+  ASSERT_EQ(parseOptions(argv, options), 0);
+  ASSERT_EQ(options.profileFile, "-");
+#else
+  ASSERT_EQ(parseOptions(argv, options), -5);
+#endif
+}
+
+TEST(ProgargsTest, PerfCountersNeedProfile) {
+  std::array<char *, 5> argv = {"fluid", "--perf-counters", "10", "small.fld", "out/test.fld"};
+  ProgramOptions options;
+
+  ASSERT_EQ(parseOptions(argv, options), -5);
+}
+
+TEST(ProgargsTest, ConfigOption) {
+  std::array<char *, 6> argv = {"fluid", "--config", "tank.cfg", "10", "small.fld",
+                                "out/test.fld"};
+  ProgramOptions options;
+
+  ASSERT_EQ(parseOptions(argv, options), 0);
+  ASSERT_EQ(options.configFile, "tank.cfg");
+}
@@ -0,0 +1,202 @@
+#include "gtest/gtest.h"
+#include "../sim/parser.hpp"
+#include "../sim/simd_kernels.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <random>
+
+namespace {
+  // Fill a store with count particles spread over a cube a few smoothing
+  // lengths wide
+  ParticleStore randomStore(int count, double side) {
+    std::mt19937 generator(count);
+    std::uniform_real_distribution<float> coord(0.0F, static_cast<float>(side));
+    ParticleStore store;
+    for (int i = 0; i < count; i++) {
+      store.addParticle(Particle(i, {coord(generator), coord(generator), coord(generator)},
+                                 {0, 0, 0}, {0, 0, 0}));
+      store.density[static_cast<std::size_t>(i)] = 0.0;
+    }
+    return store;
+  }
+
+  // Run every row of a store with one instruction set
+  using RowKernel = void (*)(ParticleStore &, simd::PairRow, double, bool);
+
+  void runRows(ParticleStore &store, RowKernel kernel, double slSq, bool symmetric) {
+    for (int part = 0; part < store.size(); part++) {
+      if (symmetric) {
+        kernel(store, {part, part + 1, store.size()}, slSq, true);
+      } else {
+        kernel(store, {part, 0, part}, slSq, false);
+        kernel(store, {part, part + 1, store.size()}, slSq, false);
+      }
+    }
+  }
+
+  void expectRowsMatchScalar(simd::Isa isa, RowKernel kernel) {
+    if (static_cast<int>(simd::bestIsa()) < static_cast<int>(isa)) {
+      GTEST_SKIP() << "instruction set not supported by this CPU";
+    }
+    const double slSq = 6.9e-5;
+    const int count = 203;  // not a multiple of the vector width
+    for (bool const symmetric : {false, true}) {
+      ParticleStore expected = randomStore(count, 0.03);
+      ParticleStore actual = randomStore(count, 0.03);
+      runRows(expected, simd::incDensityRowScalar, slSq, symmetric);
+      runRows(actual, kernel, slSq, symmetric);
+      for (std::size_t i = 0; i < static_cast<std::size_t>(count); i++) {
+        ASSERT_NEAR(actual.density[i], expected.density[i], 1e-5 * expected.density[i]);
+      }
+    }
+  }
+
+  // Same for the acceleration transfer rows, on a store with velocities and
+  // transformed densities
+  using AccelerationKernel = void (*)(ParticleStore &, simd::PairRow, KernelConstants const &,
+                                      bool);
+
+  ParticleStore randomFluid(int count, double side) {
+    std::mt19937 generator(count + 1);
+    std::uniform_real_distribution<float> velocity(-0.1F, 0.1F);
+    std::uniform_real_distribution<double> density(900.0, 1100.0);
+    ParticleStore store = randomStore(count, side);
+    for (std::size_t i = 0; i < static_cast<std::size_t>(count); i++) {
+      store.vx[i] = velocity(generator);
+      store.vy[i] = velocity(generator);
+      store.vz[i] = velocity(generator);
+      store.density[i] = density(generator);
+    }
+    return store;
+  }
+
+  void expectAccelerationRowsMatchScalar(simd::Isa isa, AccelerationKernel kernel) {
+    if (static_cast<int>(simd::bestIsa()) < static_cast<int>(isa)) {
+      GTEST_SKIP() << "instruction set not supported by this CPU";
+    }
+    const double smoothingLength = 8.3e-3;
+    KernelConstants const constants{smoothingLength, smoothingLength * smoothingLength,
+                                    std::pow(smoothingLength, 6), 1.0, 1.2e9, 2.4e6};
+    const int count = 203;
+    for (bool const symmetric : {false, true}) {
+      ParticleStore expected = randomFluid(count, 0.03);
+      ParticleStore actual = randomFluid(count, 0.03);
+      for (int part = 0; part < count; part++) {
+        if (symmetric) {
+          simd::transferAccelerationRowScalar(expected, {part, part + 1, count}, constants, true);
+          kernel(actual, {part, part + 1, count}, constants, true);
+        } else {
+          for (simd::PairRow const row : {simd::PairRow{part, 0, part},
+                                          simd::PairRow{part, part + 1, count}}) {
+            simd::transferAccelerationRowScalar(expected, row, constants, false);
+            kernel(actual, row, constants, false);
+          }
+        }
+      }
+      for (std::size_t i = 0; i < static_cast<std::size_t>(count); i++) {
+        ASSERT_NEAR(actual.ax[i], expected.ax[i], 1e-9 * (std::abs(expected.ax[i]) + 1.0));
+        ASSERT_NEAR(actual.ay[i], expected.ay[i], 1e-9 * (std::abs(expected.ay[i]) + 1.0));
+        ASSERT_NEAR(actual.az[i], expected.az[i], 1e-9 * (std::abs(expected.az[i]) + 1.0));
+      }
+    }
+  }
+
+  // Fields of every particle of a .trz trace, by particle id: position, hv,
+  // velocity, density and acceleration
+  std::map<std::int64_t, std::array<double, 13>> readTrace(std::string const &tracefile) {
+    std::ifstream trace(tracefile, std::ios::binary);
+    std::int32_t numBlocks = 0;
+    trace.read(reinterpret_cast<char *>(&numBlocks), sizeof(numBlocks));
+    std::map<std::int64_t, std::array<double, 13>> particles;
+    for (int block = 0; block < numBlocks; block++) {
+      std::int64_t numParticles = 0;
+      trace.read(reinterpret_cast<char *>(&numParticles), sizeof(numParticles));
+      for (std::int64_t i = 0; i < numParticles; i++) {
+        std::int64_t id = 0;
+        std::array<double, 13> fields{};
+        trace.read(reinterpret_cast<char *>(&id), sizeof(id));
+        trace.read(reinterpret_cast<char *>(fields.data()), sizeof(fields));
+        particles[id] = fields;
+      }
+    }
+    return particles;
+  }
+}  // namespace
+
+TEST(SimdKernelsTest, Avx2DensityRowMatchesScalar) {
+  expectRowsMatchScalar(simd::Isa::avx2, simd::incDensityRowAvx2);
+}
+
+TEST(SimdKernelsTest, Avx512DensityRowMatchesScalar) {
+  expectRowsMatchScalar(simd::Isa::avx512, simd::incDensityRowAvx512);
+}
+
+TEST(SimdKernelsTest, Avx2AccelerationRowMatchesScalar) {
+  expectAccelerationRowsMatchScalar(simd::Isa::avx2, simd::transferAccelerationRowAvx2);
+}
+
+TEST(SimdKernelsTest, Avx512AccelerationRowMatchesScalar) {
+  expectAccelerationRowsMatchScalar(simd::Isa::avx512, simd::transferAccelerationRowAvx512);
+}
+
+TEST(SimdKernelsTest, SetIsaIsLimitedToCpu) {
+  simd::Isa const previous = simd::activeIsa();
+  ASSERT_EQ(simd::setIsa(simd::Isa::scalar), simd::Isa::scalar);
+  ASSERT_EQ(simd::setIsa(simd::Isa::avx512), simd::bestIsa());
+  simd::setIsa(previous);
+}
+
+TEST(SimdKernelsTest, DensityIncreaseMatchesTrace) {
+  auto const reference = readTrace("trz/small/densinc-base-1.trz");
+  ASSERT_EQ(reference.size(), 4800);
+
+  for (simd::Isa const isa : {simd::Isa::scalar, simd::Isa::avx2, simd::Isa::avx512}) {
+    simd::Isa const previous = simd::setIsa(isa);
+    for (PairMode const mode : {PairMode::gather, PairMode::symmetric}) {
+      Grid grid = readInput("small.fld");
+      initAccelerations(grid);
+      incrementDensities(grid, mode);
+
+      ParticleStore const &store = grid.get_particles();
+      for (std::size_t i = 0; i < static_cast<std::size_t>(store.size()); i++) {
+        auto const found = reference.find(store.id[i]);
+        if (found == reference.end()) { continue; }
+        double const density = found->second[9];
+        ASSERT_NEAR(store.density[i], density, 1e-6 * density + 1e-20) << "particle " << store.id[i];
+      }
+    }
+    simd::setIsa(previous);
+  }
+}
+
+TEST(SimdKernelsTest, AccelerationTransferMatchesTrace) {
+  auto const reference = readTrace("trz/small/acctransf-base-1.trz");
+  ASSERT_EQ(reference.size(), 4800);
+
+  for (simd::Isa const isa : {simd::Isa::scalar, simd::Isa::avx2, simd::Isa::avx512}) {
+    simd::Isa const previous = simd::setIsa(isa);
+    for (PairMode const mode : {PairMode::gather, PairMode::symmetric}) {
+      Grid grid = readInput("small.fld");
+      initAccelerations(grid);
+      incrementDensities(grid, mode);
+      transformDensities(grid);
+      transferAccelerations(grid, mode);
+
+      ParticleStore const &store = grid.get_particles();
+      for (std::size_t i = 0; i < static_cast<std::size_t>(store.size()); i++) {
+        auto const found = reference.find(store.id[i]);
+        if (found == reference.end()) { continue; }
+        std::array<double, 3> const acceleration = {store.ax[i], store.ay[i], store.az[i]};
+        for (std::size_t axis = 0; axis < 3; axis++) {
+          double const expected = found->second[10 + axis];
+          ASSERT_NEAR(acceleration[axis], expected, 1e-4 * (std::abs(expected) + 1.0))
+              << "particle " << store.id[i] << " axis " << axis;
+        }
+      }
+    }
+    simd::setIsa(previous);
+  }
+}
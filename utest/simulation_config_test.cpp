@@ -0,0 +1,72 @@
+#include "gtest/gtest.h"
+#include "../sim/parser.hpp"
+#include "../sim/simulation_config.hpp"
+
+#include <filesystem>
+#include <fstream>
+
+namespace {
+  // Write text to a configuration file in the temporary directory
+  std::string writeConfig(std::string const &text) {
+    std::string const filename =
+        (std::filesystem::temp_directory_path() / "simulation_config_test.cfg").string();
+    std::ofstream(filename) << text;
+    return filename;
+  }
+}  // namespace
+
+TEST(SimulationConfigTest, ReadsSettingsAndKeepsDefaults) {
+  SimulationConfig const config = readConfig(writeConfig("# wider tank\n"
+                                                         "timeStep = 5e-4\n"
+                                                         "\n"
+                                                         "boxUpperBound = 0.1 0.1 0.065  # x\n"
+                                                         "  damping=64\n"));
+  ASSERT_EQ(config.timeStep, 5e-4);
+  ASSERT_EQ(config.damping, 64.0);
+  ASSERT_EQ(config.boxUpperBound, (std::array<double, 3>{0.1, 0.1, 0.065}));
+  ASSERT_EQ(config.boxLowerBound, Constants::boxLowerBound);
+  ASSERT_EQ(config.viscosity, Constants::viscosity);
+  ASSERT_FALSE(config == defaultConfig);
+  ASSERT_EQ(readConfig(writeConfig("# nothing\n")), defaultConfig);
+}
+
+TEST(SimulationConfigTest, RejectsBadSettings) {
+  for (auto const *text : {"gravity = 1\n", "timeStep = fast\n", "timeStep 1e-3\n",
+                           "boxLowerBound = 0 0\n", "timeStep = 1e-3 2\n", "timeStep = 0\n",
+                           "boxLowerBound = 0.1 -0.08 -0.065\n"}) {
+    ASSERT_THROW(static_cast<void>(readConfig(writeConfig(text))), std::runtime_error) << text;
+  }
+  ASSERT_THROW(static_cast<void>(readConfig("missing.cfg")), std::runtime_error);
+}
+
+TEST(SimulationConfigTest, GridUsesTheTank) {
+  SimulationConfig config;
+  config.boxUpperBound[0] = 0.2;
+  Grid const grid(204, 4800, config);
+  Grid const standard(204, 4800);
+  ASSERT_GT(grid.get_numberX(), standard.get_numberX());
+  ASSERT_EQ(grid.get_numberY(), standard.get_numberY());
+  ASSERT_EQ(grid.get_config(), config);
+}
+
+// The kernels give the same particles whether the default configuration is
+// folded in or read at run time
+TEST(SimulationConfigTest, RuntimeSourceMatchesDefaultSource) {
+  Grid grid = readInput("small.fld");
+  simulateOneStep(grid, PairMode::symmetric);
+  ParticleStore folded = grid.get_particles();
+  ParticleStore loaded = grid.get_particles();
+  RuntimeConfigSource const source{&defaultConfig};
+  for (int part = 0; part < folded.size(); part++) {
+    Block::boxCollisions(folded, part);
+    Block::particleMotion(folded, part);
+    Block::boundaryCollisions(folded, part);
+    Block::boxCollisions(loaded, part, source);
+    Block::particleMotion(loaded, part, source);
+    Block::boundaryCollisions(loaded, part, source);
+  }
+  ASSERT_EQ(folded.px, loaded.px);
+  ASSERT_EQ(folded.hvy, loaded.hvy);
+  ASSERT_EQ(folded.vz, loaded.vz);
+  ASSERT_EQ(folded.ax, loaded.ax);
+}
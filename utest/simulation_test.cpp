@@ -0,0 +1,74 @@
+#include "gtest/gtest.h"
+#include "../sim/parser.hpp"
+#include "../sim/simulation.hpp"
+#include "../sim/trace_file.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+TEST(SimulationTest, ColoursCoverEveryRowOnce) {
+  Grid const grid(204, 0);
+  std::vector<int> visits(static_cast<std::size_t>(grid.get_numBlocks()), 0);
+  for (int colour = 0; colour < Grid::numColours; colour++) {
+    for (auto const rowStart : grid.get_colourRows(colour)) {
+      auto const coords = grid.blockCoordinates(rowStart);
+      // Rows start at x = 0 and have the colour of their y and z
+      ASSERT_EQ(coords[0], 0);
+      ASSERT_EQ(coords[1] % 3 + 3 * (coords[2] % 2), colour);
+      for (int block = rowStart; block < rowStart + grid.get_numberX(); block++) {
+        visits[static_cast<std::size_t>(block)]++;
+      }
+    }
+  }
+  for (auto const visit : visits) { ASSERT_EQ(visit, 1); }
+}
+
+TEST(SimulationTest, ResultDoesNotDependOnThreads) {
+  for (PairMode const mode : {PairMode::gather, PairMode::symmetric}) {
+    Grid serial = readInput("small.fld");
+    Grid parallel = readInput("small.fld");
+    ThreadPool pool(4);
+    for (int step = 0; step < 2; step++) {
+      simulateOneStep(serial, mode);
+      simulateOneStep(parallel, mode, pool);
+    }
+
+    // Both runs visit the same pairs in the same order, so they match exactly
+    ParticleStore const &expected = serial.get_particles();
+    ParticleStore const &actual = parallel.get_particles();
+    ASSERT_EQ(actual.size(), expected.size());
+    for (std::size_t i = 0; i < static_cast<std::size_t>(expected.size()); i++) {
+      ASSERT_EQ(actual.id[i], expected.id[i]);
+      ASSERT_EQ(actual.px[i], expected.px[i]);
+      ASSERT_EQ(actual.py[i], expected.py[i]);
+      ASSERT_EQ(actual.pz[i], expected.pz[i]);
+      ASSERT_EQ(actual.density[i], expected.density[i]);
+      ASSERT_EQ(actual.ax[i], expected.ax[i]);
+    }
+  }
+}
+
+TEST(SimulationTest, WallsOnlyActOnBoundaryBlocks) {
+  // In the second step of small.fld particles of inner blocks move past the
+  // walls; the reference only bounces those of blocks on the faces
+  Grid grid = readInput("small.fld");
+  for (int step = 0; step < 2; step++) { simulateOneStep(grid); }
+
+  TraceFile const reference("trz/small/boundint-base-2.trz");
+  std::map<std::int64_t, std::array<double, 3>> positions;
+  for (int block = 0; block < reference.get_numBlocks(); block++) {
+    for (std::int64_t index = 0; index < reference.get_numParticles(block); index++) {
+      TraceParticle const particle = reference.particle(block, index);
+      positions[particle.id] = {particle.fields[0], particle.fields[1], particle.fields[2]};
+    }
+  }
+  ParticleStore const &store = grid.get_particles();
+  double worst = 0.0;
+  for (std::size_t i = 0; i < static_cast<std::size_t>(store.size()); i++) {
+    auto const &expected = positions.at(store.id[i]);
+    worst = std::max({worst, std::abs(store.px[i] - expected[0]),
+                      std::abs(store.py[i] - expected[1]), std::abs(store.pz[i] - expected[2])});
+  }
+  ASSERT_LT(worst, 1e-5);
+}
@@ -0,0 +1,87 @@
+#include "gtest/gtest.h"
+#include "../sim/parser.hpp"
+#include "../sim/snapshot_archive.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+
+namespace {
+  std::string tempFile(std::string const &name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+  }
+
+  // Value of field of the record of particle id in an .fld buffer
+  float fieldOf(std::vector<std::byte> const &fld, std::size_t id, std::size_t field) {
+    float value = 0;
+    std::memcpy(&value, &fld[8 + id * 36 + field * sizeof(float)], sizeof(value));
+    return value;
+  }
+
+  // The first frames of small.fld, one step apart
+  std::vector<std::vector<std::byte>> smallFrames(int count) {
+    Grid grid = readInput("small.fld");
+    std::vector<std::vector<std::byte>> frames;
+    for (int frame = 0; frame < count; frame++) {
+      frames.emplace_back();
+      encodeOutput(grid, frames.back());
+      simulateOneStep(grid);
+    }
+    return frames;
+  }
+}  // namespace
+
+TEST(SnapshotArchiveTest, FramesDecodeWithinQuantization) {
+  ArchiveParameters parameters;
+  parameters.keyInterval = 2;
+  auto const frames = smallFrames(3);
+  std::string const filename = tempFile("archive_test.fldz");
+  {
+    ArchiveWriter writer(filename, parameters);
+    for (std::size_t frame = 0; frame < frames.size(); frame++) {
+      writer.append(frames[frame], static_cast<int>(frame) * 10);
+    }
+    writer.close();
+  }
+
+  ArchiveReader const archive(filename);
+  ASSERT_EQ(archive.get_numFrames(), 3);
+  ASSERT_EQ(archive.get_step(1), 10);
+  auto const &upper = Constants::boxUpperBound;
+  auto const &lower = Constants::boxLowerBound;
+  // Decode out of order, so frame 1 is rebuilt from key frame 0
+  std::vector<std::byte> fld;
+  for (std::size_t const frame : {2U, 1U, 0U}) {
+    archive.decodeFrame(static_cast<int>(frame), fld);
+    ASSERT_EQ(fld.size(), frames[frame].size());
+    ASSERT_EQ(std::memcmp(fld.data(), frames[frame].data(), 8), 0);
+    for (std::size_t id = 0; id < 4800; id++) {
+      for (std::size_t field = 0; field < 9; field++) {
+        double const tolerance = field < 3
+                                     ? (upper[field] - lower[field]) / 4095.0
+                                     : parameters.velocityStep * 0.51;
+        float const expected = fieldOf(frames[frame], id, field);
+        float const actual = fieldOf(fld, id, field);
+        ASSERT_NEAR(actual, std::clamp<double>(expected, field < 3 ? lower[field] : -1e12,
+                                               field < 3 ? upper[field] : 1e12),
+                    tolerance)
+            << "frame " << frame << " particle " << id << " field " << field;
+      }
+    }
+  }
+  std::filesystem::remove(filename);
+}
+
+TEST(SnapshotArchiveTest, KeyFrameIsFiveTimesSmaller) {
+  auto const frames = smallFrames(1);
+  std::string const filename = tempFile("archive_size_test.fldz");
+  ArchiveWriter writer(filename);
+  writer.append(frames[0], 0);
+  writer.close();
+  ASSERT_GE(writer.get_inputBytes(), 5 * writer.get_outputBytes());
+  std::filesystem::remove(filename);
+}
+
+TEST(SnapshotArchiveTest, RejectsOtherFiles) {
+  ASSERT_THROW(ArchiveReader("small.fld"), std::runtime_error);
+}
@@ -0,0 +1,69 @@
+#include "gtest/gtest.h"
+#include "../sim/parser.hpp"
+#include "../sim/snapshot_writer.hpp"
+
+#include <filesystem>
+
+namespace {
+  std::string tempFile(std::string const &name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+  }
+
+  std::vector<std::byte> fileBytes(std::string const &filename) {
+    MappedFile const file(filename);
+    return {file.bytes().begin(), file.bytes().end()};
+  }
+}  // namespace
+
+TEST(SnapshotWriterTest, FrameName) {
+  ASSERT_EQ(SnapshotWriter::frameName("out/final.fld", 20), "out/final-20.fld");
+  ASSERT_EQ(SnapshotWriter::frameName("final.fld", 3), "final-3.fld");
+  ASSERT_EQ(SnapshotWriter::archiveName("out/final.fld"), "out/final.fldz");
+}
+
+TEST(SnapshotWriterTest, FramesHoldTheStateWhenSubmitted) {
+  Grid grid = readInput("small.fld");
+  std::vector<std::vector<std::byte>> expected;
+  SnapshotWriter writer(tempFile("snapshot_test.fld"));
+  // More frames than buffers, so some submits wait for the writer
+  int const numFrames = 5;
+  for (int frame = 0; frame < numFrames; frame++) {
+    simulateOneStep(grid);
+    expected.emplace_back();
+    encodeOutput(grid, expected.back());
+    writer.submit(grid, frame);
+  }
+  writer.finish();
+  ASSERT_EQ(writer.get_framesWritten(), numFrames);
+
+  for (int frame = 0; frame < numFrames; frame++) {
+    std::string const filename = tempFile("snapshot_test-" + std::to_string(frame) + ".fld");
+    ASSERT_EQ(fileBytes(filename), expected[static_cast<std::size_t>(frame)]) << "frame " << frame;
+    std::filesystem::remove(filename);
+  }
+}
+
+TEST(SnapshotWriterTest, FinishReportsWriteErrors) {
+  Grid const grid = readInput("small.fld");
+  SnapshotWriter writer(tempFile("no-such-directory/frame.fld"));
+  writer.submit(grid, 1);
+  ASSERT_THROW(writer.finish(), std::system_error);
+  ASSERT_EQ(writer.get_framesWritten(), 0);
+}
+
+TEST(SnapshotWriterTest, ArchiveHoldsEveryFrame) {
+  Grid grid = readInput("small.fld");
+  std::string const output = tempFile("snapshot_archive_test.fld");
+  {
+    SnapshotWriter writer(output, SnapshotFormat::fldz);
+    for (int step = 1; step <= 3; step++) {
+      simulateOneStep(grid);
+      writer.submit(grid, step);
+    }
+    writer.finish();
+  }
+  ArchiveReader const archive(SnapshotWriter::archiveName(output));
+  ASSERT_EQ(archive.get_numFrames(), 3);
+  ASSERT_EQ(archive.get_step(2), 3);
+  std::filesystem::remove(SnapshotWriter::archiveName(output));
+}
@@ -0,0 +1,86 @@
+#include "gtest/gtest.h"
+#include "../sim/parser.hpp"
+#include "../sim/stage_tracer.hpp"
+#include "../sim/trace_file.hpp"
+
+#include <filesystem>
+#include <type_traits>
+
+TEST(StageTracerTest, ParseStepRange) {
+  int first = 0;
+  int last = 0;
+  ASSERT_TRUE(parseStepRange("2..5", first, last));
+  ASSERT_EQ(first, 2);
+  ASSERT_EQ(last, 5);
+  ASSERT_TRUE(parseStepRange("3", first, last));
+  ASSERT_EQ(first, 3);
+  ASSERT_EQ(last, 3);
+  ASSERT_FALSE(parseStepRange("5..2", first, last));
+  ASSERT_FALSE(parseStepRange("0..2", first, last));
+  ASSERT_FALSE(parseStepRange("1..", first, last));
+  ASSERT_FALSE(parseStepRange("a..b", first, last));
+}
+
+TEST(StageTracerTest, ParseTraceStage) {
+  TraceStage stage{};
+  ASSERT_TRUE(parseTraceStage("acctransf", stage));
+  ASSERT_EQ(stage, TraceStage::acctransf);
+  ASSERT_FALSE(parseTraceStage("all", stage));
+}
+
+#ifdef FLUID_TRACE
+TEST(StageTracerTest, TracesMatchTheReference) {
+  // Repositioning and initial accelerations are exact, so their traces must
+  // match the reference bit for bit. With float sums every value is rounded
+  // to 24 of the 53 bits of a double: within 2^29 units in the last place,
+  // and a sum of such values within a few times that
+  bool const floatSums = std::is_same_v<ParticleStore::Accumulator, float>;
+  std::int64_t const floatUlps = floatSums ? std::int64_t{1} << 32 : 0;
+  std::filesystem::path const directory =
+      std::filesystem::temp_directory_path() / "stage_tracer_test";
+  std::filesystem::create_directories(directory);
+  Grid grid = readInput("small.fld");
+  StageTracer tracer(directory.string(), std::nullopt, 1, 1);
+  for (int step = 1; step <= 2; step++) {
+    tracer.set_step(step);
+    simulateOneStep(grid, PairMode::symmetric, ThreadPool::serial(), &tracer);
+  }
+  tracer.finish();
+  ASSERT_EQ(tracer.get_tracesWritten(), 8);
+  ASSERT_FALSE(std::filesystem::exists(directory / traceName("repos", 2)));
+
+  for (auto const stage : {"repos", "initacc"}) {
+    TraceFile const expected("trz/small/" + traceName(stage, 1));
+    TraceFile const actual((directory / traceName(stage, 1)).string());
+    ASSERT_FALSE(compareTraces(expected, actual, {0.0, floatUlps}).has_value()) << stage;
+  }
+  // Densities (about 1e-12) are summed in another order than the reference
+  TraceFile const expected("trz/small/" + traceName("densinc", 1));
+  TraceFile const actual((directory / traceName("densinc", 1)).string());
+  ASSERT_FALSE(compareTraces(expected, actual, {1e-19, floatUlps}).has_value());
+  std::filesystem::remove_all(directory);
+}
+
+TEST(StageTracerTest, RepositioningTraceOfStepTwoMatchesTheReference) {
+  // The densities and accelerations of a repositioning trace are those a
+  // step starts from, not the ones left from the last step. Positions and
+  // velocities stored in float are within a few float ulps of the reference
+  double const absolute = std::is_same_v<ParticleStore::Real, float> ? 1e-5 : 1e-9;
+  std::filesystem::path const directory =
+      std::filesystem::temp_directory_path() / "stage_tracer_repos_test";
+  std::filesystem::create_directories(directory);
+  Grid grid = readInput("small.fld");
+  StageTracer tracer(directory.string(), TraceStage::repos, 2, 2);
+  for (int step = 1; step <= 2; step++) {
+    tracer.set_step(step);
+    simulateOneStep(grid, PairMode::symmetric, ThreadPool::serial(), &tracer);
+  }
+  tracer.finish();
+  ASSERT_EQ(tracer.get_tracesWritten(), 1);
+
+  TraceFile const expected("trz/small/" + traceName("repos", 2));
+  TraceFile const actual((directory / traceName("repos", 2)).string());
+  ASSERT_FALSE(compareTraces(expected, actual, {absolute, 4}).has_value());
+  std::filesystem::remove_all(directory);
+}
+#endif
@@ -0,0 +1,93 @@
+#include "gtest/gtest.h"
+#include "../sim/thread_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+TEST(ThreadPoolTest, EveryIndexRunsOnce) {
+  ThreadPool pool(4);
+  ASSERT_EQ(pool.size(), 4);
+
+  // Check that the ranges cover [0, count) exactly once, for counts smaller
+  // and larger than the number of threads
+  for (int const count : {0, 1, 3, 4, 1001}) {
+    std::vector<std::atomic<int>> visits(static_cast<std::size_t>(count));
+    pool.parallelFor(count, [&visits](int begin, int end) {
+      for (int index = begin; index < end; index++) { visits[static_cast<std::size_t>(index)]++; }
+    });
+    for (auto const &visit : visits) { ASSERT_EQ(visit, 1); }
+  }
+}
+
+TEST(ThreadPoolTest, ParallelForIsABarrier) {
+  ThreadPool pool(3);
+  std::atomic<int> total = 0;
+
+  // Check that every task of a call is done when the call returns
+  for (int round = 1; round <= 50; round++) {
+    pool.parallelFor(30, [&total](int begin, int end) { total += end - begin; });
+    ASSERT_EQ(total, 30 * round);
+  }
+}
+
+TEST(ThreadPoolTest, SerialPoolRunsInline) {
+  ASSERT_EQ(ThreadPool::serial().size(), 1);
+  int calls = 0;
+  ThreadPool::serial().parallelFor(10, [&calls](int begin, int end) {
+    calls++;
+    ASSERT_EQ(begin, 0);
+    ASSERT_EQ(end, 10);
+  });
+  ASSERT_EQ(calls, 1);
+}
+
+TEST(ThreadPoolTest, WeightedChunksCoverEveryIndexOnce) {
+  ThreadPool pool(3);
+  std::vector<std::atomic<int>> visits(500);
+
+  // Check that uneven weights still give each index to exactly one chunk
+  pool.parallelFor(
+      500,
+      [&visits](int begin, int end) {
+        for (int index = begin; index < end; index++) { visits[static_cast<std::size_t>(index)]++; }
+      },
+      [](int index) { return index < 50 ? 1000 : 1; });
+  for (auto const &visit : visits) { ASSERT_EQ(visit, 1); }
+}
+
+TEST(ThreadPoolTest, IdleWorkersStealFromBusyOnes) {
+  ThreadPool pool(4);
+  pool.resetStats();
+
+  // The first chunk belongs to the calling thread and takes much longer than
+  // the rest, so the other workers end up running the rest of its chunks
+  pool.parallelFor(64, [](int begin, int /*end*/) {
+    if (begin == 0) { std::this_thread::sleep_for(std::chrono::milliseconds(50)); }
+  });
+
+  auto const stats = pool.get_stats();
+  ASSERT_EQ(stats.size(), 4);
+  std::int64_t tasksRun = 0;
+  std::int64_t tasksStolen = 0;
+  for (auto const &worker : stats) {
+    tasksRun += worker.tasksRun;
+    tasksStolen += worker.tasksStolen;
+    ASSERT_GE(worker.idleSeconds, 0.0);
+  }
+  ASSERT_EQ(tasksRun, 32);
+  ASSERT_GT(tasksStolen, 0);
+}
+
+TEST(ThreadPoolTest, ThreadIdsAreDistinct) {
+  ThreadPool pool(3);
+  std::vector<int> ids = pool.get_threadIds();
+  ASSERT_EQ(ids.size(), 3);
+  ASSERT_EQ(ids[0], static_cast<int>(gettid()));
+  std::sort(ids.begin(), ids.end());
+  ASSERT_EQ(std::unique(ids.begin(), ids.end()), ids.end());
+}
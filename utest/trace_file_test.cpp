@@ -0,0 +1,93 @@
+#include "gtest/gtest.h"
+#include "../sim/trace_file.hpp"
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+
+namespace {
+  // Offset of az, the last field, of the last particle of a trace
+  std::streamoff lastFieldOffset(std::string const &trace) {
+    std::ifstream file(trace, std::ios::binary);
+    std::int32_t numBlocks = 0;
+    file.read(reinterpret_cast<char *>(&numBlocks), sizeof(numBlocks));
+    std::streamoff offset = sizeof(numBlocks);
+    std::streamoff last = -1;
+    for (int block = 0; block < numBlocks; block++) {
+      std::int64_t count = 0;
+      file.seekg(offset);
+      file.read(reinterpret_cast<char *>(&count), sizeof(count));
+      offset += static_cast<std::streamoff>(sizeof(count) + count * 112);
+      if (count > 0) { last = offset - static_cast<std::streamoff>(sizeof(double)); }
+    }
+    return last;
+  }
+
+  // Copy of a trace with the last field of the last particle set to value
+  std::string withLastField(std::string const &trace, double value) {
+    std::string const filename =
+        (std::filesystem::temp_directory_path() / "trace_file_test.trz").string();
+    std::filesystem::copy_file(trace, filename, std::filesystem::copy_options::overwrite_existing);
+    std::fstream file(filename, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(lastFieldOffset(trace));
+    file.write(reinterpret_cast<char const *>(&value), sizeof(value));
+    return filename;
+  }
+
+  double lastField(std::string const &trace) {
+    std::ifstream file(trace, std::ios::binary);
+    file.seekg(lastFieldOffset(trace));
+    double value = 0;
+    file.read(reinterpret_cast<char *>(&value), sizeof(value));
+    return value;
+  }
+}  // namespace
+
+TEST(TraceFileTest, ReadsEveryBlock) {
+  TraceFile const trace("trz/small/densinc-base-1.trz");
+  ASSERT_EQ(trace.get_numBlocks(), 15 * 21 * 15);
+  std::int64_t total = 0;
+  for (int block = 0; block < trace.get_numBlocks(); block++) {
+    total += trace.get_numParticles(block);
+  }
+  ASSERT_EQ(total, 4800);
+}
+
+TEST(TraceFileTest, TraceMatchesItself) {
+  TraceFile const trace("trz/small/acctransf-base-1.trz");
+  ASSERT_FALSE(compareTraces(trace, trace, {}).has_value());
+}
+
+TEST(TraceFileTest, ReportsTheDivergentField) {
+  std::string const reference = "trz/small/acctransf-base-1.trz";
+  double const original = lastField(reference);
+  TraceFile const expected(reference);
+
+  // One ulp away passes with a tolerance of one ulp only
+  std::string const nearby = withLastField(reference, std::nextafter(original, 1e300));
+  {
+    TraceFile const actual(nearby);
+    ASSERT_TRUE(compareTraces(expected, actual, {0.0, 0}).has_value());
+    ASSERT_FALSE(compareTraces(expected, actual, {0.0, 1}).has_value());
+  }
+
+  std::string const changed = withLastField(reference, original + 1.0);
+  TraceFile const actual(changed);
+  auto const mismatch = compareTraces(expected, actual, {1e-3, 4});
+  ASSERT_TRUE(mismatch.has_value());
+  ASSERT_EQ(mismatch->kind, TraceMismatch::Kind::field);
+  ASSERT_EQ(traceFieldNames.at(static_cast<std::size_t>(mismatch->field)), "az");
+  ASSERT_EQ(mismatch->expected, original);
+  ASSERT_FALSE(compareTraces(expected, actual, {1.5, 0}).has_value());
+  std::filesystem::remove(changed);
+}
+
+TEST(TraceFileTest, UlpDistance) {
+  ASSERT_EQ(ulpDistance(1.0, 1.0), 0);
+  ASSERT_EQ(ulpDistance(1.0, std::nextafter(1.0, 2.0)), 1);
+  ASSERT_EQ(ulpDistance(-0.0, 0.0), 0);
+  double const tiny = std::numeric_limits<double>::denorm_min();
+  ASSERT_EQ(ulpDistance(-tiny, tiny), 2);
+  ASSERT_EQ(ulpDistance(-1.0, 1.0), ulpDistance(1.0, -1.0));
+}